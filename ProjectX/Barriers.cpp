@@ -0,0 +1,160 @@
+#include "Barriers.hpp"
+
+#include <atomic>
+
+namespace
+{
+	std::atomic<uint32_t> s_Barriers{ 0 };
+	std::atomic<uint32_t> s_Flushes{ 0 };
+	vk::BarrierBatch::FrameStats s_LastFrame;
+
+	bool SameLayers(const VkImageSubresourceRange& a, const VkImageSubresourceRange& b)
+	{
+		return a.aspectMask == b.aspectMask && a.baseArrayLayer == b.baseArrayLayer && a.layerCount == b.layerCount;
+	}
+
+	bool SameMips(const VkImageSubresourceRange& a, const VkImageSubresourceRange& b)
+	{
+		return a.baseMipLevel == b.baseMipLevel && a.levelCount == b.levelCount;
+	}
+
+	bool SameDependency(const VkImageMemoryBarrier2& a, const VkImageMemoryBarrier2& b)
+	{
+		return a.oldLayout == b.oldLayout && a.newLayout == b.newLayout &&
+			a.srcStageMask == b.srcStageMask && a.srcAccessMask == b.srcAccessMask &&
+			a.dstStageMask == b.dstStageMask && a.dstAccessMask == b.dstAccessMask;
+	}
+}
+
+vk::BarrierBatch& vk::BarrierBatch::Image(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+	VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+	VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess,
+	VkImageSubresourceRange range)
+{
+	VkImageMemoryBarrier2 barrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+	barrier.srcStageMask = srcStages;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstStageMask = dstStages;
+	barrier.dstAccessMask = dstAccess;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange = range;
+
+	for (auto& pending : m_ImageBarriers)
+	{
+		if (pending.image != image || !SameLayers(pending.subresourceRange, range))
+			continue;
+
+		if (SameMips(pending.subresourceRange, range))
+		{
+			// Same transition asked for twice, one barrier covering both dependencies
+			if (pending.oldLayout == oldLayout && pending.newLayout == newLayout)
+			{
+				pending.srcStageMask |= srcStages;
+				pending.srcAccessMask |= srcAccess;
+				pending.dstStageMask |= dstStages;
+				pending.dstAccessMask |= dstAccess;
+				return *this;
+			}
+
+			// Nothing is recorded between the two, so A -> B followed by B -> C is just A -> C.
+			// The second barrier's source scope is kept so the work it waits on stays covered.
+			if (pending.newLayout == oldLayout)
+			{
+				pending.newLayout = newLayout;
+				pending.srcStageMask |= srcStages;
+				pending.srcAccessMask |= srcAccess;
+				pending.dstStageMask = dstStages;
+				pending.dstAccessMask = dstAccess;
+				return *this;
+			}
+		}
+
+		// Neighbouring mip levels with the identical transition become one wider range
+		const VkImageSubresourceRange& mips = pending.subresourceRange;
+		if (mips.levelCount != VK_REMAINING_MIP_LEVELS && range.levelCount != VK_REMAINING_MIP_LEVELS && SameDependency(pending, barrier))
+		{
+			if (mips.baseMipLevel + mips.levelCount == range.baseMipLevel)
+			{
+				pending.subresourceRange.levelCount += range.levelCount;
+				return *this;
+			}
+
+			if (range.baseMipLevel + range.levelCount == mips.baseMipLevel)
+			{
+				pending.subresourceRange.baseMipLevel = range.baseMipLevel;
+				pending.subresourceRange.levelCount += range.levelCount;
+				return *this;
+			}
+		}
+	}
+
+	m_ImageBarriers.push_back(barrier);
+	return *this;
+}
+
+vk::BarrierBatch& vk::BarrierBatch::Buffer(VkBuffer buffer,
+	VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+	VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess,
+	VkDeviceSize offset, VkDeviceSize size)
+{
+	for (auto& pending : m_BufferBarriers)
+	{
+		if (pending.buffer == buffer && pending.offset == offset && pending.size == size)
+		{
+			pending.srcStageMask |= srcStages;
+			pending.srcAccessMask |= srcAccess;
+			pending.dstStageMask |= dstStages;
+			pending.dstAccessMask |= dstAccess;
+			return *this;
+		}
+	}
+
+	VkBufferMemoryBarrier2 barrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2 };
+	barrier.srcStageMask = srcStages;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstStageMask = dstStages;
+	barrier.dstAccessMask = dstAccess;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = buffer;
+	barrier.offset = offset;
+	barrier.size = size;
+
+	m_BufferBarriers.push_back(barrier);
+	return *this;
+}
+
+void vk::BarrierBatch::Flush(VkCommandBuffer cmd)
+{
+	if (IsEmpty())
+		return;
+
+	VkDependencyInfo dependency = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+	dependency.bufferMemoryBarrierCount = static_cast<uint32_t>(m_BufferBarriers.size());
+	dependency.pBufferMemoryBarriers = m_BufferBarriers.data();
+	dependency.imageMemoryBarrierCount = static_cast<uint32_t>(m_ImageBarriers.size());
+	dependency.pImageMemoryBarriers = m_ImageBarriers.data();
+
+	vkCmdPipelineBarrier2(cmd, &dependency);
+
+	s_Barriers.fetch_add(static_cast<uint32_t>(m_ImageBarriers.size() + m_BufferBarriers.size()), std::memory_order_relaxed);
+	s_Flushes.fetch_add(1, std::memory_order_relaxed);
+
+	m_ImageBarriers.clear();
+	m_BufferBarriers.clear();
+}
+
+void vk::BarrierBatch::BeginFrame()
+{
+	s_LastFrame.barriers = s_Barriers.exchange(0, std::memory_order_relaxed);
+	s_LastFrame.flushes = s_Flushes.exchange(0, std::memory_order_relaxed);
+}
+
+vk::BarrierBatch::FrameStats vk::BarrierBatch::GetLastFrameStats()
+{
+	return s_LastFrame;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <volk/volk.h>
+#include <vector>
+
+// Collects the image and buffer barriers of one sync point and records them with a single vkCmdPipelineBarrier2.
+// Every barrier keeps its own stages (synchronization2), so batching doesn't widen the dependency of any of them.
+namespace vk
+{
+	class BarrierBatch
+	{
+	public:
+		struct FrameStats
+		{
+			uint32_t barriers = 0; // image + buffer barriers after merging
+			uint32_t flushes = 0;  // vkCmdPipelineBarrier2 calls
+		};
+
+		// Merged with a barrier already in the batch on the same image when it's a duplicate, continues its transition
+		// (old layout == the pending new layout) or covers the neighbouring mip levels with the same transition
+		BarrierBatch& Image(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+			VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+			VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess,
+			VkImageSubresourceRange range);
+
+		BarrierBatch& Buffer(VkBuffer buffer,
+			VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+			VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess,
+			VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+		// Records everything collected so far, does nothing when the batch is empty
+		void Flush(VkCommandBuffer cmd);
+
+		bool IsEmpty() const { return m_ImageBarriers.empty() && m_BufferBarriers.empty(); }
+
+		// Counters are shared by every batch and safe to update from the recording threads.
+		// BeginFrame keeps the finished frame's numbers for GetLastFrameStats and starts counting again.
+		static void BeginFrame();
+		static FrameStats GetLastFrameStats();
+
+	private:
+		std::vector<VkImageMemoryBarrier2> m_ImageBarriers;
+		std::vector<VkBufferMemoryBarrier2> m_BufferBarriers;
+	};
+}
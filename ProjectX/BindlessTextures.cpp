@@ -0,0 +1,141 @@
+#include "BindlessTextures.hpp"
+#include "Context.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	// Plenty for any scene the engine loads, drivers usually allow far more
+	constexpr uint32_t MaxTextures = 16384;
+}
+
+vk::BindlessTextures::BindlessTextures(Context& context) :
+	context{context}, m_Pool{VK_NULL_HANDLE}, m_Layout{VK_NULL_HANDLE}, m_Set{VK_NULL_HANDLE}, m_Capacity{0}, m_NextSlot{0}
+{
+	VkPhysicalDeviceVulkan12Properties vulkan12Props{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES };
+	VkPhysicalDeviceProperties2 props{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+	props.pNext = &vulkan12Props;
+	vkGetPhysicalDeviceProperties2(context.pDevice, &props);
+
+	m_Capacity = std::min({ MaxTextures,
+		vulkan12Props.maxDescriptorSetUpdateAfterBindSampledImages,
+		vulkan12Props.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+	VkDescriptorSetLayoutBinding binding = CreateDescriptorBinding(0, m_Capacity, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+	// Slots nobody uses are never written, and a slot can be filled while frames sampling other slots are in flight
+	const VkDescriptorBindingFlags bindingFlags =
+		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+		VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
+	flagsInfo.bindingCount = 1;
+	flagsInfo.pBindingFlags = &bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+	layoutInfo.pNext = &flagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &binding;
+
+	VK_CHECK(vkCreateDescriptorSetLayout(context.device, &layoutInfo, nullptr, &m_Layout), "Failed to create bindless texture set layout");
+
+	VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_Capacity };
+
+	VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+
+	VK_CHECK(vkCreateDescriptorPool(context.device, &poolInfo, nullptr, &m_Pool), "Failed to create bindless texture pool");
+
+	VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	allocInfo.descriptorPool = m_Pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &m_Layout;
+
+	VK_CHECK(vkAllocateDescriptorSets(context.device, &allocInfo, &m_Set), "Failed to allocate bindless texture set");
+
+	context.SetObjectName(context.device, (uint64_t)m_Set, VK_OBJECT_TYPE_DESCRIPTOR_SET, "BindlessTextures");
+}
+
+void vk::BindlessTextures::Destroy()
+{
+	vkDestroyDescriptorPool(context.device, m_Pool, nullptr);
+	vkDestroyDescriptorSetLayout(context.device, m_Layout, nullptr);
+
+	m_Pool = VK_NULL_HANDLE;
+	m_Layout = VK_NULL_HANDLE;
+	m_Set = VK_NULL_HANDLE;
+}
+
+uint32_t vk::BindlessTextures::Add(VkImageView imageView, VkImageLayout layout)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// Retired slots whose last user has finished on the GPU can be reused
+	const uint64_t completed = context.graphicsTimeline->GetCompletedValue();
+	for (size_t i = 0; i < m_RetiredSlots.size();)
+	{
+		if (m_RetiredSlots[i].timelineValue <= completed)
+		{
+			m_FreeSlots.push_back(m_RetiredSlots[i].slot);
+			m_RetiredSlots[i] = m_RetiredSlots.back();
+			m_RetiredSlots.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	uint32_t slot;
+	if (!m_FreeSlots.empty())
+	{
+		slot = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
+	else
+	{
+		if (m_NextSlot == m_Capacity)
+		{
+			throw std::runtime_error("Bindless texture table is full (" + std::to_string(m_Capacity) + " textures)");
+		}
+
+		slot = m_NextSlot++;
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageView = imageView;
+	imageInfo.imageLayout = layout;
+
+	VkWriteDescriptorSet write{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.dstSet = m_Set;
+	write.dstBinding = 0;
+	write.dstArrayElement = slot;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	write.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(context.device, 1, &write, 0, nullptr);
+
+	return slot;
+}
+
+void vk::BindlessTextures::Remove(uint32_t slot)
+{
+	if (slot == InvalidSlot)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_RetiredSlots.push_back({ slot, context.graphicsTimeline->GetSubmittedValue() });
+}
+
+uint32_t vk::BindlessTextures::GetCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_NextSlot - static_cast<uint32_t>(m_FreeSlots.size() + m_RetiredSlots.size());
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <volk/volk.h>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// One global table of sampled images (descriptor indexing) that every pass binds as set 1. Textures get a slot when
+// they're uploaded and shaders index the table with it, so there's no per-pass copy of the texture descriptors and no
+// fixed array size in the shaders. The set is partially bound and update-after-bind, slots can be filled while command
+// buffers using other slots are pending.
+namespace vk
+{
+	class Context;
+
+	class BindlessTextures
+	{
+	public:
+		static constexpr uint32_t InvalidSlot = 0xffffffff;
+
+		explicit BindlessTextures(Context& context);
+		void Destroy();
+
+		// Writes the view into a free slot and returns it, safe to call from any thread
+		uint32_t Add(VkImageView imageView, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// The slot is handed out again once the GPU has finished every submission made before this call
+		void Remove(uint32_t slot);
+
+		VkDescriptorSetLayout GetLayout() const { return m_Layout; }
+		VkDescriptorSet GetSet() const { return m_Set; }
+		uint32_t GetCapacity() const { return m_Capacity; }
+		uint32_t GetCount() const;
+
+	private:
+		struct RetiredSlot
+		{
+			uint32_t slot;
+			uint64_t timelineValue; // last submission that may still sample it
+		};
+
+		Context& context;
+		VkDescriptorPool m_Pool;
+		VkDescriptorSetLayout m_Layout;
+		VkDescriptorSet m_Set;
+		uint32_t m_Capacity;
+
+		mutable std::mutex m_Mutex;
+		uint32_t m_NextSlot;
+		std::vector<uint32_t> m_FreeSlots;
+		std::vector<RetiredSlot> m_RetiredSlots;
+	};
+}
@@ -1,7 +1,7 @@
 #include "Context.hpp"
 #include "Bloom.hpp"
 #include "Pipeline.hpp"
-#include "RenderPass.hpp"
+#include "Rendering.hpp"
 
 #define _USE_MATH_DEFINES
 #include <cmath>
@@ -63,15 +63,14 @@ namespace
 vk::Bloom::Bloom(Context& context, Image& inputImage) :
 	context{context},
 	inputImage{inputImage},
-	m_renderPass{VK_NULL_HANDLE},
-	m_HorizontalBlurFramebuffer{VK_NULL_HANDLE},
-	m_VerticalBlurFramebuffer{VK_NULL_HANDLE},
 	m_HorizontalBlurPipeline{VK_NULL_HANDLE},
 	m_HorizontalBlurPipelineLayout{VK_NULL_HANDLE},
 	m_HorizontalBlurDescriptorSetLayout{VK_NULL_HANDLE},
+	m_HorizontalBlurUpdateTemplate{VK_NULL_HANDLE},
 	m_VerticalBlurPipeline{VK_NULL_HANDLE},
 	m_VerticalBlurPipelineLayout{VK_NULL_HANDLE},
 	m_VerticalBlurDescriptorSetLayout{VK_NULL_HANDLE},
+	m_VerticalBlurUpdateTemplate{VK_NULL_HANDLE},
 	m_width{0},
 	m_height{0}
 {
@@ -80,26 +79,22 @@ vk::Bloom::Bloom(Context& context, Image& inputImage) :
 
 	m_GPUWeightsBuffer = CreateBuffer("GaussianWeightsBuffer", context, sizeof(GuassianWeightsBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
 
-	m_BloomBlurXRT = CreateImageTexture2D(
+	m_BloomBlurXRT = context.transientAllocator->CreateImage(
 		"Bloom_Blur_X_RT",
-		context,
 		m_width,
 		m_height,
 		VK_FORMAT_R16G16B16A16_SFLOAT,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_BloomBlurYRT = CreateImageTexture2D(
+	m_BloomBlurYRT = context.transientAllocator->CreateImage(
 		"Bloom_Blur_Y_RT",
-		context,
 		m_width,
 		m_height,
 		VK_FORMAT_R16G16B16A16_SFLOAT,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
 	std::vector<float> offsets;
@@ -119,9 +114,8 @@ vk::Bloom::Bloom(Context& context, Image& inputImage) :
 
 	BuildHorizontalBlurDescriptors();
 	BuildVerticalBlurDescriptors();
+	WriteDescriptors();
 
-	CreateRenderPass();
-	CreateFramebuffer();
 	CreatePipeline();
 }
 
@@ -130,75 +124,18 @@ vk::Bloom::~Bloom()
 	m_BloomBlurXRT.Destroy(context.device);
 	m_BloomBlurYRT.Destroy(context.device);
 
-	vkDestroyRenderPass(context.device, m_renderPass, nullptr);
-	vkDestroyFramebuffer(context.device, m_HorizontalBlurFramebuffer, nullptr);
-	vkDestroyFramebuffer(context.device, m_VerticalBlurFramebuffer, nullptr);
-
 	m_GPUWeightsBuffer.Destroy(context.device);
 	vkDestroyPipeline(context.device, m_HorizontalBlurPipeline, nullptr);
 	vkDestroyPipelineLayout(context.device, m_HorizontalBlurPipelineLayout, nullptr);
+	vkDestroyDescriptorUpdateTemplate(context.device, m_HorizontalBlurUpdateTemplate, nullptr);
 	vkDestroyDescriptorSetLayout(context.device, m_HorizontalBlurDescriptorSetLayout, nullptr);
 
 	vkDestroyPipeline(context.device, m_VerticalBlurPipeline, nullptr);
 	vkDestroyPipelineLayout(context.device, m_VerticalBlurPipelineLayout, nullptr);
+	vkDestroyDescriptorUpdateTemplate(context.device, m_VerticalBlurUpdateTemplate, nullptr);
 	vkDestroyDescriptorSetLayout(context.device, m_VerticalBlurDescriptorSetLayout, nullptr);
 }
 
-void vk::Bloom::CreateFramebuffer()
-{
-	{
-		std::vector<VkImageView> attachments = { m_BloomBlurXRT.imageView };
-
-		VkFramebufferCreateInfo fbcInfo = {
-			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-			.renderPass = m_renderPass,
-			.attachmentCount = static_cast<uint32_t>(attachments.size()),
-			.pAttachments = attachments.data(),
-			.width = context.extent.width,
-			.height = context.extent.height,
-			.layers = 1
-		};
-
-		VK_CHECK(vkCreateFramebuffer(context.device, &fbcInfo, nullptr, &m_HorizontalBlurFramebuffer), "Failed to create Bloom: Horizontal Blur framebuffer.");
-	}
-
-	{
-		std::vector<VkImageView> attachments = { m_BloomBlurYRT.imageView };
-
-		VkFramebufferCreateInfo fbcInfo = {
-			.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-			.renderPass = m_renderPass,
-			.attachmentCount = static_cast<uint32_t>(attachments.size()),
-			.pAttachments = attachments.data(),
-			.width = context.extent.width,
-			.height = context.extent.height,
-			.layers = 1
-		};
-
-		VK_CHECK(vkCreateFramebuffer(context.device, &fbcInfo, nullptr, &m_VerticalBlurFramebuffer), "Failed to create Bloom: Horizontal Blur framebuffer.");
-	}
-
-}
-
-
-void vk::Bloom::CreateRenderPass()
-{
-	RenderPass builder(context.device, 1);
-
-	m_renderPass = builder
-		.AddAttachment(VK_FORMAT_R16G16B16A16_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddColorAttachmentRef(0, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-
-		// External -> 0 : Color
-		.AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-		// 0 -> External : Color : Wait for color writing to finish on the attachment before the fragment shader tries to read from it
-		.AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-		.Build();
-
-	context.SetObjectName(context.device, (uint64_t)m_renderPass, VK_OBJECT_TYPE_RENDER_PASS, "BloomRenderPass");
-}
-
 // dstStage is where other operations will begin once srcStage is finished
 void vk::Bloom::Execute(VkCommandBuffer cmd)
 {
@@ -212,15 +149,10 @@ void vk::Bloom::RenderHorizontalBlur(VkCommandBuffer cmd)
 	RenderPassLabel(cmd, "BloomHorizontalBlur");
 #endif
 
-	VkRenderPassBeginInfo rpBegin{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-	rpBegin.renderPass = m_renderPass;
-	rpBegin.framebuffer = m_HorizontalBlurFramebuffer;
-	rpBegin.renderArea.extent = { m_width, m_height };
+	BeginColorTarget(cmd, m_BloomBlurXRT.image);
 
-	VkClearValue clearValues[1];
-	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	rpBegin.clearValueCount = 1;
-	rpBegin.pClearValues = clearValues;
+	RenderingInfo rendering({ m_width, m_height });
+	rendering.AddColorAttachment(m_BloomBlurXRT.imageView, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -236,7 +168,7 @@ void vk::Bloom::RenderHorizontalBlur(VkCommandBuffer cmd)
 	scissor.extent = { m_width, m_height };
 	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(cmd, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
+	rendering.Begin(cmd);
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_HorizontalBlurPipeline);
 
 	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_HorizontalBlurPipelineLayout, 0, 1, &m_HorizontalBlurDescriptorSets[currentFrame], 0, nullptr);
@@ -244,7 +176,9 @@ void vk::Bloom::RenderHorizontalBlur(VkCommandBuffer cmd)
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_HorizontalBlurPipeline);
 	vkCmdDraw(cmd, 3, 1, 0, 0);
 
-	vkCmdEndRenderPass(cmd);
+	vkCmdEndRendering(cmd);
+
+	EndColorTarget(cmd, m_BloomBlurXRT.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 #ifdef _DEBUG
 	EndRenderPassLabel(cmd);
@@ -258,15 +192,10 @@ void vk::Bloom::RenderVerticalBlur(VkCommandBuffer cmd)
 	RenderPassLabel(cmd, "BloomVerticalBlur");
 #endif // !DEBUG
 
-	VkRenderPassBeginInfo rpBegin{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-	rpBegin.renderPass = m_renderPass;
-	rpBegin.framebuffer = m_VerticalBlurFramebuffer;
-	rpBegin.renderArea.extent = { m_width, m_height };
+	BeginColorTarget(cmd, m_BloomBlurYRT.image);
 
-	VkClearValue clearValues[1];
-	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	rpBegin.clearValueCount = 1;
-	rpBegin.pClearValues = clearValues;
+	RenderingInfo rendering({ m_width, m_height });
+	rendering.AddColorAttachment(m_BloomBlurYRT.imageView, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -282,7 +211,7 @@ void vk::Bloom::RenderVerticalBlur(VkCommandBuffer cmd)
 	scissor.extent = { m_width, m_height };
 	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(cmd, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
+	rendering.Begin(cmd);
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_VerticalBlurPipeline);
 
 	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_VerticalBlurPipelineLayout, 0, 1, &m_VerticalBlurDescriptorSets[currentFrame], 0, nullptr);
@@ -290,7 +219,9 @@ void vk::Bloom::RenderVerticalBlur(VkCommandBuffer cmd)
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_VerticalBlurPipeline);
 	vkCmdDraw(cmd, 3, 1, 0, 0);
 
-	vkCmdEndRenderPass(cmd);
+	vkCmdEndRendering(cmd);
+
+	EndColorTarget(cmd, m_BloomBlurYRT.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 #ifdef _DEBUG
 	EndRenderPassLabel(cmd);
@@ -306,75 +237,25 @@ void vk::Bloom::Resize()
 	m_BloomBlurXRT.Destroy(context.device);
 	m_BloomBlurYRT.Destroy(context.device);
 
-	vkDestroyFramebuffer(context.device, m_HorizontalBlurFramebuffer, nullptr);
-	vkDestroyFramebuffer(context.device, m_VerticalBlurFramebuffer, nullptr);
-
-	m_BloomBlurXRT = CreateImageTexture2D(
+	m_BloomBlurXRT = context.transientAllocator->CreateImage(
 		"Bloom_Blur_X_RT",
-		context,
 		m_width,
 		m_height,
 		VK_FORMAT_R16G16B16A16_SFLOAT,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_BloomBlurYRT = CreateImageTexture2D(
+	m_BloomBlurYRT = context.transientAllocator->CreateImage(
 		"Bloom_Blur_Y_RT",
-		context,
 		m_width,
 		m_height,
 		VK_FORMAT_R16G16B16A16_SFLOAT,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	CreateFramebuffer();
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = clampToEdgeSamplerAniso,
-			.imageView = inputImage.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 0, imageInfo, m_HorizontalBlurDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = m_GPUWeightsBuffer.buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(GuassianWeightsBuffer);
-
-		UpdateDescriptorSet(context, 1, bufferInfo, m_HorizontalBlurDescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-	}
-
-	// Vertical
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = clampToEdgeSamplerAniso,
-			.imageView = m_BloomBlurXRT.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 0, imageInfo, m_VerticalBlurDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = m_GPUWeightsBuffer.buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(GuassianWeightsBuffer);
-
-		UpdateDescriptorSet(context, 1, bufferInfo, m_VerticalBlurDescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-	}
+	WriteDescriptors();
 }
 
 void vk::Bloom::Update()
@@ -384,7 +265,7 @@ void vk::Bloom::Update()
 
 void vk::Bloom::CreatePipeline()
 {
-	auto pipelineResult = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
 		.AddShader("../Engine/assets/shaders/fs_tri.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/bloom_blur_x.frag.spv", ShaderType::FRAGMENT)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
@@ -394,13 +275,10 @@ void vk::Bloom::CreatePipeline()
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
 		.AddBlendAttachmentState()
 		.SetDepthState(VK_FALSE, VK_FALSE, VK_COMPARE_OP_LESS_OR_EQUAL) // Turn depth read and write OFF ========
-		.SetRenderPass(m_renderPass)
-		.Build();
-
-	m_HorizontalBlurPipeline = pipelineResult.first;
-	m_HorizontalBlurPipelineLayout = pipelineResult.second;
+		.SetRenderingFormats({ VK_FORMAT_R16G16B16A16_SFLOAT })
+		.BuildDeferred(m_HorizontalBlurPipeline, m_HorizontalBlurPipelineLayout);
 
-	auto verticalPipelineResult = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
 		.AddShader("../Engine/assets/shaders/fs_tri.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/bloom_blur_y.frag.spv", ShaderType::FRAGMENT)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
@@ -410,12 +288,8 @@ void vk::Bloom::CreatePipeline()
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
 		.AddBlendAttachmentState()
 		.SetDepthState(VK_FALSE, VK_FALSE, VK_COMPARE_OP_LESS_OR_EQUAL) // Turn depth read and write OFF ========
-		.SetRenderPass(m_renderPass)
-		.Build();
-
-
-	m_VerticalBlurPipeline = verticalPipelineResult.first;
-	m_VerticalBlurPipelineLayout = verticalPipelineResult.second;
+		.SetRenderingFormats({ VK_FORMAT_R16G16B16A16_SFLOAT })
+		.BuildDeferred(m_VerticalBlurPipeline, m_VerticalBlurPipelineLayout);
 }
 
 void vk::Bloom::BuildHorizontalBlurDescriptors()
@@ -428,30 +302,10 @@ void vk::Bloom::BuildHorizontalBlurDescriptors()
 		};
 
 		m_HorizontalBlurDescriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
+		m_HorizontalBlurUpdateTemplate = CreateDescriptorUpdateTemplate(context, m_HorizontalBlurDescriptorSetLayout, bindings);
 	}
 
-	AllocateDescriptorSets(context, context.descriptorPool, m_HorizontalBlurDescriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_HorizontalBlurDescriptorSets);
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = clampToEdgeSamplerAniso,
-			.imageView = inputImage.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 0, imageInfo, m_HorizontalBlurDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = m_GPUWeightsBuffer.buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(GuassianWeightsBuffer);
-
-		UpdateDescriptorSet(context, 1, bufferInfo, m_HorizontalBlurDescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-	}
+	AllocateDescriptorSets(context, m_HorizontalBlurDescriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_HorizontalBlurDescriptorSets);
 }
 
 void vk::Bloom::BuildVerticalBlurDescriptors()
@@ -464,31 +318,27 @@ void vk::Bloom::BuildVerticalBlurDescriptors()
 		};
 
 		m_VerticalBlurDescriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
+		m_VerticalBlurUpdateTemplate = CreateDescriptorUpdateTemplate(context, m_VerticalBlurDescriptorSetLayout, bindings);
 	}
 
-	AllocateDescriptorSets(context, context.descriptorPool, m_VerticalBlurDescriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_VerticalBlurDescriptorSets);
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = clampToEdgeSamplerAniso,
-			.imageView = m_BloomBlurXRT.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 0, imageInfo, m_VerticalBlurDescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
+	AllocateDescriptorSets(context, m_VerticalBlurDescriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_VerticalBlurDescriptorSets);
+}
 
+void vk::Bloom::WriteDescriptors()
+{
 	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
 	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = m_GPUWeightsBuffer.buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(GuassianWeightsBuffer);
-
-		UpdateDescriptorSet(context, 1, bufferInfo, m_VerticalBlurDescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+		UpdateDescriptorSet(context, m_HorizontalBlurUpdateTemplate, m_HorizontalBlurDescriptorSets[i], {
+			DescriptorInfo(clampToEdgeSamplerAniso, inputImage.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			DescriptorInfo(m_GPUWeightsBuffer.buffer, sizeof(GuassianWeightsBuffer))
+		});
+
+		// Vertical blur reads the horizontal result
+		UpdateDescriptorSet(context, m_VerticalBlurUpdateTemplate, m_VerticalBlurDescriptorSets[i], {
+			DescriptorInfo(clampToEdgeSamplerAniso, m_BloomBlurXRT.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			DescriptorInfo(m_GPUWeightsBuffer.buffer, sizeof(GuassianWeightsBuffer))
+		});
 	}
-
 }
 
 
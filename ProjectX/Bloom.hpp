@@ -19,13 +19,13 @@ namespace vk
 		void Resize();
 
 		Image& GetRenderTarget() { return m_BloomBlurYRT; }
+		Image& GetBlurXRenderTarget() { return m_BloomBlurXRT; }
 
 	private:
 		void CreatePipeline();
 		void BuildHorizontalBlurDescriptors();
 		void BuildVerticalBlurDescriptors();
-		void CreateFramebuffer();
-		void CreateRenderPass();
+		void WriteDescriptors();
 
 		void RenderHorizontalBlur(VkCommandBuffer cmd);
 		void RenderVerticalBlur(VkCommandBuffer cmd);
@@ -37,20 +37,18 @@ namespace vk
 
 		std::vector<float> m_weights;
 
-		VkRenderPass m_renderPass;
-		VkFramebuffer m_HorizontalBlurFramebuffer;
-		VkFramebuffer m_VerticalBlurFramebuffer;
-
 		VkPipeline m_HorizontalBlurPipeline;
 		VkPipelineLayout m_HorizontalBlurPipelineLayout;
 		std::vector<VkDescriptorSet> m_HorizontalBlurDescriptorSets;
 		VkDescriptorSetLayout m_HorizontalBlurDescriptorSetLayout;
+		VkDescriptorUpdateTemplate m_HorizontalBlurUpdateTemplate;
 
 
 		VkPipeline m_VerticalBlurPipeline;
 		VkPipelineLayout m_VerticalBlurPipelineLayout;
 		std::vector<VkDescriptorSet> m_VerticalBlurDescriptorSets;
 		VkDescriptorSetLayout m_VerticalBlurDescriptorSetLayout;
+		VkDescriptorUpdateTemplate m_VerticalBlurUpdateTemplate;
 
 		uint32_t m_width;
 		uint32_t m_height;
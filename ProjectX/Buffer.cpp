@@ -1,6 +1,7 @@
 #include "Context.hpp"
 #include "Buffer.hpp"
 #include "Utils.hpp"
+#include "Barriers.hpp"
 
 vk::Buffer::Buffer() noexcept : buffer{ VK_NULL_HANDLE }, allocation{ VK_NULL_HANDLE }, allocator{ VK_NULL_HANDLE }, name{ "" } {}
 
@@ -81,19 +82,30 @@ void vk::CreateAndUploadBuffer(vk::Context& context, const void* data, VkDeviceS
         };
         vkCmdCopyBuffer(cmd, stagingBuffer.buffer, destinationBuffer.buffer, 1, &copy);
 
-        VkAccessFlags dstAccessMask = (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) ? VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT : VK_ACCESS_INDEX_READ_BIT;
-
-        VkBufferMemoryBarrier bufferBarrier = {
-            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-            .dstAccessMask = dstAccessMask,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .buffer = destinationBuffer.buffer,
-            .size = VK_WHOLE_SIZE,
-        };
-
-        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+        VkPipelineStageFlags2 dstStage = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT;
+        VkAccessFlags2 dstAccess = VK_ACCESS_2_INDEX_READ_BIT;
+        if ((usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) != 0)
+        {
+            dstStage = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+            dstAccess = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+        }
+        else if ((usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) != 0)
+        {
+            dstStage = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+            dstAccess = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT;
+        }
+        else if ((usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) != 0)
+        {
+            // Read by the draws and by the culling compute shaders
+            dstStage = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            dstAccess = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+        }
+
+        BarrierBatch barriers;
+        barriers.Buffer(destinationBuffer.buffer,
+            VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            dstStage, dstAccess);
+        barriers.Flush(cmd);
 
         });
 
@@ -0,0 +1,420 @@
+#include "Bvh.hpp"
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace
+{
+	constexpr uint32_t BinCount = 12;
+	constexpr uint32_t MaxLeafItems = 4;
+	// Leaves are never bigger than this, even when splitting them looks more expensive
+	constexpr uint32_t MaxForcedLeafItems = 32;
+
+	struct Bin
+	{
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+		uint32_t count = 0;
+	};
+
+	float HalfArea(const glm::vec3& min, const glm::vec3& max)
+	{
+		const glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+		return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+	}
+
+	uint32_t BinIndex(float centroid, float min, float scale)
+	{
+		return std::min(BinCount - 1, static_cast<uint32_t>((centroid - min) * scale));
+	}
+
+	// Entry and exit distance of the ray through the box, a miss when entry > exit
+	glm::vec2 RayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& min, const glm::vec3& max)
+	{
+		const glm::vec3 t0 = (min - origin) * inverseDirection;
+		const glm::vec3 t1 = (max - origin) * inverseDirection;
+		const glm::vec3 entry = glm::min(t0, t1);
+		const glm::vec3 exit = glm::max(t0, t1);
+
+		return { std::max(std::max(entry.x, entry.y), entry.z), std::min(std::min(exit.x, exit.y), exit.z) };
+	}
+
+	enum class Containment
+	{
+		Outside,
+		Intersecting,
+		Inside
+	};
+
+	Containment TestFrustum(const std::array<glm::vec4, 6>& planes, const glm::vec3& min, const glm::vec3& max)
+	{
+		Containment result = Containment::Inside;
+		for (const glm::vec4& plane : planes)
+		{
+			// The corner furthest along the plane's normal decides outside, the nearest one inside
+			const glm::vec3 positive(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+			const glm::vec3 negative(plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y, plane.z >= 0.0f ? min.z : max.z);
+
+			if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+				return Containment::Outside;
+			if (glm::dot(glm::vec3(plane), negative) + plane.w < 0.0f)
+				result = Containment::Intersecting;
+		}
+
+		return result;
+	}
+
+	bool Overlaps(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+	{
+		return glm::all(glm::lessThanEqual(minA, maxB)) && glm::all(glm::lessThanEqual(minB, maxA));
+	}
+
+	bool OverlapsSphere(const glm::vec3& min, const glm::vec3& max, const glm::vec3& center, float radius)
+	{
+		const glm::vec3 offset = glm::clamp(center, min, max) - center;
+		return glm::dot(offset, offset) <= radius * radius;
+	}
+}
+
+void vk::Bvh::Build(const std::vector<ObjectBounds>& bounds)
+{
+	m_Nodes.clear();
+	m_Items.resize(bounds.size());
+	m_Bounds = bounds;
+	if (bounds.empty())
+		return;
+
+	std::vector<glm::vec3> centroids(bounds.size());
+	for (uint32_t i = 0; i < static_cast<uint32_t>(bounds.size()); i++)
+	{
+		m_Items[i] = i;
+		centroids[i] = 0.5f * glm::vec3(bounds[i].min + bounds[i].max);
+	}
+
+	// A binary tree with at most one item per leaf has 2n - 1 nodes
+	m_Nodes.reserve(2 * bounds.size() - 1);
+	m_Nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), static_cast<uint32_t>(bounds.size()) });
+
+	std::vector<uint32_t> pending = { 0 };
+	while (!pending.empty())
+	{
+		const uint32_t node = pending.back();
+		pending.pop_back();
+		Subdivide(node, centroids, pending);
+	}
+}
+
+void vk::Bvh::Subdivide(uint32_t nodeIndex, const std::vector<glm::vec3>& centroids, std::vector<uint32_t>& pending)
+{
+	FitNode(m_Nodes[nodeIndex]);
+
+	const uint32_t first = m_Nodes[nodeIndex].leftFirst;
+	const uint32_t count = m_Nodes[nodeIndex].count;
+	if (count <= MaxLeafItems)
+		return;
+
+	glm::vec3 centroidMin(std::numeric_limits<float>::max());
+	glm::vec3 centroidMax(std::numeric_limits<float>::lowest());
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		centroidMin = glm::min(centroidMin, centroids[m_Items[i]]);
+		centroidMax = glm::max(centroidMax, centroids[m_Items[i]]);
+	}
+
+	// Surface area heuristic over the bin boundaries of every axis: items times box area on each side
+	float bestCost = std::numeric_limits<float>::max();
+	uint32_t bestAxis = 0;
+	uint32_t bestSplit = 0;
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		const float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+			continue;
+
+		const float scale = BinCount / extent;
+		std::array<Bin, BinCount> bins;
+		for (uint32_t i = first; i < first + count; i++)
+		{
+			const uint32_t item = m_Items[i];
+			Bin& bin = bins[BinIndex(centroids[item][axis], centroidMin[axis], scale)];
+			bin.min = glm::min(bin.min, glm::vec3(m_Bounds[item].min));
+			bin.max = glm::max(bin.max, glm::vec3(m_Bounds[item].max));
+			bin.count++;
+		}
+
+		// Left side sweeping forward, right side sweeping back, split i puts bins [0, i] on the left
+		std::array<float, BinCount - 1> leftCost;
+		Bin left;
+		for (uint32_t i = 0; i < BinCount - 1; i++)
+		{
+			left.min = glm::min(left.min, bins[i].min);
+			left.max = glm::max(left.max, bins[i].max);
+			left.count += bins[i].count;
+			leftCost[i] = left.count * HalfArea(left.min, left.max);
+		}
+
+		Bin right;
+		for (uint32_t i = BinCount - 1; i > 0; i--)
+		{
+			right.min = glm::min(right.min, bins[i].min);
+			right.max = glm::max(right.max, bins[i].max);
+			right.count += bins[i].count;
+
+			const float cost = leftCost[i - 1] + right.count * HalfArea(right.min, right.max);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i - 1;
+			}
+		}
+	}
+
+	// Every centroid in the same spot, no split separates them
+	if (bestCost == std::numeric_limits<float>::max())
+		return;
+
+	const float leafCost = count * HalfArea(m_Nodes[nodeIndex].min, m_Nodes[nodeIndex].max);
+	if (bestCost >= leafCost && count <= MaxForcedLeafItems)
+		return;
+
+	const float scale = BinCount / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	uint32_t* middle = std::partition(m_Items.data() + first, m_Items.data() + first + count, [&](uint32_t item)
+	{
+		return BinIndex(centroids[item][bestAxis], centroidMin[bestAxis], scale) <= bestSplit;
+	});
+
+	const uint32_t leftCount = static_cast<uint32_t>(middle - (m_Items.data() + first));
+	if (leftCount == 0 || leftCount == count)
+		return;
+
+	const uint32_t children = static_cast<uint32_t>(m_Nodes.size());
+	m_Nodes.push_back({ glm::vec3(0.0f), first, glm::vec3(0.0f), leftCount });
+	m_Nodes.push_back({ glm::vec3(0.0f), first + leftCount, glm::vec3(0.0f), count - leftCount });
+
+	m_Nodes[nodeIndex].leftFirst = children;
+	m_Nodes[nodeIndex].count = 0;
+
+	pending.push_back(children);
+	pending.push_back(children + 1);
+}
+
+void vk::Bvh::FitNode(Node& node) const
+{
+	node.min = glm::vec3(std::numeric_limits<float>::max());
+	node.max = glm::vec3(std::numeric_limits<float>::lowest());
+
+	if (node.count == 0)
+	{
+		const Node& left = m_Nodes[node.leftFirst];
+		const Node& right = m_Nodes[node.leftFirst + 1];
+		node.min = glm::min(left.min, right.min);
+		node.max = glm::max(left.max, right.max);
+		return;
+	}
+
+	for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+	{
+		node.min = glm::min(node.min, glm::vec3(m_Bounds[m_Items[i]].min));
+		node.max = glm::max(node.max, glm::vec3(m_Bounds[m_Items[i]].max));
+	}
+}
+
+void vk::Bvh::Refit(const std::vector<ObjectBounds>& bounds)
+{
+	m_Bounds = bounds;
+
+	// Children come after their parents, walking backwards every node's children are already refit
+	for (size_t i = m_Nodes.size(); i-- > 0;)
+	{
+		FitNode(m_Nodes[i]);
+	}
+}
+
+vk::ObjectBounds vk::Bvh::GetBounds() const
+{
+	if (m_Nodes.empty())
+		return { glm::vec4(0.0f), glm::vec4(0.0f) };
+
+	return { glm::vec4(m_Nodes[0].min, 1.0f), glm::vec4(m_Nodes[0].max, 1.0f) };
+}
+
+void vk::Bvh::AppendSubtree(uint32_t node, std::vector<uint32_t>& items) const
+{
+	// A subtree's items are contiguous in m_Items, from its leftmost leaf to its rightmost one
+	uint32_t leftmost = node;
+	while (m_Nodes[leftmost].count == 0)
+		leftmost = m_Nodes[leftmost].leftFirst;
+
+	uint32_t rightmost = node;
+	while (m_Nodes[rightmost].count == 0)
+		rightmost = m_Nodes[rightmost].leftFirst + 1;
+
+	const uint32_t first = m_Nodes[leftmost].leftFirst;
+	const uint32_t last = m_Nodes[rightmost].leftFirst + m_Nodes[rightmost].count;
+	items.insert(items.end(), m_Items.begin() + first, m_Items.begin() + last);
+}
+
+void vk::Bvh::QueryFrustum(const glm::mat4& viewProjection, std::vector<uint32_t>& items) const
+{
+	if (m_Nodes.empty())
+		return;
+
+	const std::array<glm::vec4, 6> planes = ExtractFrustumPlanes(viewProjection);
+
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty())
+	{
+		const Node& node = m_Nodes[stack.back()];
+		const uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+
+		const Containment containment = TestFrustum(planes, node.min, node.max);
+		if (containment == Containment::Outside)
+			continue;
+
+		// Nothing below needs a test once the whole node is inside
+		if (containment == Containment::Inside)
+		{
+			AppendSubtree(nodeIndex, items);
+			continue;
+		}
+
+		if (node.count == 0)
+		{
+			stack.push_back(node.leftFirst);
+			stack.push_back(node.leftFirst + 1);
+			continue;
+		}
+
+		for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+		{
+			const ObjectBounds& box = m_Bounds[m_Items[i]];
+			if (TestFrustum(planes, glm::vec3(box.min), glm::vec3(box.max)) != Containment::Outside)
+				items.push_back(m_Items[i]);
+		}
+	}
+}
+
+void vk::Bvh::QueryBox(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& items) const
+{
+	if (m_Nodes.empty())
+		return;
+
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty())
+	{
+		const Node& node = m_Nodes[stack.back()];
+		stack.pop_back();
+
+		if (!Overlaps(node.min, node.max, min, max))
+			continue;
+
+		if (node.count == 0)
+		{
+			stack.push_back(node.leftFirst);
+			stack.push_back(node.leftFirst + 1);
+			continue;
+		}
+
+		for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+		{
+			const ObjectBounds& box = m_Bounds[m_Items[i]];
+			if (Overlaps(glm::vec3(box.min), glm::vec3(box.max), min, max))
+				items.push_back(m_Items[i]);
+		}
+	}
+}
+
+void vk::Bvh::QuerySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& items) const
+{
+	if (m_Nodes.empty())
+		return;
+
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty())
+	{
+		const Node& node = m_Nodes[stack.back()];
+		stack.pop_back();
+
+		if (!OverlapsSphere(node.min, node.max, center, radius))
+			continue;
+
+		if (node.count == 0)
+		{
+			stack.push_back(node.leftFirst);
+			stack.push_back(node.leftFirst + 1);
+			continue;
+		}
+
+		for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+		{
+			const ObjectBounds& box = m_Bounds[m_Items[i]];
+			if (OverlapsSphere(glm::vec3(box.min), glm::vec3(box.max), center, radius))
+				items.push_back(m_Items[i]);
+		}
+	}
+}
+
+bool vk::Bvh::Raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, uint32_t& item, const IntersectFunction& intersect) const
+{
+	if (m_Nodes.empty())
+		return false;
+
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	bool hit = false;
+
+	// Node and the distance the ray enters it, a node further than the closest hit so far is skipped when popped
+	std::vector<std::pair<uint32_t, float>> stack;
+	const glm::vec2 root = RayBox(origin, inverseDirection, m_Nodes[0].min, m_Nodes[0].max);
+	if (root.x <= root.y && root.y >= 0.0f && root.x <= distance)
+		stack.push_back({ 0, root.x });
+
+	while (!stack.empty())
+	{
+		const auto [nodeIndex, entry] = stack.back();
+		stack.pop_back();
+		if (entry > distance)
+			continue;
+
+		const Node& node = m_Nodes[nodeIndex];
+		if (node.count == 0)
+		{
+			std::array<std::pair<uint32_t, glm::vec2>, 2> children = { {
+				{ node.leftFirst, RayBox(origin, inverseDirection, m_Nodes[node.leftFirst].min, m_Nodes[node.leftFirst].max) },
+				{ node.leftFirst + 1, RayBox(origin, inverseDirection, m_Nodes[node.leftFirst + 1].min, m_Nodes[node.leftFirst + 1].max) }
+			} };
+
+			// The far child goes on the stack first so the near one is visited first
+			if (children[0].second.x < children[1].second.x)
+				std::swap(children[0], children[1]);
+
+			for (const auto& [child, span] : children)
+			{
+				if (span.x <= span.y && span.y >= 0.0f && span.x <= distance)
+					stack.push_back({ child, span.x });
+			}
+			continue;
+		}
+
+		for (uint32_t i = node.leftFirst; i < node.leftFirst + node.count; i++)
+		{
+			const ObjectBounds& box = m_Bounds[m_Items[i]];
+			const glm::vec2 span = RayBox(origin, inverseDirection, glm::vec3(box.min), glm::vec3(box.max));
+			if (span.x > span.y || span.y < 0.0f || span.x > distance)
+				continue;
+
+			const float t = intersect ? intersect(m_Items[i], distance) : std::max(span.x, 0.0f);
+			if (t >= 0.0f && t <= distance)
+			{
+				distance = t;
+				item = m_Items[i];
+				hit = true;
+			}
+		}
+	}
+
+	return hit;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Utils.hpp"
+
+// Bounding volume hierarchy over a list of boxes: the scene's objects, or the triangles of a mesh. Built top down with
+// binned SAH, and refit in place when the boxes move without changing the tree, which stays good for moderate motion.
+// Items are referred to by their index in the list given to Build, queries append the indices of the items they find.
+namespace vk
+{
+	class Bvh
+	{
+	public:
+		// Exact test of a ray against an item whose box it hits: distance along the ray, or a negative value on a miss.
+		// maxDistance is the closest hit so far, anything further is a miss as well.
+		using IntersectFunction = std::function<float(uint32_t item, float maxDistance)>;
+
+		Bvh() = default;
+
+		void Build(const std::vector<ObjectBounds>& bounds);
+		// Same items, new boxes. Every node's box is recomputed from its children, the tree is kept.
+		void Refit(const std::vector<ObjectBounds>& bounds);
+
+		// Items whose box intersects the frustum of viewProjection
+		void QueryFrustum(const glm::mat4& viewProjection, std::vector<uint32_t>& items) const;
+		void QueryBox(const glm::vec3& min, const glm::vec3& max, std::vector<uint32_t>& items) const;
+		void QuerySphere(const glm::vec3& center, float radius, std::vector<uint32_t>& items) const;
+
+		// Closest hit along origin + t * direction for t in [0, distance]. Without intersect the items' boxes are the hits.
+		// On a hit distance and item are set to it, nearer children are visited first so far boxes get skipped.
+		bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float& distance, uint32_t& item, const IntersectFunction& intersect = {}) const;
+
+		// Box around every item, the root's
+		ObjectBounds GetBounds() const;
+
+		bool	 IsEmpty() const { return m_Nodes.empty(); }
+		uint32_t GetNodeCount() const { return static_cast<uint32_t>(m_Nodes.size()); }
+
+	private:
+		// Leaves have count items from m_Items[leftFirst], inner nodes have count 0 and their children at leftFirst, leftFirst + 1
+		struct Node
+		{
+			glm::vec3 min;
+			uint32_t leftFirst;
+			glm::vec3 max;
+			uint32_t count;
+		};
+
+		void Subdivide(uint32_t node, const std::vector<glm::vec3>& centroids, std::vector<uint32_t>& pending);
+		void FitNode(Node& node) const;
+		void AppendSubtree(uint32_t node, std::vector<uint32_t>& items) const;
+
+		std::vector<Node> m_Nodes; // root first, children always after their parent
+		std::vector<uint32_t> m_Items;
+		std::vector<ObjectBounds> m_Bounds;
+	};
+}
@@ -1,6 +1,7 @@
 #include "Context.hpp"
 #include "Buffer.hpp"
 #include "Camera.hpp"
+#include "Scene.hpp"
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -116,11 +117,47 @@ void vk::Camera::UpdateCameraMovement()
 	float speed = static_cast<float>(m_cameraSpeed * deltaTime);
 	glm::vec3 targetPosition = m_position + (movementAmount * speed);
 
+	if (cameraCollision && m_collisionScene)
+	{
+		targetPosition = MoveWithCollision(movementAmount * speed);
+	}
+
 	m_position = targetPosition;
 
 	//std::cout << "CamPos: " << m_position.x << ", " << m_position.y << ", " << m_position.z << std::endl;
 }
 
+glm::vec3 vk::Camera::MoveWithCollision(const glm::vec3& step) const
+{
+	constexpr float collisionRadius = 0.2f;
+
+	glm::vec3 position = m_position;
+	glm::vec3 remaining = step;
+
+	// The second cast covers the slide, a slide into another surface stops there
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		const float length = glm::length(remaining);
+		if (length < 1e-6f)
+			break;
+
+		const glm::vec3 direction = remaining / length;
+		Scene::RayHit hit;
+		if (!m_collisionScene->Raycast(position, direction, length + collisionRadius, hit))
+		{
+			position += remaining;
+			break;
+		}
+
+		const float travel = std::max(hit.distance - collisionRadius, 0.0f);
+		position += direction * travel;
+		remaining -= direction * travel;
+		remaining -= hit.normal * glm::dot(remaining, hit.normal);
+	}
+
+	return position;
+}
+
 void vk::Camera::UpdateCameraRotation()
 {
 	// If we're using the mouse
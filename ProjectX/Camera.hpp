@@ -18,6 +18,8 @@ constexpr float defaultSpeed = 3.0f;
 
 namespace vk
 {
+	class Scene;
+
 	struct CameraTransform
 	{
 		alignas(16) glm::mat4 model;
@@ -58,6 +60,8 @@ namespace vk
 		void SetFoV(float fov) { m_transform.fov = fov; }
 		void SetNearPlane(float nearPlane) { m_transform.nearPlane = nearPlane; }
 		void SetFarPlane(float farPlane) { m_transform.farPlane = farPlane; }
+		// Movement is ray cast against the scene's triangles while cameraCollision is on
+		void SetCollisionScene(const Scene* scene) { m_collisionScene = scene; }
 
 		const CameraTransform& GetCameraTransform() const { return m_transform; }
 		std::vector<Buffer>& GetBuffers() { return m_cameraUBO; }
@@ -85,11 +89,16 @@ namespace vk
 		float lastMouseX;
 		float lastMouseY;
 		bool wasMousing = false;
+		bool pickRequested = false; // a click to resolve against the scene on the next update
 
 	private:
+		// Where a move by step ends: short of the first surface hit by the collision radius, the rest slides along it
+		glm::vec3 MoveWithCollision(const glm::vec3& step) const;
+
 		Context& context;
 		CameraTransform m_transform;
 		std::vector<Buffer> m_cameraUBO;
+		const Scene* m_collisionScene = nullptr;
 
 		glm::vec3 m_position;
 		glm::vec3 m_direction;
@@ -0,0 +1,67 @@
+#include "CommandRecorder.hpp"
+#include "Context.hpp"
+#include "Utils.hpp"
+
+vk::CommandRecorder::CommandRecorder(Context& context) : context{context}, m_WorkerCount{context.jobSystem->GetWorkerCount()}
+{
+	m_Pools.resize(MAX_FRAMES_IN_FLIGHT);
+	for (auto& frame : m_Pools)
+	{
+		frame.resize(m_WorkerCount);
+		for (auto& worker : frame)
+		{
+			VkCommandPoolCreateInfo cmdPool{};
+			cmdPool.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			cmdPool.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+			cmdPool.queueFamilyIndex = context.graphicsFamilyIndex;
+
+			VK_CHECK(vkCreateCommandPool(context.device, &cmdPool, nullptr, &worker.pool), "Failed to create worker command pool");
+		}
+	}
+}
+
+void vk::CommandRecorder::Destroy()
+{
+	for (auto& frame : m_Pools)
+	{
+		for (auto& worker : frame)
+		{
+			// Destroying the pool frees every command buffer allocated from it
+			vkDestroyCommandPool(context.device, worker.pool, nullptr);
+		}
+	}
+
+	m_Pools.clear();
+}
+
+void vk::CommandRecorder::BeginFrame()
+{
+	for (auto& worker : m_Pools[currentFrame])
+	{
+		vkResetCommandPool(context.device, worker.pool, 0);
+		worker.used[0] = 0;
+		worker.used[1] = 0;
+	}
+}
+
+VkCommandBuffer vk::CommandRecorder::Allocate(uint32_t worker, VkCommandBufferLevel level)
+{
+	WorkerPool& pool = m_Pools[currentFrame][worker];
+	std::vector<VkCommandBuffer>& buffers = pool.buffers[level];
+
+	// Buffers are kept across frames and handed out again after the pool reset
+	if (pool.used[level] == buffers.size())
+	{
+		VkCommandBufferAllocateInfo cmdAlloc{};
+		cmdAlloc.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		cmdAlloc.commandPool = pool.pool;
+		cmdAlloc.level = level;
+		cmdAlloc.commandBufferCount = 1;
+
+		VkCommandBuffer cmd = VK_NULL_HANDLE;
+		VK_CHECK(vkAllocateCommandBuffers(context.device, &cmdAlloc, &cmd), "Failed to allocate worker command buffer");
+		buffers.push_back(cmd);
+	}
+
+	return buffers[pool.used[level]++];
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <volk/volk.h>
+#include <vector>
+
+// Command pools for recording on the job system's workers. Every worker owns one command pool per frame in flight,
+// so no pool is ever touched by two threads at once and a whole frame's buffers are recycled with a single pool reset.
+namespace vk
+{
+	class Context;
+
+	class CommandRecorder
+	{
+	public:
+		// One set of pools for each worker of the context's job system
+		explicit CommandRecorder(Context& context);
+
+		void Destroy();
+
+		// Resets the pools of the current frame, only call once its fence has been waited on
+		void BeginFrame();
+
+		// Command buffer from the worker's pool for the current frame, only valid until the next BeginFrame on this frame
+		VkCommandBuffer Allocate(uint32_t worker, VkCommandBufferLevel level);
+
+		uint32_t GetWorkerCount() const { return m_WorkerCount; }
+
+	private:
+		struct WorkerPool
+		{
+			VkCommandPool pool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> buffers[2]; // indexed by VkCommandBufferLevel
+			size_t used[2] = { 0, 0 };
+		};
+
+		Context& context;
+		uint32_t m_WorkerCount;
+		std::vector<std::vector<WorkerPool>> m_Pools; // [frame][worker]
+	};
+}
@@ -1,7 +1,6 @@
 #include <volk/volk.h>
 #include "Context.hpp"
 #include "Utils.hpp"
-#include "RenderPass.hpp"
 
 #include <unordered_set>
 #include <string>
@@ -32,8 +31,6 @@ namespace
 
     std::vector<VkImage> GetSwapchainImages(VkDevice device, VkSwapchainKHR swapchain);
     std::vector<VkImageView> CreateSwapchainImageViews(VkDevice device, VkFormat format, const std::vector<VkImage>& images);
-    std::vector<VkFramebuffer> CreateSwapchainFramebuffers(VkDevice device, std::vector<VkImageView>& swapchainImageViews, VkRenderPass renderPass, VkExtent2D extent);
-    VkRenderPass CreateSwapchainRenderPass(VkDevice device, VkFormat format);
 }
 
 namespace
@@ -269,52 +266,6 @@ namespace
 
         return swapchainImageViews;
     }
-
-    std::vector<VkFramebuffer> CreateSwapchainFramebuffers(VkDevice device, std::vector<VkImageView>& swapchainImageViews, VkRenderPass renderPass, VkExtent2D extent)
-    {
-        std::vector<VkFramebuffer> framebuffers;
-        for (const auto& imageView : swapchainImageViews)
-        {
-            std::vector<VkImageView> attachments = { imageView };
-
-            VkFramebufferCreateInfo fb_info{};
-            fb_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            fb_info.renderPass = renderPass;
-            fb_info.attachmentCount = static_cast<uint32_t>(attachments.size());
-            fb_info.pAttachments = attachments.data();
-            fb_info.width = extent.width;
-            fb_info.height = extent.height;
-            fb_info.layers = 1;
-
-            VkFramebuffer framebuffer = VK_NULL_HANDLE;
-            VK_CHECK(vkCreateFramebuffer(device, &fb_info, nullptr, &framebuffer), "Failed to create swapchain framebuffers.");
-
-            framebuffers.push_back(framebuffer);
-        }
-
-        return framebuffers;
-    }
-
-    VkRenderPass CreateSwapchainRenderPass(VkDevice device, VkFormat format)
-    {
-        vk::RenderPass builder(device, 1);
-
-        VkRenderPass renderPass = builder
-            .AddAttachment(format, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
-            .AddColorAttachmentRef(0, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-
-            // External -> 0 : Color : Wait for presentation pass to finish?
-            .AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_ACCESS_NONE, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-            // 0 -> External : Color :
-            .AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_ACCESS_NONE, VK_DEPENDENCY_BY_REGION_BIT)
-
-
-            .Build();
-
-
-        return renderPass;
-    }
 }
 
 
@@ -334,13 +285,11 @@ vk::Context::Context() :
     allocator(VK_NULL_HANDLE),
     swapchain(VK_NULL_HANDLE),
     oldSwapchain{VK_NULL_HANDLE},
-    renderPass(VK_NULL_HANDLE),
     swapchainFormat(VK_FORMAT_UNDEFINED),
     extent{},
     presentMode(VK_PRESENT_MODE_FIFO_KHR),
     isSwapchainOutdated(false),
     transientCommandPool(VK_NULL_HANDLE),
-    descriptorPool(VK_NULL_HANDLE),
     vkSetDebugUtilsObjectNameEXT(VK_NULL_HANDLE)
 {
 
@@ -350,20 +299,15 @@ void vk::Context::Destroy()
 {
     vkDeviceWaitIdle(device);
 
-    swapchainImages.clear();
+    jobSystem.reset();
 
-    for (const auto& framebuffer : swapchainFramebuffers)
-    {
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
-    }
+    swapchainImages.clear();
 
     for (const auto& imageView : swapchainImageViews)
     {
         vkDestroyImageView(device, imageView, nullptr);
     }
 
-    vkDestroyRenderPass(device, renderPass, nullptr);
-
     if (oldSwapchain != VK_NULL_HANDLE) {
         vkDestroySwapchainKHR(device, oldSwapchain, nullptr);
     }
@@ -375,9 +319,10 @@ void vk::Context::Destroy()
         vkDestroyCommandPool(device, transientCommandPool, nullptr);
     }
 
-    if (descriptorPool != VK_NULL_HANDLE)
+    if (descriptorAllocator)
     {
-        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        descriptorAllocator->Destroy();
+        descriptorAllocator.reset();
     }
 
     if (surface != VK_NULL_HANDLE)
@@ -385,6 +330,33 @@ void vk::Context::Destroy()
         vkDestroySurfaceKHR(instance, surface, nullptr);
     }
 
+    transientAllocator.reset();
+
+    if (bindlessTextures)
+    {
+        bindlessTextures->Destroy();
+        bindlessTextures.reset();
+    }
+
+    if (shaderLibrary)
+    {
+        shaderLibrary->Destroy();
+        shaderLibrary.reset();
+    }
+
+    if (pipelineCache)
+    {
+        pipelineCache->Save();
+        pipelineCache->Destroy();
+        pipelineCache.reset();
+    }
+
+    if (graphicsTimeline)
+    {
+        graphicsTimeline->Destroy();
+        graphicsTimeline.reset();
+    }
+
     if (allocator != VK_NULL_HANDLE)
     {
         vmaDestroyAllocator(allocator);
@@ -422,17 +394,10 @@ void vk::Context::TeardownSwapchain()
     oldSwapchain = swapchain;
 
     swapchainImages.clear();
-    for (const auto& framebuffer : swapchainFramebuffers)
-    {
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
-    }
-
     for (const auto& imageView : swapchainImageViews)
     {
         vkDestroyImageView(device, imageView, nullptr);
     }
-
-    vkDestroyRenderPass(device, renderPass, nullptr);
 }
 
 void vk::Context::RecreateSwapchain()
@@ -474,11 +439,33 @@ void vk::Context::CreateLogicalDevice()
     VkPhysicalDeviceFeatures features = {};
     features.samplerAnisotropy = VK_TRUE;
     features.geometryShader = VK_TRUE;
+    features.multiDrawIndirect = VK_TRUE;
+    features.drawIndirectFirstInstance = VK_TRUE; // firstInstance carries the object index
+
+    // Scalar block layout is core in 1.2, it has to be enabled through the 1.2 features once they are chained
+    // Material textures are one partially bound, update-after-bind table indexed by the shaders (BindlessTextures).
+    // Every pass renders through vkCmdBeginRendering, there are no render pass objects.
+    // Barriers are recorded with vkCmdPipelineBarrier2 by BarrierBatch.
+    // Scene geometry is drawn with vkCmdDrawIndexedIndirectCount from one persistent command buffer.
+    VkPhysicalDeviceVulkan13Features vulkan13Features
+    {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .synchronization2 = VK_TRUE,
+        .dynamicRendering = VK_TRUE
+    };
 
-    VkPhysicalDeviceScalarBlockLayoutFeaturesEXT scalarBlockFeatures
-    {
-        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SCALAR_BLOCK_LAYOUT_FEATURES_EXT,
-        .scalarBlockLayout = VK_TRUE
+    VkPhysicalDeviceVulkan12Features vulkan12Features
+    {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = &vulkan13Features,
+        .drawIndirectCount = VK_TRUE,
+        .descriptorIndexing = VK_TRUE,
+        .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+        .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+        .descriptorBindingPartiallyBound = VK_TRUE,
+        .runtimeDescriptorArray = VK_TRUE,
+        .scalarBlockLayout = VK_TRUE,
+        .timelineSemaphore = VK_TRUE
     };
 
     std::vector<const char*> extensions{ VK_KHR_SWAPCHAIN_EXTENSION_NAME };
@@ -490,7 +477,7 @@ void vk::Context::CreateLogicalDevice()
     deviceInfo.pEnabledFeatures = &features;
     deviceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     deviceInfo.ppEnabledExtensionNames = extensions.data();
-    deviceInfo.pNext = &scalarBlockFeatures;
+    deviceInfo.pNext = &vulkan12Features;
 
     VK_CHECK(vkCreateDevice(pDevice, &deviceInfo, nullptr, &device), "Failed to create logical device.");
 }
@@ -585,9 +572,6 @@ void vk::Context::CreateSwapchain()
         .oldSwapchain = oldSwapchain
     };
 
-    // Set max frames in flight
-    vk::MAX_FRAMES_IN_FLIGHT = imageCount;
-
     if (numIndices <= 1)
     {
         swapchainCreateInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
@@ -602,10 +586,8 @@ void vk::Context::CreateSwapchain()
 
     VK_CHECK(vkCreateSwapchainKHR(device, &swapchainCreateInfo, nullptr, &swapchain), "Failed to create swapchain");
 
-    renderPass = CreateSwapchainRenderPass(device, swapchainFormat);
     swapchainImages = GetSwapchainImages(device, swapchain);
     swapchainImageViews = CreateSwapchainImageViews(device, swapchainFormat, swapchainImages);
-    swapchainFramebuffers = CreateSwapchainFramebuffers(device, swapchainImageViews, renderPass, extent);
 }
 
 bool vk::Context::MakeContext(uint32_t width, uint32_t height)
@@ -738,14 +720,21 @@ bool vk::Context::MakeContext(uint32_t width, uint32_t height)
     vkGetDeviceQueue(device, presentFamilyIndex, 0, &presentQueue);
 
     CreateAllocator();
+    transientAllocator = std::make_unique<TransientAllocator>(*this);
+    jobSystem = std::make_unique<JobSystem>();
     CreateTransientCommandPool();
-    CreateDescriptorPool();
+    descriptorAllocator = std::make_unique<DescriptorAllocator>(*this, 256, "DescriptorPool");
 
     assert(graphicsQueue != VK_NULL_HANDLE);
     assert(presentQueue != VK_NULL_HANDLE);
 
     vkSetDebugUtilsObjectNameEXT = (PFN_vkSetDebugUtilsObjectNameEXT)vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT");
 
+    graphicsTimeline = std::make_unique<Timeline>(*this, "GraphicsTimeline");
+    pipelineCache = std::make_unique<PipelineCache>(*this, "pipeline_cache.bin");
+    shaderLibrary = std::make_unique<ShaderLibrary>(*this);
+    bindlessTextures = std::make_unique<BindlessTextures>(*this);
+
     CreateSwapchain();
 
     // Set max anisotropic level
@@ -764,23 +753,4 @@ void vk::Context::CreateTransientCommandPool()
     };
 
     VK_CHECK(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &transientCommandPool), "Failed to create transient command pool.");
-}
-
-void vk::Context::CreateDescriptorPool()
-{
-    VkDescriptorPoolSize bufferPoolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER };
-    bufferPoolSize.descriptorCount = 512;
-    VkDescriptorPoolSize samplerPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER };
-    samplerPoolSize.descriptorCount = 512;
-    VkDescriptorPoolSize storagePoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
-    storagePoolSize.descriptorCount = 512;
-
-    std::vector<VkDescriptorPoolSize> poolSize = { bufferPoolSize, samplerPoolSize, storagePoolSize };
-
-    VkDescriptorPoolCreateInfo info{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-    info.poolSizeCount = static_cast<uint32_t>(poolSize.size());
-    info.pPoolSizes = poolSize.data();
-    info.maxSets = 1536;
-
-    VK_CHECK(vkCreateDescriptorPool(device, &info, nullptr, &descriptorPool), "Failed to create descriptor pool");
 }
\ No newline at end of file
@@ -3,7 +3,15 @@
 #include <volk/volk.h>
 #include <vk_mem_alloc.h>
 #include <vector>
+#include <memory>
 #include "Image.hpp"
+#include "TransientAllocator.hpp"
+#include "JobSystem.hpp"
+#include "Timeline.hpp"
+#include "PipelineCache.hpp"
+#include "ShaderLibrary.hpp"
+#include "BindlessTextures.hpp"
+#include "DescriptorAllocator.hpp"
 
 namespace vk
 {
@@ -45,14 +53,18 @@ namespace vk
 		VkSwapchainKHR oldSwapchain;
 		std::vector<VkImage> swapchainImages;
 		std::vector<VkImageView> swapchainImageViews;
-		std::vector<VkFramebuffer> swapchainFramebuffers;
-		VkRenderPass renderPass;
 		VkFormat swapchainFormat;
 		VkExtent2D extent{};
 		VkPresentModeKHR presentMode;
 		bool isSwapchainOutdated;
 		VkCommandPool transientCommandPool;
-		VkDescriptorPool descriptorPool;
+		std::unique_ptr<TransientAllocator> transientAllocator;
+		std::unique_ptr<JobSystem> jobSystem;
+		std::unique_ptr<Timeline> graphicsTimeline; // signalled by every submission to the graphics queue
+		std::unique_ptr<PipelineCache> pipelineCache; // loaded at startup, written back in Destroy
+		std::unique_ptr<ShaderLibrary> shaderLibrary;
+		std::unique_ptr<BindlessTextures> bindlessTextures; // set 1 of every pass that samples material textures
+		std::unique_ptr<DescriptorAllocator> descriptorAllocator; // sets owned by the passes, grows when a pool is full
 		PFN_vkSetDebugUtilsObjectNameEXT vkSetDebugUtilsObjectNameEXT;
 
 		uint32_t apiVersion;
@@ -60,6 +72,5 @@ namespace vk
 	private:
 		// Create transient pool once to use for one-time submit command buffers
 		void CreateTransientCommandPool();
-		void CreateDescriptorPool();
 	};
 }
\ No newline at end of file
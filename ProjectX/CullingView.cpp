@@ -0,0 +1,473 @@
+#include "Context.hpp"
+#include "CullingView.hpp"
+#include "Barriers.hpp"
+#include "Pipeline.hpp"
+#include "RadixSort.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+namespace
+{
+	// Enough for a 2^17 wide depth target, the levels past it would be smaller than any object's footprint anyway
+	constexpr uint32_t MaxPyramidLevels = 16;
+
+	// Workgroup sizes of cull.comp and depth_reduce.comp
+	constexpr uint32_t CullGroupSize = 64;
+	constexpr uint32_t ReduceGroupSize = 8;
+
+	// Lists in the count buffer
+	constexpr uint32_t EarlyOpaqueList = 0;
+	constexpr uint32_t LateOpaqueList = 2;
+
+	vk::SpecializationConstants CullPhase(bool late)
+	{
+		return vk::SpecializationConstants().Set(0, late);
+	}
+
+	// Sort key of a CPU culled draw, from the most significant bits:
+	//  63     list, opaque draws before alpha masked ones as each list is drawn with its own pipeline
+	//  62-47  depth of the box center, front to back so early-z rejects as much as it can
+	//  46-32  material, draws at a similar depth are grouped by material
+	//  31-0   index of the draw in the scene's draw list
+	uint64_t DrawSortKey(bool alphaMasked, float depth, uint32_t material, uint32_t draw)
+	{
+		const uint64_t quantizedDepth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * 65535.0f);
+		return (uint64_t(alphaMasked) << 63) | (quantizedDepth << 47) | (uint64_t(material & 0x7fffu) << 32) | draw;
+	}
+}
+
+vk::CullingView::CullingView(Context& context, std::shared_ptr<Scene> scene, Image& depth, const std::string& name, bool shadowCasters) :
+	context{context},
+	scene{scene},
+	m_Depth{depth},
+	m_Name{name},
+	m_ShadowCasters{shadowCasters},
+	m_Constants{},
+	m_PyramidSampler{VK_NULL_HANDLE},
+	m_CullSet{VK_NULL_HANDLE},
+	m_CpuOpaqueCount{0},
+	m_CpuAlphaMaskedCount{0}
+{
+	m_Constants.drawCount = scene->GetDrawCount();
+	m_Constants.opaqueDrawCount = scene->GetOpaqueDrawCount();
+
+	// Both halves of the draw buffer hold a whole copy of the scene's draws, a draw is in at most one of them
+	const VkDeviceSize drawCapacity = std::max(m_Constants.drawCount, 1u);
+	m_DrawBuffer = CreateBuffer(m_Name + "_Draws", context, 2 * drawCapacity * sizeof(VkDrawIndexedIndirectCommand),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, 0);
+	m_DrawCountBuffer = CreateBuffer(m_Name + "_DrawCounts", context, 4 * sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0);
+	m_VisibilityBuffer = CreateBuffer(m_Name + "_Visibility", context, drawCapacity * sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0);
+
+	m_CpuDrawBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	for (auto& buffer : m_CpuDrawBuffers)
+		buffer = CreateBuffer(m_Name + "_CpuDraws", context, drawCapacity * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+
+	// Nothing was visible before the first frame, its late phase draws whatever the frustum lets through
+	ExecuteSingleTimeCommands(context, [&](VkCommandBuffer cmd)
+	{
+		vkCmdFillBuffer(cmd, m_VisibilityBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+
+		BarrierBatch barriers;
+		barriers.Buffer(m_VisibilityBuffer.buffer,
+			VK_PIPELINE_STAGE_2_CLEAR_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+		barriers.Flush(cmd);
+	});
+
+	// The pyramid is only ever read with texelFetch
+	VkSamplerCreateInfo samplerInfo{ VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	VK_CHECK(vkCreateSampler(context.device, &samplerInfo, nullptr, &m_PyramidSampler), "Failed to create depth pyramid sampler");
+
+	CreatePipelines();
+
+	m_CullSet = context.descriptorAllocator->Allocate(m_Pipelines->cullSetLayout);
+	m_ReduceSets.resize(MaxPyramidLevels);
+	context.descriptorAllocator->Allocate(m_Pipelines->reduceSetLayout, MaxPyramidLevels, m_ReduceSets.data());
+
+	CreatePyramid();
+	WriteDescriptors();
+}
+
+vk::CullingView::~CullingView()
+{
+	for (VkImageView view : m_PyramidLevelViews)
+	{
+		vkDestroyImageView(context.device, view, nullptr);
+	}
+
+	m_Pyramid.Destroy(context.device);
+	m_DrawBuffer.Destroy(context.device);
+	m_DrawCountBuffer.Destroy(context.device);
+	m_VisibilityBuffer.Destroy(context.device);
+
+	for (auto& buffer : m_CpuDrawBuffers)
+	{
+		buffer.Destroy(context.device);
+	}
+
+	vkDestroySampler(context.device, m_PyramidSampler, nullptr);
+}
+
+vk::CullingView::SharedPipelines::~SharedPipelines()
+{
+	cull.Destroy();
+	vkDestroyPipeline(device, reduce, nullptr);
+	vkDestroyPipelineLayout(device, reduceLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, cullSetLayout, nullptr);
+	vkDestroyDescriptorSetLayout(device, reduceSetLayout, nullptr);
+}
+
+void vk::CullingView::Resize()
+{
+	for (VkImageView view : m_PyramidLevelViews)
+	{
+		vkDestroyImageView(context.device, view, nullptr);
+	}
+	m_PyramidLevelViews.clear();
+	m_Pyramid.Destroy(context.device);
+
+	CreatePyramid();
+	WriteDescriptors();
+}
+
+void vk::CullingView::ResolvePipelines()
+{
+	// Shared with the other views, the first one to get here resolves them for all
+	if (m_Pipelines->earlyCull != VK_NULL_HANDLE)
+		return;
+
+	m_Pipelines->earlyCull = m_Pipelines->cull.Get(CullPhase(false));
+	m_Pipelines->lateCull = m_Pipelines->cull.Get(CullPhase(true));
+}
+
+void vk::CullingView::CullEarly(VkCommandBuffer cmd, const glm::mat4& viewProjection)
+{
+	m_Constants.viewProjection = viewProjection;
+	m_Constants.depthSize = glm::vec2(m_Depth.width, m_Depth.height);
+
+	if (m_Constants.drawCount == 0 || !gpuCulling)
+		return;
+
+	// Last frame's draws may still be reading the lists and its late phase wrote the visibility
+	BarrierBatch barriers;
+	barriers.Buffer(m_DrawCountBuffer.buffer,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+		VK_PIPELINE_STAGE_2_CLEAR_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+	barriers.Buffer(m_DrawBuffer.buffer,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+	barriers.Buffer(m_VisibilityBuffer.buffer,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+	barriers.Flush(cmd);
+
+	vkCmdFillBuffer(cmd, m_DrawCountBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+
+	barriers.Buffer(m_DrawCountBuffer.buffer,
+		VK_PIPELINE_STAGE_2_CLEAR_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+	barriers.Flush(cmd);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipelines->earlyCull);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipelines->cull.GetLayout(), 0, 1, &m_CullSet, 0, nullptr);
+	vkCmdPushConstants(cmd, m_Pipelines->cull.GetLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &m_Constants);
+	vkCmdDispatch(cmd, (m_Constants.drawCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+	barriers.Buffer(m_DrawBuffer.buffer,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+	barriers.Buffer(m_DrawCountBuffer.buffer,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+	barriers.Flush(cmd);
+}
+
+void vk::CullingView::CullLate(VkCommandBuffer cmd)
+{
+	if (m_Constants.drawCount == 0 || !gpuCulling)
+		return;
+
+	const uint32_t levels = m_Constants.pyramidLevels;
+
+	// Last frame's late phase sampled the pyramid, the early phase read the visibility this one overwrites
+	BarrierBatch barriers;
+	barriers.Image(m_Pyramid.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+		{ VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1 });
+	barriers.Buffer(m_VisibilityBuffer.buffer,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+	barriers.Flush(cmd);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipelines->reduce);
+
+	ReduceConstants reduce = { glm::ivec2(m_Depth.width, m_Depth.height), 0 };
+	for (uint32_t level = 0; level < levels; level++)
+	{
+		const uint32_t width = std::max(m_Pyramid.width >> level, 1u);
+		const uint32_t height = std::max(m_Pyramid.height >> level, 1u);
+
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipelines->reduceLayout, 0, 1, &m_ReduceSets[level], 0, nullptr);
+		vkCmdPushConstants(cmd, m_Pipelines->reduceLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ReduceConstants), &reduce);
+		vkCmdDispatch(cmd, (width + ReduceGroupSize - 1) / ReduceGroupSize, (height + ReduceGroupSize - 1) / ReduceGroupSize, 1);
+
+		// The next level reduces this one, the cull reads all of them
+		barriers.Image(m_Pyramid.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+			{ VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 });
+		barriers.Flush(cmd);
+
+		reduce = { glm::ivec2(width, height), static_cast<int32_t>(level) };
+	}
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipelines->lateCull);
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipelines->cull.GetLayout(), 0, 1, &m_CullSet, 0, nullptr);
+	vkCmdPushConstants(cmd, m_Pipelines->cull.GetLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants), &m_Constants);
+	vkCmdDispatch(cmd, (m_Constants.drawCount + CullGroupSize - 1) / CullGroupSize, 1, 1);
+
+	barriers.Buffer(m_DrawBuffer.buffer,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+	barriers.Buffer(m_DrawCountBuffer.buffer,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+	barriers.Flush(cmd);
+}
+
+void vk::CullingView::Draw(VkCommandBuffer cmd, Scene::DrawFilter filter, Phase phase)
+{
+	const uint32_t drawCount = m_Constants.drawCount;
+	const uint32_t opaqueCount = m_Constants.opaqueDrawCount;
+	if (drawCount == 0)
+		return;
+
+	scene->BindGeometry(cmd);
+
+	if (!gpuCulling)
+	{
+		// Only the early phase has draws, the alpha masked ones start after the scene's opaque draws like on the GPU
+		if (phase == Phase::Late)
+			return;
+
+		const VkBuffer cpuDraws = m_CpuDrawBuffers[currentFrame].buffer;
+		if (filter != Scene::DrawFilter::AlphaMasked && m_CpuOpaqueCount > 0)
+			vkCmdDrawIndexedIndirect(cmd, cpuDraws, 0, m_CpuOpaqueCount, sizeof(VkDrawIndexedIndirectCommand));
+
+		if (filter != Scene::DrawFilter::Opaque && m_CpuAlphaMaskedCount > 0)
+			vkCmdDrawIndexedIndirect(cmd, cpuDraws, opaqueCount * sizeof(VkDrawIndexedIndirectCommand), m_CpuAlphaMaskedCount, sizeof(VkDrawIndexedIndirectCommand));
+
+		return;
+	}
+
+	for (Phase listPhase : { Phase::Early, Phase::Late })
+	{
+		if (phase != Phase::All && phase != listPhase)
+			continue;
+
+		// The late lists follow the early ones, each list has room for every draw of its kind
+		const uint32_t list = listPhase == Phase::Late ? LateOpaqueList : EarlyOpaqueList;
+		const uint32_t first = listPhase == Phase::Late ? drawCount : 0;
+
+		if (filter != Scene::DrawFilter::AlphaMasked && opaqueCount > 0)
+			DrawList(cmd, list, first, opaqueCount);
+
+		if (filter != Scene::DrawFilter::Opaque && drawCount > opaqueCount)
+			DrawList(cmd, list + 1, first + opaqueCount, drawCount - opaqueCount);
+	}
+}
+
+void vk::CullingView::CullOnCpu(const glm::mat4& viewProjection)
+{
+	const std::vector<VkDrawIndexedIndirectCommand>& draws = scene->GetDraws();
+	if (draws.empty())
+		return;
+
+	const FrustumCuller& culler = scene->GetFrustumCuller();
+	const std::vector<ObjectData>& objects = scene->GetObjects();
+	// A light's casters come from the scene's hierarchy one instance at a time, the camera tests each draw's whole box
+	if (m_ShadowCasters)
+	{
+		scene->FindShadowCasters(viewProjection, m_CpuVisibility, m_CpuObjects);
+	}
+	else
+	{
+		culler.Cull(viewProjection, m_CpuVisibility);
+	}
+
+	m_SortKeys.clear();
+	m_CpuOpaqueCount = 0;
+	m_CpuAlphaMaskedCount = 0;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(draws.size()); i++)
+	{
+		if ((m_CpuVisibility[i / FrustumCuller::BoxesPerGroup] & (1u << (i % FrustumCuller::BoxesPerGroup))) == 0)
+			continue;
+
+		// Depth in [-1, 1] after the divide, boxes reaching behind the eye sort first
+		const glm::vec4 clip = viewProjection * glm::vec4(culler.GetCenter(i), 1.0f);
+		const float depth = clip.w > 0.0f ? clip.z / clip.w * 0.5f + 0.5f : 0.0f;
+
+		const bool alphaMasked = i >= m_Constants.opaqueDrawCount;
+		m_SortKeys.push_back(DrawSortKey(alphaMasked, depth, objects[draws[i].firstInstance].materialIndex, i));
+		(alphaMasked ? m_CpuAlphaMaskedCount : m_CpuOpaqueCount)++;
+	}
+
+	RadixSort(m_SortKeys, m_SortScratch, context.jobSystem.get());
+
+	// Sorted opaque draws are compacted from the start, alpha masked ones from opaqueDrawCount
+	m_CpuDraws.resize(draws.size());
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_SortKeys.size()); i++)
+	{
+		const uint32_t slot = i < m_CpuOpaqueCount ? i : m_Constants.opaqueDrawCount + (i - m_CpuOpaqueCount);
+		m_CpuDraws[slot] = draws[static_cast<uint32_t>(m_SortKeys[i])];
+	}
+
+	m_CpuStats.visible = m_CpuOpaqueCount + m_CpuAlphaMaskedCount;
+	m_CpuStats.culled = static_cast<uint32_t>(draws.size()) - m_CpuStats.visible;
+
+	// The frame that last drew from this buffer has finished, Render waits on it before the update
+	m_CpuDrawBuffers[currentFrame].WriteToBuffer(m_CpuDraws.data(), m_CpuDraws.size() * sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void vk::CullingView::DrawList(VkCommandBuffer cmd, uint32_t list, uint32_t first, uint32_t maxDrawCount)
+{
+	vkCmdDrawIndexedIndirectCount(cmd,
+		m_DrawBuffer.buffer, first * sizeof(VkDrawIndexedIndirectCommand),
+		m_DrawCountBuffer.buffer, list * sizeof(uint32_t),
+		maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void vk::CullingView::CreatePipelines()
+{
+	// Every view runs the same shaders with the same layouts, only the first one creates them
+	m_Pipelines = s_SharedPipelines.lock();
+	if (m_Pipelines)
+		return;
+
+	m_Pipelines = std::make_shared<SharedPipelines>();
+	m_Pipelines->device = context.device;
+	s_SharedPipelines = m_Pipelines;
+
+	std::vector<VkDescriptorSetLayoutBinding> cullBindings = {
+		CreateDescriptorBinding(0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT), // Scene draws
+		CreateDescriptorBinding(1, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT), // Draw bounds
+		CreateDescriptorBinding(2, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT), // Culled draws
+		CreateDescriptorBinding(3, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT), // Draw counts
+		CreateDescriptorBinding(4, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT), // Visibility
+		CreateDescriptorBinding(5, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT) // Depth pyramid
+	};
+
+	m_Pipelines->cullSetLayout = CreateDescriptorSetLayout(context, cullBindings);
+
+	std::vector<VkDescriptorSetLayoutBinding> reduceBindings = {
+		CreateDescriptorBinding(0, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT), // Depth or the level above
+		CreateDescriptorBinding(1, 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT) // Level written
+	};
+
+	m_Pipelines->reduceSetLayout = CreateDescriptorSetLayout(context, reduceBindings);
+
+	const VkPushConstantRange cullConstants = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullConstants) };
+
+	m_Pipelines->cull = vk::PipelineBuilder(context.device, PipelineType::COMPUTE, VertexBinding::NONE, 0)
+		.AddShader("../Engine/assets/shaders/cull.comp.spv", ShaderType::COMPUTE)
+		.SetPipelineLayout({ m_Pipelines->cullSetLayout }, cullConstants)
+		.BuildVariants(ShaderType::COMPUTE);
+
+	m_Pipelines->cull.Prepare(CullPhase(false));
+	m_Pipelines->cull.Prepare(CullPhase(true));
+
+	const VkPushConstantRange reduceConstants = { VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ReduceConstants) };
+
+	vk::PipelineBuilder(context.device, PipelineType::COMPUTE, VertexBinding::NONE, 0)
+		.AddShader("../Engine/assets/shaders/depth_reduce.comp.spv", ShaderType::COMPUTE)
+		.SetPipelineLayout({ m_Pipelines->reduceSetLayout }, reduceConstants)
+		.BuildDeferred(m_Pipelines->reduce, m_Pipelines->reduceLayout);
+}
+
+void vk::CullingView::CreatePyramid()
+{
+	// Level 0 texels cover 2x2 depth texels, the last row and column of an odd sized level fold in the leftover one
+	const uint32_t width = std::max(m_Depth.width / 2, 1u);
+	const uint32_t height = std::max(m_Depth.height / 2, 1u);
+	const uint32_t levels = std::min(ComputeMipLevels(width, height), MaxPyramidLevels);
+	m_Constants.pyramidLevels = levels;
+
+	m_Pyramid = CreateImageTexture2D(
+		m_Name + "_DepthPyramid",
+		context,
+		width,
+		height,
+		VK_FORMAT_R32_SFLOAT,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_IMAGE_ASPECT_COLOR_BIT,
+		levels
+	);
+
+	for (uint32_t level = 0; level < levels; level++)
+	{
+		VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+		viewInfo.image = m_Pyramid.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+
+		VkImageView view = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateImageView(context.device, &viewInfo, nullptr, &view), "Failed to create depth pyramid level view");
+		m_PyramidLevelViews.push_back(view);
+	}
+
+	// Kept in GENERAL from here on, it's written as a storage image and sampled in the same frame
+	ExecuteSingleTimeCommands(context, [&](VkCommandBuffer cmd)
+	{
+		BarrierBatch barriers;
+		barriers.Image(m_Pyramid.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+			VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+			VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+			{ VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1 });
+		barriers.Flush(cmd);
+	});
+}
+
+void vk::CullingView::WriteDescriptors()
+{
+	VkDescriptorBufferInfo drawInfo = { scene->GetDrawBuffer().buffer, 0, VK_WHOLE_SIZE };
+	UpdateDescriptorSet(context, 0, drawInfo, m_CullSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+	VkDescriptorBufferInfo boundsInfo = { scene->GetBoundsBuffer().buffer, 0, VK_WHOLE_SIZE };
+	UpdateDescriptorSet(context, 1, boundsInfo, m_CullSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+	VkDescriptorBufferInfo culledInfo = { m_DrawBuffer.buffer, 0, VK_WHOLE_SIZE };
+	UpdateDescriptorSet(context, 2, culledInfo, m_CullSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+	VkDescriptorBufferInfo countInfo = { m_DrawCountBuffer.buffer, 0, VK_WHOLE_SIZE };
+	UpdateDescriptorSet(context, 3, countInfo, m_CullSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+	VkDescriptorBufferInfo visibilityInfo = { m_VisibilityBuffer.buffer, 0, VK_WHOLE_SIZE };
+	UpdateDescriptorSet(context, 4, visibilityInfo, m_CullSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+	VkDescriptorImageInfo pyramidInfo = { m_PyramidSampler, m_Pyramid.imageView, VK_IMAGE_LAYOUT_GENERAL };
+	UpdateDescriptorSet(context, 5, pyramidInfo, m_CullSet, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
+	// Level 0 reduces the depth target, every other level the one above it
+	for (uint32_t level = 0; level < m_Constants.pyramidLevels; level++)
+	{
+		VkDescriptorImageInfo sourceInfo = level == 0 ?
+			VkDescriptorImageInfo{ m_PyramidSampler, m_Depth.imageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL } :
+			VkDescriptorImageInfo{ m_PyramidSampler, m_Pyramid.imageView, VK_IMAGE_LAYOUT_GENERAL };
+		UpdateDescriptorSet(context, 0, sourceInfo, m_ReduceSets[level], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+
+		VkDescriptorImageInfo levelInfo = { VK_NULL_HANDLE, m_PyramidLevelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+		UpdateDescriptorSet(context, 1, levelInfo, m_ReduceSets[level], VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+	}
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <volk/volk.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Buffer.hpp"
+#include "Image.hpp"
+#include "PipelineVariants.hpp"
+#include "Scene.hpp"
+
+// GPU culling of the scene's draws for one view (the camera or a light), in two phases around the view's depth pass:
+//  - Early: the draws that were visible last frame and are still in the frustum, drawn first.
+//  - Their depth is reduced into a Hi-Z pyramid, every texel keeps the farthest depth below it.
+//  - Late: every draw in the frustum is tested against the pyramid. The ones visible now that weren't drawn early are drawn
+//    as well, and which draws were visible is kept for the next frame's early phase.
+// Objects that come into view are drawn by the late phase of the frame they appear in, nothing pops in a frame late.
+// Survivors are compacted into the view's own indirect buffer with a count per list, passes draw them with DrawIndirectCount.
+// With gpuCulling off the view's draws come from CullOnCpu instead, frustum tests only, and both Cull calls do nothing.
+namespace vk
+{
+	class Context;
+
+	class CullingView
+	{
+	public:
+		enum class Phase
+		{
+			Early,
+			Late,
+			All
+		};
+
+		struct CpuStats
+		{
+			uint32_t visible = 0;
+			uint32_t culled = 0;
+		};
+
+		// depth is the target of the view's depth pass, it's read back by reference on Resize.
+		// Views of shadow casters find their draws on the CPU through the scene's BVH instead of the frustum culler.
+		CullingView(Context& context, std::shared_ptr<Scene> scene, Image& depth, const std::string& name, bool shadowCasters = false);
+		~CullingView();
+
+		// After the depth target was recreated
+		void Resize();
+
+		// Looks up both cull phase pipelines once PipelineCache::WaitForCompiles() returned,
+		// recording on the job system only binds them and never touches the variant cache.
+		// The pipelines are shared by every view, resolving them through any one of them resolves them for all.
+		void ResolvePipelines();
+
+		// Both record compute work and must be outside of rendering. CullLate needs the early draws' depth in
+		// DEPTH_STENCIL_READ_ONLY_OPTIMAL with the writes visible to the compute shader.
+		void CullEarly(VkCommandBuffer cmd, const glm::mat4& viewProjection);
+		void CullLate(VkCommandBuffer cmd);
+
+		// Frustum culls the scene's objects on the calling thread and writes the surviving draws into this frame's host
+		// visible list, drawn as the early phase. They're sorted front to back, then by material, with a radix sort
+		// spread over the job system. Views don't share any state, each can be culled on its own job.
+		void CullOnCpu(const glm::mat4& viewProjection);
+		const CpuStats& GetCpuStats() const { return m_CpuStats; }
+
+		const std::string& GetName() const { return m_Name; }
+
+		// Binds the scene's geometry and draws the surviving draws of the phase, one vkCmdDrawIndexedIndirectCount per list
+		void Draw(VkCommandBuffer cmd, Scene::DrawFilter filter, Phase phase = Phase::All);
+
+	private:
+		// Push constants of cull.comp
+		struct CullConstants
+		{
+			glm::mat4 viewProjection;
+			glm::vec2 depthSize;
+			uint32_t pyramidLevels;
+			uint32_t drawCount;
+			uint32_t opaqueDrawCount;
+		};
+
+		// Push constants of depth_reduce.comp
+		struct ReduceConstants
+		{
+			glm::ivec2 sourceSize;
+			int32_t sourceLevel;
+		};
+
+		void CreatePipelines();
+		void CreatePyramid();
+		void WriteDescriptors();
+		void DrawList(VkCommandBuffer cmd, uint32_t list, uint32_t first, uint32_t maxDrawCount);
+
+		Context& context;
+		std::shared_ptr<Scene> scene;
+		Image& m_Depth;
+		std::string m_Name;
+		bool m_ShadowCasters;
+
+		// Early lists then late lists, each with the opaque draws first like the scene's draw buffer.
+		// Counts are early opaque, early alpha masked, late opaque and late alpha masked.
+		Buffer m_DrawBuffer;
+		Buffer m_DrawCountBuffer;
+		Buffer m_VisibilityBuffer; // per scene draw, non-zero when it was visible last frame
+		CullConstants m_Constants;
+
+		Image m_Pyramid; // level 0 is half the depth's resolution, always in GENERAL
+		std::vector<VkImageView> m_PyramidLevelViews;
+		VkSampler m_PyramidSampler;
+
+		// Set layouts and pipelines of cull.comp and depth_reduce.comp, created by the first view and
+		// destroyed with the last one
+		struct SharedPipelines
+		{
+			~SharedPipelines();
+
+			VkDevice device = VK_NULL_HANDLE;
+			VkDescriptorSetLayout cullSetLayout = VK_NULL_HANDLE;
+			VkDescriptorSetLayout reduceSetLayout = VK_NULL_HANDLE;
+			PipelineVariants cull; // early and late phase, both prepared up front
+			VkPipeline earlyCull = VK_NULL_HANDLE;
+			VkPipeline lateCull = VK_NULL_HANDLE;
+			VkPipelineLayout reduceLayout = VK_NULL_HANDLE;
+			VkPipeline reduce = VK_NULL_HANDLE;
+		};
+
+		std::shared_ptr<SharedPipelines> m_Pipelines;
+		static inline std::weak_ptr<SharedPipelines> s_SharedPipelines;
+
+		VkDescriptorSet m_CullSet;
+		std::vector<VkDescriptorSet> m_ReduceSets; // one per pyramid level
+
+		std::vector<Buffer> m_CpuDrawBuffers; // per frame in flight, laid out like one phase of m_DrawBuffer
+		std::vector<VkDrawIndexedIndirectCommand> m_CpuDraws;
+		std::vector<uint8_t> m_CpuVisibility;
+		std::vector<uint32_t> m_CpuObjects; // scratch for the shadow caster query
+		std::vector<uint64_t> m_SortKeys; // visible draws in the order they're drawn, see DrawSortKey
+		std::vector<uint64_t> m_SortScratch;
+		uint32_t m_CpuOpaqueCount;
+		uint32_t m_CpuAlphaMaskedCount;
+		CpuStats m_CpuStats;
+	};
+}
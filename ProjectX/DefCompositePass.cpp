@@ -3,7 +3,7 @@
 #include "Pipeline.hpp"
 #include "Utils.hpp"
 #include "Buffer.hpp"
-#include "RenderPass.hpp"
+#include "Rendering.hpp"
 
 vk::DefCompositePass::DefCompositePass(Context& context, Image& defLightingPass, Image& BloomPass, const Image& SSRPass, const Image& SSAOPass) :
 	context{ context },
@@ -14,8 +14,7 @@ vk::DefCompositePass::DefCompositePass(Context& context, Image& defLightingPass,
 	m_Pipeline{ VK_NULL_HANDLE },
 	m_PipelineLayout{ VK_NULL_HANDLE },
 	m_descriptorSetLayout{ VK_NULL_HANDLE },
-	m_renderPass{ VK_NULL_HANDLE },
-	m_framebuffer{ VK_NULL_HANDLE },
+	m_descriptorUpdateTemplate{ VK_NULL_HANDLE },
 	m_width{ 0 },
 	m_height{ 0 }
 {
@@ -35,8 +34,6 @@ vk::DefCompositePass::DefCompositePass(Context& context, Image& defLightingPass,
 	);
 
 	BuildDescriptors();
-	CreateRenderPass();
-	CreateFramebuffer();
 	CreatePipeline();
 }
 
@@ -47,8 +44,8 @@ vk::DefCompositePass::~DefCompositePass()
 	vkDestroyPipeline(context.device, m_Pipeline, nullptr);
 	vkDestroyPipelineLayout(context.device, m_PipelineLayout, nullptr);
 
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-	vkDestroyRenderPass(context.device, m_renderPass, nullptr);
+	vkDestroyDescriptorUpdateTemplate(context.device, m_descriptorUpdateTemplate, nullptr);
+
 	vkDestroyDescriptorSetLayout(context.device, m_descriptorSetLayout, nullptr);
 }
 
@@ -57,8 +54,6 @@ void vk::DefCompositePass::Resize()
 	m_width = context.extent.width;
 	m_height = context.extent.height;
 
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-
 	m_RenderTarget.Destroy(context.device);
 
 	m_RenderTarget = CreateImageTexture2D(
@@ -71,56 +66,8 @@ void vk::DefCompositePass::Resize()
 		VK_IMAGE_ASPECT_COLOR_BIT,
 		1
 	);
-	CreateFramebuffer();
-
-
-	// DefLighting pass
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = defLightingPass.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 0, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	// Bloom pass
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = BloomPass.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 1, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = SSRPass.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 2, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = SSAOPass.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 3, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
 
+	WriteDescriptors();
 }
 
 
@@ -131,15 +78,10 @@ void vk::DefCompositePass::Execute(VkCommandBuffer cmd)
 	RenderPassLabel(cmd, "DefCompositePass");
 #endif // !DEBUG
 
-	VkRenderPassBeginInfo rpBegin{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-	rpBegin.renderPass = m_renderPass;
-	rpBegin.framebuffer = m_framebuffer;
-	rpBegin.renderArea.extent = { m_width, m_height };
+	BeginColorTarget(cmd, m_RenderTarget.image);
 
-	VkClearValue clearValues[1];
-	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	rpBegin.clearValueCount = 1;
-	rpBegin.pClearValues = clearValues;
+	RenderingInfo rendering({ m_width, m_height });
+	rendering.AddColorAttachment(m_RenderTarget.imageView, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -155,7 +97,7 @@ void vk::DefCompositePass::Execute(VkCommandBuffer cmd)
 	scissor.extent = { m_width, m_height };
 	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(cmd, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
+	rendering.Begin(cmd);
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
 
 	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_descriptorSets[currentFrame], 0, nullptr);
@@ -163,7 +105,9 @@ void vk::DefCompositePass::Execute(VkCommandBuffer cmd)
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
 	vkCmdDraw(cmd, 3, 1, 0, 0);
 
-	vkCmdEndRenderPass(cmd);
+	vkCmdEndRendering(cmd);
+
+	EndColorTarget(cmd, m_RenderTarget.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 #ifdef _DEBUG
 	EndRenderPassLabel(cmd);
@@ -178,7 +122,7 @@ void vk::DefCompositePass::Update()
 void vk::DefCompositePass::CreatePipeline()
 {
 	// Create the pipeline
-	auto pipelineResult = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
 		.AddShader("../Engine/assets/shaders/fs_tri.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/defComposite.frag.spv", ShaderType::FRAGMENT)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
@@ -188,46 +132,8 @@ void vk::DefCompositePass::CreatePipeline()
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
 		.AddBlendAttachmentState()
 		.SetDepthState(VK_FALSE, VK_FALSE, VK_COMPARE_OP_LESS_OR_EQUAL) // Turn depth read and write OFF ========
-		.SetRenderPass(m_renderPass)
-		.Build();
-
-	m_Pipeline = pipelineResult.first;
-	m_PipelineLayout = pipelineResult.second;
-}
-
-void vk::DefCompositePass::CreateRenderPass()
-{
-	RenderPass builder(context.device, 1);
-
-	m_renderPass = builder
-		.AddAttachment(VK_FORMAT_R16G16B16A16_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddColorAttachmentRef(0, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-		// External -> 0 : Color
-		.AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-		// 0 -> External : Color : Wait for color writing to finish on the attachment before the fragment shader tries to read from it
-		.AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-		.Build();
-
-	context.SetObjectName(context.device, (uint64_t)m_renderPass, VK_OBJECT_TYPE_RENDER_PASS, "DefCompositePassRenderPass");
-
-}
-
-void vk::DefCompositePass::CreateFramebuffer()
-{
-	std::vector<VkImageView> attachments = { m_RenderTarget.imageView };
-
-	VkFramebufferCreateInfo fbcInfo = {
-		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-		.renderPass = m_renderPass,
-		.attachmentCount = static_cast<uint32_t>(attachments.size()),
-		.pAttachments = attachments.data(),
-		.width = context.extent.width,
-		.height = context.extent.height,
-		.layers = 1
-	};
-
-	VK_CHECK(vkCreateFramebuffer(context.device, &fbcInfo, nullptr, &m_framebuffer), "Failed to create DefCompositePass pass framebuffer.");
+		.SetRenderingFormats({ VK_FORMAT_R16G16B16A16_SFLOAT })
+		.BuildDeferred(m_Pipeline, m_PipelineLayout);
 }
 
 void vk::DefCompositePass::BuildDescriptors()
@@ -243,53 +149,23 @@ void vk::DefCompositePass::BuildDescriptors()
 		};
 
 		m_descriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
+		m_descriptorUpdateTemplate = CreateDescriptorUpdateTemplate(context, m_descriptorSetLayout, bindings);
 
-		AllocateDescriptorSets(context, context.descriptorPool, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
-	}
-
-	// DefLighting pass
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = defLightingPass.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 0, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		AllocateDescriptorSets(context, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
 	}
 
-	// Bloom pass
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = BloomPass.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 1, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = SSRPass.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 2, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
+	WriteDescriptors();
+}
 
+void vk::DefCompositePass::WriteDescriptors()
+{
 	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
 	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = SSAOPass.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 3, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		UpdateDescriptorSet(context, m_descriptorUpdateTemplate, m_descriptorSets[i], {
+			DescriptorInfo(repeatSamplerAniso, defLightingPass.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			DescriptorInfo(repeatSamplerAniso, BloomPass.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			DescriptorInfo(repeatSamplerAniso, SSRPass.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			DescriptorInfo(repeatSamplerAniso, SSAOPass.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		});
 	}
 }
@@ -22,9 +22,8 @@ namespace vk
 
 	private:
 		void CreatePipeline();
-		void CreateRenderPass();
-		void CreateFramebuffer();
 		void BuildDescriptors();
+		void WriteDescriptors();
 
 		Context& context;
 		Image m_RenderTarget;
@@ -36,8 +35,7 @@ namespace vk
 		VkPipelineLayout m_PipelineLayout;
 		std::vector<VkDescriptorSet> m_descriptorSets;
 		VkDescriptorSetLayout m_descriptorSetLayout;
-		VkRenderPass m_renderPass;
-		VkFramebuffer m_framebuffer;
+		VkDescriptorUpdateTemplate m_descriptorUpdateTemplate;
 
 		uint32_t m_width;
 		uint32_t m_height;
@@ -4,20 +4,21 @@
 #include "baked_model.hpp"
 #include "Utils.hpp"
 #include "Buffer.hpp"
-#include "RenderPass.hpp"
+#include "Rendering.hpp"
 #include "Camera.hpp"
 
-vk::DefLighting::DefLighting(Context& context, std::shared_ptr<Camera>& camera, GBuffer::GBufferMRT& GBufferMRT, Image& shadowMap, std::shared_ptr<Scene> scene) :
+vk::DefLighting::DefLighting(Context& context, std::shared_ptr<Camera>& camera, GBuffer::GBufferMRT& GBufferMRT, Image& depth, Image& shadowMap, std::vector<Buffer>& shadowCascades, std::shared_ptr<Scene> scene) :
 	context{ context },
 	m_Pipeline{ VK_NULL_HANDLE },
 	m_PipelineLayout{ VK_NULL_HANDLE },
 	m_descriptorSetLayout{ VK_NULL_HANDLE },
-	m_renderPass{ VK_NULL_HANDLE },
-	m_framebuffer{ VK_NULL_HANDLE },
+	m_descriptorUpdateTemplate{ VK_NULL_HANDLE },
 	m_width{ 0 },
 	m_height{ 0 },
 	GBufferMRT{ GBufferMRT },
+	m_depth{ depth },
 	m_shadowMap{shadowMap},
+	m_shadowCascades{shadowCascades},
 	scene{scene},
 	camera { camera }
 {
@@ -38,19 +39,15 @@ vk::DefLighting::DefLighting(Context& context, std::shared_ptr<Camera>& camera,
 		1
 	);
 
-	m_RenderTargetBrightness = CreateImageTexture2D(
+	m_RenderTargetBrightness = context.transientAllocator->CreateImage(
 		"DefLighting_BrightnessRT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_R16G16B16A16_SFLOAT,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	CreateRenderPass();
-	CreateFramebuffer();
 	CreatePipeline();
 }
 
@@ -59,11 +56,9 @@ vk::DefLighting::~DefLighting()
 	m_RenderTarget.Destroy(context.device);
 	m_RenderTargetBrightness.Destroy(context.device);
 
-	vkDestroyPipeline(context.device, m_Pipeline, nullptr);
-	vkDestroyPipelineLayout(context.device, m_PipelineLayout, nullptr);
+	m_PipelineVariants.Destroy();
 
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-	vkDestroyRenderPass(context.device, m_renderPass, nullptr);
+	vkDestroyDescriptorUpdateTemplate(context.device, m_descriptorUpdateTemplate, nullptr);
 	vkDestroyDescriptorSetLayout(context.device, m_descriptorSetLayout, nullptr);
 }
 
@@ -72,8 +67,6 @@ void vk::DefLighting::Resize()
 	m_width = context.extent.width;
 	m_height = context.extent.height;
 
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-
 	m_RenderTarget.Destroy(context.device);
 	m_RenderTargetBrightness.Destroy(context.device);
 
@@ -88,92 +81,16 @@ void vk::DefLighting::Resize()
 		1
 	);
 
-	m_RenderTargetBrightness = CreateImageTexture2D(
+	m_RenderTargetBrightness = context.transientAllocator->CreateImage(
 		"DefLighting_BrightnessRT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_R16G16B16A16_SFLOAT,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	CreateFramebuffer();
-
-
-	// Depth
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.DepthTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 2, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	// Albedo
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.AlbedoTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 3, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	// Normal
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.NormalTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 4, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	// Roughness & Metallic
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.MetRoughnessTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 5, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-
-	// Emissive
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.EmissiveTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 6, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	// Shadow map
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = clampToEdgeSamplerAniso,
-			.imageView = m_shadowMap.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 7, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
+	WriteDescriptors();
 }
 
 
@@ -184,16 +101,14 @@ void vk::DefLighting::Execute(VkCommandBuffer cmd)
 	RenderPassLabel(cmd, "DefLightingPass");
 #endif // !DEBUG
 
-	VkRenderPassBeginInfo rpBegin{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
-	rpBegin.renderPass = m_renderPass;
-	rpBegin.framebuffer = m_framebuffer;
-	rpBegin.renderArea.extent = { m_width, m_height };
+	BarrierBatch barriers;
+	BeginColorTarget(barriers, m_RenderTarget.image);
+	BeginColorTarget(barriers, m_RenderTargetBrightness.image);
+	barriers.Flush(cmd);
 
-	VkClearValue clearValues[2];
-	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	clearValues[1].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	rpBegin.clearValueCount = 2;
-	rpBegin.pClearValues = clearValues;
+	RenderingInfo rendering({ m_width, m_height });
+	rendering.AddColorAttachment(m_RenderTarget.imageView, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+	rendering.AddColorAttachment(m_RenderTargetBrightness.imageView, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -209,7 +124,7 @@ void vk::DefLighting::Execute(VkCommandBuffer cmd)
 	scissor.extent = { m_width, m_height };
 	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(cmd, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
+	rendering.Begin(cmd);
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
 
 	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_descriptorSets[currentFrame], 0, nullptr);
@@ -217,7 +132,11 @@ void vk::DefLighting::Execute(VkCommandBuffer cmd)
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
 	vkCmdDraw(cmd, 3, 1, 0, 0);
 
-	vkCmdEndRenderPass(cmd);
+	vkCmdEndRendering(cmd);
+
+	EndColorTarget(barriers, m_RenderTarget.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	EndColorTarget(barriers, m_RenderTargetBrightness.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	barriers.Flush(cmd);
 
 #ifdef _DEBUG
 	EndRenderPassLabel(cmd);
@@ -227,13 +146,20 @@ void vk::DefLighting::Execute(VkCommandBuffer cmd)
 
 void vk::DefLighting::Update()
 {
+	// The shadow filter kernel is compiled into the shader, a new size switches to (or compiles) its variant
+	m_Pipeline = m_PipelineVariants.Get(GetSpecialization());
+}
 
+vk::SpecializationConstants vk::DefLighting::GetSpecialization() const
+{
+	return SpecializationConstants()
+		.Set(0, lightingSettings.PCFRange);
 }
 
 void vk::DefLighting::CreatePipeline()
 {
 	// Create the pipeline
-	auto pipelineResult = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
+	vk::PipelineBuilder builder = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
 		.AddShader("../Engine/assets/shaders/fs_tri.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/defLighting.frag.spv", ShaderType::FRAGMENT) //TODO: THIS IS RUNNING TEST SHADER AND NOT ACTUAL DEFLIGHTING SHADER
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
@@ -244,49 +170,12 @@ void vk::DefLighting::CreatePipeline()
 		.AddBlendAttachmentState()
 		.AddBlendAttachmentState()
 		.SetDepthState(VK_FALSE, VK_FALSE, VK_COMPARE_OP_LESS_OR_EQUAL) // Turn depth read and write OFF ========
-		.SetRenderPass(m_renderPass)
-		.Build();
-
-	m_Pipeline = pipelineResult.first;
-	m_PipelineLayout = pipelineResult.second;
-}
-
-void vk::DefLighting::CreateRenderPass()
-{
-	RenderPass builder(context.device, 1);
-
-	m_renderPass = builder
-		.AddAttachment(VK_FORMAT_R16G16B16A16_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddAttachment(VK_FORMAT_R16G16B16A16_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddColorAttachmentRef(0, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-		.AddColorAttachmentRef(0, 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-		// External -> 0 : Color
-		//.AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-		.AddDependency(VK_SUBPASS_EXTERNAL, 0,  VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
+		.SetRenderingFormats({ VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT });
 
-		// 0 -> External : Color : Wait for color writing to finish on the attachment before the fragment shader tries to read from it
-		.AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-		.Build();
-
-	//context.SetObjectName(context.device, (uint64_t)m_renderPass, VK_OBJECT_TYPE_RENDER_PASS, "DefLightingRenderPass");
+	m_PipelineVariants = builder.BuildVariants(ShaderType::FRAGMENT);
+	m_PipelineVariants.Prepare(GetSpecialization());
 
-}
-
-void vk::DefLighting::CreateFramebuffer()
-{
-	std::vector<VkImageView> attachments = { m_RenderTarget.imageView, m_RenderTargetBrightness.imageView };
-
-	VkFramebufferCreateInfo fbcInfo = {
-		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-		.renderPass = m_renderPass,
-		.attachmentCount = static_cast<uint32_t>(attachments.size()),
-		.pAttachments = attachments.data(),
-		.width = context.extent.width,
-		.height = context.extent.height,
-		.layers = 1
-	};
-
-	VK_CHECK(vkCreateFramebuffer(context.device, &fbcInfo, nullptr, &m_framebuffer), "Failed to create DefLighting pass framebuffer.");
+	m_PipelineLayout = m_PipelineVariants.GetLayout();
 }
 
 void vk::DefLighting::BuildDescriptors()
@@ -302,104 +191,34 @@ void vk::DefLighting::BuildDescriptors()
 			CreateDescriptorBinding(4, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT),
 			CreateDescriptorBinding(5, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT),
 			CreateDescriptorBinding(6, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT),
-			CreateDescriptorBinding(7, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+			CreateDescriptorBinding(7, 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT), // Shadow cascades
+			CreateDescriptorBinding(8, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT) // Shadow cascades UBO
 		};
 
 		m_descriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
 
-		AllocateDescriptorSets(context, context.descriptorPool, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
-	}
-
-	// Camera Transform UBO
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = camera->GetBuffers()[i].buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(CameraTransform);
-		UpdateDescriptorSet(context, 0, bufferInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+		AllocateDescriptorSets(context, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
+		m_descriptorUpdateTemplate = CreateDescriptorUpdateTemplate(context, m_descriptorSetLayout, bindings);
 	}
 
-	// Light UBO
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = scene->GetLightsUBO()[i].buffer; // m_LightUBO[i].buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(LightBuffer);
-		UpdateDescriptorSet(context, 1, bufferInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-	}
-
-	// Depth
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.DepthTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 2, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	// Albedo
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.AlbedoTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
 
-		UpdateDescriptorSet(context, 3, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	// Normal
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.NormalTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 4, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-	// Roughness & Metallic
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.MetRoughnessTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 5, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
-
-
-	// Emissive
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = repeatSamplerAniso,
-			.imageView = GBufferMRT.EmissiveTarget.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 6, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
+	WriteDescriptors();
+}
 
-	// Shadow map
+void vk::DefLighting::WriteDescriptors()
+{
 	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
 	{
-		VkDescriptorImageInfo imageInfo = {
-			.sampler = clampToEdgeSamplerAniso,
-			.imageView = m_shadowMap.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 7, imageInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		UpdateDescriptorSet(context, m_descriptorUpdateTemplate, m_descriptorSets[i], {
+			DescriptorInfo(camera->GetBuffers()[i].buffer, sizeof(CameraTransform)),
+			DescriptorInfo(scene->GetLightsUBO()[i].buffer, sizeof(LightBuffer)),
+			DescriptorInfo(repeatSamplerAniso, m_depth.imageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL),
+			DescriptorInfo(repeatSamplerAniso, GBufferMRT.AlbedoTarget.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			DescriptorInfo(repeatSamplerAniso, GBufferMRT.NormalTarget.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			DescriptorInfo(repeatSamplerAniso, GBufferMRT.MetRoughnessTarget.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			DescriptorInfo(repeatSamplerAniso, GBufferMRT.EmissiveTarget.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+			DescriptorInfo(clampToEdgeSamplerAniso, m_shadowMap.imageView, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL),
+			DescriptorInfo(m_shadowCascades[i].buffer, sizeof(ShadowCascadesUBO))
+		});
 	}
 }
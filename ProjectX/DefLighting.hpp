@@ -5,6 +5,7 @@
 #include "GBuffer.hpp"
 #include "Light.hpp"
 #include "Scene.hpp"
+#include "PipelineVariants.hpp"
 
 namespace vk
 {
@@ -14,7 +15,9 @@ namespace vk
 	class DefLighting
 	{
 	public:
-		explicit DefLighting(Context& context, std::shared_ptr<Camera>& camera, GBuffer::GBufferMRT& GBufferMRT, Image& shadowMap, std::shared_ptr<Scene> scene);
+		// depth is the GBuffer's depth, its own target or the prepass depth it reused.
+		// shadowCascades are the shadow map's per frame cascade UBOs, which layer covers which part of the view.
+		explicit DefLighting(Context& context, std::shared_ptr<Camera>& camera, GBuffer::GBufferMRT& GBufferMRT, Image& depth, Image& shadowMap, std::vector<Buffer>& shadowCascades, std::shared_ptr<Scene> scene);
 		~DefLighting();
 
 		void Execute(VkCommandBuffer cmd);
@@ -26,26 +29,28 @@ namespace vk
 
 	private:
 		void CreatePipeline();
-		void CreateRenderPass();
-		void CreateFramebuffer();
 		void BuildDescriptors();
+		void WriteDescriptors(); // again after a resize, the GBuffer targets are recreated
+		SpecializationConstants GetSpecialization() const;
 
 		Context& context;
 		Image m_RenderTarget;
 		Image m_RenderTargetBrightness;
 
-		VkPipeline m_Pipeline;
+		PipelineVariants m_PipelineVariants;
+		VkPipeline m_Pipeline; // variant matching the current settings
 		VkPipelineLayout m_PipelineLayout;
 		std::vector<VkDescriptorSet> m_descriptorSets;
 		VkDescriptorSetLayout m_descriptorSetLayout;
-		VkRenderPass m_renderPass;
-		VkFramebuffer m_framebuffer;
+		VkDescriptorUpdateTemplate m_descriptorUpdateTemplate;
 
 		uint32_t m_width;
 		uint32_t m_height;
 
 		GBuffer::GBufferMRT& GBufferMRT;
+		Image& m_depth;
 		Image& m_shadowMap;
+		std::vector<Buffer>& m_shadowCascades;
 
 		std::shared_ptr<Scene> scene;
 		std::shared_ptr<Camera> camera;		
@@ -4,7 +4,8 @@
 #include "Camera.hpp"
 #include "DepthPrepass.hpp"
 #include "Pipeline.hpp"
-#include "RenderPass.hpp"
+#include "Rendering.hpp"
+#include "CullingView.hpp"
 
 
 vk::DepthPrepass::DepthPrepass(Context& context, std::shared_ptr<Scene> scene, std::shared_ptr<Camera> camera) :
@@ -13,10 +14,10 @@ vk::DepthPrepass::DepthPrepass(Context& context, std::shared_ptr<Scene> scene, s
 	camera{camera},
 	m_Pipeline{VK_NULL_HANDLE},
 	m_PipelineLayout{ VK_NULL_HANDLE },
+	m_AlphaMaskingPipeline{ VK_NULL_HANDLE },
+	m_AlphaMaskingPipelineLayout{ VK_NULL_HANDLE },
 	m_descriptorSetLayout{VK_NULL_HANDLE},
 	m_descriptorSets{},
-	m_renderPass{ VK_NULL_HANDLE },
-	m_framebuffer{VK_NULL_HANDLE},
 	m_width{  0 },
 	m_height{ 0 }
 {
@@ -32,8 +33,8 @@ vk::DepthPrepass::DepthPrepass(Context& context, std::shared_ptr<Scene> scene, s
 		1
 	);
 
-	CreateRenderPass();
-	CreateFramebuffer();
+	m_CullingView = std::make_unique<CullingView>(context, scene, m_DepthTarget, "Camera");
+
 	BuildDescriptors();
 	CreatePipeline();
 }
@@ -44,8 +45,8 @@ vk::DepthPrepass::~DepthPrepass()
 
 	vkDestroyPipeline(context.device, m_Pipeline, nullptr);
 	vkDestroyPipelineLayout(context.device, m_PipelineLayout, nullptr);
-	vkDestroyRenderPass(context.device, m_renderPass, nullptr);
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
+	vkDestroyPipeline(context.device, m_AlphaMaskingPipeline, nullptr);
+	vkDestroyPipelineLayout(context.device, m_AlphaMaskingPipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(context.device, m_descriptorSetLayout, nullptr);
 }
 
@@ -64,9 +65,7 @@ void vk::DepthPrepass::Resize()
 		1
 	);
 
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-
-	CreateFramebuffer();
+	m_CullingView->Resize();
 }
 
 void vk::DepthPrepass::Execute(VkCommandBuffer cmd)
@@ -75,16 +74,13 @@ void vk::DepthPrepass::Execute(VkCommandBuffer cmd)
 	RenderPassLabel(cmd, "DepthPrepass");
 #endif // !DEBUG
 
-	VkRenderPassBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	beginInfo.renderPass = m_renderPass;
-	beginInfo.framebuffer = m_framebuffer;
-	beginInfo.renderArea.extent = context.extent;
+	const CameraTransform& transform = camera->GetCameraTransform();
+	m_CullingView->CullEarly(cmd, transform.projection * transform.view);
 
-	VkClearValue clearValues[1];
-	clearValues[0].depthStencil.depth = { 1.0f };
-	beginInfo.clearValueCount = 1;
-	beginInfo.pClearValues = clearValues;
+	BeginDepthTarget(cmd, m_DepthTarget.image);
+
+	RenderingInfo rendering(context.extent);
+	rendering.SetDepthAttachment(m_DepthTarget.imageView, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -100,17 +96,36 @@ void vk::DepthPrepass::Execute(VkCommandBuffer cmd)
 	scissor.extent = { context.extent.width, context.extent.height };
 	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	rendering.Begin(cmd);
+	// Set 2 has the objects for the vertex shader and the materials for the alpha mask, set 1 the textures they index
+	VkDescriptorSet sets[] = { m_descriptorSets[currentFrame], context.bindlessTextures->GetSet(), scene->GetDrawDataSet() };
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 3, sets, 0, nullptr);
+
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
-	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_descriptorSets[currentFrame], 0, nullptr);
+	m_CullingView->Draw(cmd, Scene::DrawFilter::Opaque, CullingView::Phase::Early);
 
-	// Draw front freshes
-	scene->RenderFrontMeshes(cmd, m_PipelineLayout);
-	
-	// Doing depth-prepass on alpha masking objects will mean discard will break later
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_AlphaMaskingPipeline);
+	m_CullingView->Draw(cmd, Scene::DrawFilter::AlphaMasked, CullingView::Phase::Early);
+	vkCmdEndRendering(cmd);
+
+	// Occluders drawn so far decide what else is visible, the late draws complete the depth
+	EndDepthTarget(cmd, m_DepthTarget.image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+	m_CullingView->CullLate(cmd);
+	ResumeDepthTarget(cmd, m_DepthTarget.image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+
+	RenderingInfo lateRendering(context.extent);
+	lateRendering.SetDepthAttachment(m_DepthTarget.imageView, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE);
+	lateRendering.Begin(cmd);
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
-	scene->RenderBackMeshes(cmd, m_PipelineLayout);
-	vkCmdEndRenderPass(cmd);
+	m_CullingView->Draw(cmd, Scene::DrawFilter::Opaque, CullingView::Phase::Late);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_AlphaMaskingPipeline);
+	m_CullingView->Draw(cmd, Scene::DrawFilter::AlphaMasked, CullingView::Phase::Late);
+	vkCmdEndRendering(cmd);
+
+	// Tested against by the mesh density pass and the GBuffer, sampled by the lighting passes when the GBuffer reuses it
+	EndDepthTarget(cmd, m_DepthTarget.image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT);
 
 #ifdef _DEBUG
 	EndRenderPassLabel(cmd);
@@ -119,56 +134,28 @@ void vk::DepthPrepass::Execute(VkCommandBuffer cmd)
 
 void vk::DepthPrepass::CreatePipeline()
 {
-	VkPushConstantRange pushConstantRange = {
-		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_GEOMETRY_BIT,
-		.offset = 0,
-		.size = sizeof(MeshPushConstants)
-	};
-
-	auto pipelineResult = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
 		.AddShader("../Engine/assets/shaders/default.vert.spv", ShaderType::VERTEX)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
 		.SetDynamicState({ {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR} })
 		.SetRasterizationState(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
-		.SetPipelineLayout({ {m_descriptorSetLayout} }, pushConstantRange)
+		.SetPipelineLayout({ m_descriptorSetLayout, context.bindlessTextures->GetLayout(), scene->GetDrawDataLayout() })
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
-		.AddBlendAttachmentState()
 		.SetDepthState(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL) // Depth write and test enabled 
-		.SetRenderPass(m_renderPass)
-		.Build();
-
-	m_Pipeline = pipelineResult.first;
-	m_PipelineLayout = pipelineResult.second;
-}
-
-void vk::DepthPrepass::CreateRenderPass()
-{
-	RenderPass builder(context.device, 1);
-
-	m_renderPass = builder
-		.AddAttachment(VK_FORMAT_D32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
-		.SetDepthAttachmentRef(0, 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-		.AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT)
-		.AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT)
-		.Build();
-}
+		.SetRenderingFormats({}, VK_FORMAT_D32_SFLOAT)
+		.BuildDeferred(m_Pipeline, m_PipelineLayout);
 
-void vk::DepthPrepass::CreateFramebuffer()
-{
-
-	std::vector<VkImageView> attachments = { m_DepthTarget.imageView };
-
-	VkFramebufferCreateInfo fbcInfo = {
-		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-		.renderPass = m_renderPass,
-		.attachmentCount = static_cast<uint32_t>(attachments.size()),
-		.pAttachments = attachments.data(),
-		.width = context.extent.width,
-		.height = context.extent.height,
-		.layers = 1
-	};
-
-	VK_CHECK(vkCreateFramebuffer(context.device, &fbcInfo, nullptr, &m_framebuffer), "Failed to create depth pre-pass framebuffer.");
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
+		.AddShader("../Engine/assets/shaders/default.vert.spv", ShaderType::VERTEX)
+		.AddShader("../Engine/assets/shaders/depth_alpha.frag.spv", ShaderType::FRAGMENT)
+		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+		.SetDynamicState({ {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR} })
+		.SetRasterizationState(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
+		.SetPipelineLayout({ m_descriptorSetLayout, context.bindlessTextures->GetLayout(), scene->GetDrawDataLayout() })
+		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
+		.SetDepthState(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL)
+		.SetRenderingFormats({}, VK_FORMAT_D32_SFLOAT)
+		.BuildDeferred(m_AlphaMaskingPipeline, m_AlphaMaskingPipelineLayout);
 }
 
 void vk::DepthPrepass::BuildDescriptors()
@@ -177,11 +164,12 @@ void vk::DepthPrepass::BuildDescriptors()
 	{
 		std::vector<VkDescriptorSetLayoutBinding> bindings = {
 			CreateDescriptorBinding(0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT),
+			CreateDescriptorBinding(2, 1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) // Anisotropic sampler for the alpha mask
 		};
 
 		m_descriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
 
-		AllocateDescriptorSets(context, context.descriptorPool, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
+		AllocateDescriptorSets(context, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
 	}
 
 	// Camera Transform UBO
@@ -193,4 +181,13 @@ void vk::DepthPrepass::BuildDescriptors()
 		bufferInfo.range = sizeof(CameraTransform);
 		UpdateDescriptorSet(context, 0, bufferInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 	}
+
+	// Anisotropic sampler
+	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
+	{
+		VkDescriptorImageInfo imgInfo = {
+			.sampler = repeatSamplerAniso
+		};
+		UpdateDescriptorSet(context, 2, imgInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_SAMPLER);
+	}
 }
\ No newline at end of file
@@ -10,6 +10,7 @@ namespace vk
 	class Scene;
 	class Image;
 	class Camera;
+	class CullingView;
 	class DepthPrepass
 	{	
 	public:
@@ -21,23 +22,26 @@ namespace vk
 		void Resize();
 
 		Image& GetRenderTarget() { return m_DepthTarget; };
+		// The camera's culled draw lists, every pass drawing the scene from the camera uses them
+		CullingView& GetCullingView() { return *m_CullingView; }
 	private:
 		void CreatePipeline();
-		void CreateRenderPass();
-		void CreateFramebuffer();
 		void BuildDescriptors();
 		
 		Context& context;
 		std::shared_ptr<Scene> scene;
 		std::shared_ptr<Camera> camera;
 		Image m_DepthTarget;
+		std::unique_ptr<CullingView> m_CullingView;
 
 		VkPipeline m_Pipeline;
 		VkPipelineLayout m_PipelineLayout;
+
+		// Discards the transparent texels of alpha masked materials, the GBuffer's EQUAL test relies on it
+		VkPipeline m_AlphaMaskingPipeline;
+		VkPipelineLayout m_AlphaMaskingPipelineLayout;
 		VkDescriptorSetLayout m_descriptorSetLayout;
 		std::vector<VkDescriptorSet> m_descriptorSets;
-		VkRenderPass m_renderPass;
-		VkFramebuffer m_framebuffer;
 
 		uint32_t m_width;
 		uint32_t m_height;
@@ -0,0 +1,97 @@
+#include "DescriptorAllocator.hpp"
+#include "Context.hpp"
+#include "Utils.hpp"
+
+#include <string>
+
+namespace
+{
+	// Descriptors of each type per set, roughly what the passes use on average
+	constexpr struct { VkDescriptorType type; float perSet; } PoolRatios[] = {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f }
+	};
+}
+
+vk::DescriptorAllocator::DescriptorAllocator(Context& context, uint32_t setsPerPool, const char* name) :
+	context{context}, m_SetsPerPool{setsPerPool}, m_Name{name}, m_CurrentPool{0}
+{
+	m_Pools.push_back(CreatePool());
+}
+
+void vk::DescriptorAllocator::Destroy()
+{
+	for (VkDescriptorPool pool : m_Pools)
+	{
+		vkDestroyDescriptorPool(context.device, pool, nullptr);
+	}
+
+	m_Pools.clear();
+	m_CurrentPool = 0;
+}
+
+void vk::DescriptorAllocator::Allocate(VkDescriptorSetLayout layout, uint32_t setCount, VkDescriptorSet* descriptorSets)
+{
+	std::vector<VkDescriptorSetLayout> setLayouts(setCount, layout);
+
+	VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	allocInfo.descriptorSetCount = setCount;
+	allocInfo.pSetLayouts = setLayouts.data();
+
+	bool freshPool = false;
+	while (true)
+	{
+		allocInfo.descriptorPool = m_Pools[m_CurrentPool];
+
+		VkResult result = vkAllocateDescriptorSets(context.device, &allocInfo, descriptorSets);
+		if (result == VK_SUCCESS)
+			return;
+
+		// An empty pool that can't hold the sets never will, the request needs more than one pool's worth
+		if ((result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) || freshPool)
+		{
+			throw std::runtime_error("Failed to allocate " + std::to_string(setCount) + " descriptor sets from " + m_Name);
+		}
+
+		m_CurrentPool++;
+		if (m_CurrentPool == m_Pools.size())
+		{
+			m_Pools.push_back(CreatePool());
+			freshPool = true;
+		}
+	}
+}
+
+VkDescriptorSet vk::DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+{
+	VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+	Allocate(layout, 1, &descriptorSet);
+
+	return descriptorSet;
+}
+
+VkDescriptorPool vk::DescriptorAllocator::CreatePool()
+{
+	std::vector<VkDescriptorPoolSize> poolSizes;
+	for (const auto& ratio : PoolRatios)
+	{
+		poolSizes.push_back({ ratio.type, static_cast<uint32_t>(ratio.perSet * m_SetsPerPool) });
+	}
+
+	VkDescriptorPoolCreateInfo info{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	info.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	info.pPoolSizes = poolSizes.data();
+	info.maxSets = m_SetsPerPool;
+
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VK_CHECK(vkCreateDescriptorPool(context.device, &info, nullptr, &pool), "Failed to create descriptor pool");
+
+	const std::string poolName = std::string(m_Name) + " " + std::to_string(m_Pools.size());
+	context.SetObjectName(context.device, (uint64_t)pool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, poolName.c_str());
+
+	return pool;
+}
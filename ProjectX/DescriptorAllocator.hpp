@@ -0,0 +1,32 @@
+#pragma once
+#include <volk/volk.h>
+#include <cstdint>
+#include <vector>
+
+// Descriptor sets come from a list of pools instead of one fixed pool. When a pool runs out of sets or of a descriptor
+// type another one is created, so adding a pass or a binding never needs the pool sizes to be retuned by hand.
+namespace vk
+{
+	class Context;
+
+	class DescriptorAllocator
+	{
+	public:
+		DescriptorAllocator(Context& context, uint32_t setsPerPool, const char* name);
+		void Destroy();
+
+		void Allocate(VkDescriptorSetLayout layout, uint32_t setCount, VkDescriptorSet* descriptorSets);
+		VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+
+		size_t GetPoolCount() const { return m_Pools.size(); }
+
+	private:
+		VkDescriptorPool CreatePool();
+
+		Context& context;
+		uint32_t m_SetsPerPool;
+		const char* m_Name;
+		std::vector<VkDescriptorPool> m_Pools;
+		size_t m_CurrentPool; // pools before this one are known to be full
+	};
+}
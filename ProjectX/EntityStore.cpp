@@ -0,0 +1,106 @@
+#include "EntityStore.hpp"
+
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENTITY_STORE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	// parent * local, column major like glm: every column of the result is the parent's columns weighted by the local column
+	void MultiplyTransform(const glm::mat4& parent, const glm::mat4& local, glm::mat4& world)
+	{
+#if defined(ENTITY_STORE_SSE)
+		const float* a = &parent[0][0];
+		const float* b = &local[0][0];
+		float* result = &world[0][0];
+
+		const __m128 a0 = _mm_loadu_ps(a + 0);
+		const __m128 a1 = _mm_loadu_ps(a + 4);
+		const __m128 a2 = _mm_loadu_ps(a + 8);
+		const __m128 a3 = _mm_loadu_ps(a + 12);
+
+		for (int column = 0; column < 4; column++)
+		{
+			const float* weights = b + column * 4;
+			__m128 sum = _mm_mul_ps(a0, _mm_set1_ps(weights[0]));
+			sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(weights[1])));
+			sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(weights[2])));
+			sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(weights[3])));
+			_mm_storeu_ps(result + column * 4, sum);
+		}
+#else
+		world = parent * local;
+#endif
+	}
+}
+
+vk::Entity vk::EntityStore::CreateEntity(const glm::mat4& local, Entity parent)
+{
+	const Entity entity = static_cast<Entity>(m_Parent.size());
+	if (parent != NullEntity && parent >= entity)
+		throw std::runtime_error("An entity's parent has to be created before it");
+
+	m_Parent.push_back(parent);
+	m_Local.push_back(local);
+	m_World.push_back(local);
+	m_Dirty.push_back(1);
+	m_InstanceRow.push_back(UINT32_MAX);
+
+	return entity;
+}
+
+vk::Entity vk::EntityStore::CreateModelInstance(const glm::mat4& local, uint32_t model, uint32_t copy, Entity parent)
+{
+	const Entity entity = CreateEntity(local, parent);
+
+	m_InstanceRow[entity] = static_cast<uint32_t>(m_InstanceEntity.size());
+	m_InstanceEntity.push_back(entity);
+	m_InstanceModel.push_back(model);
+	m_InstanceCopy.push_back(copy);
+
+	return entity;
+}
+
+void vk::EntityStore::SetLocalTransform(Entity entity, const glm::mat4& local)
+{
+	m_Local[entity] = local;
+	m_Dirty[entity] = 1;
+}
+
+void vk::EntityStore::UpdateTransforms()
+{
+	m_Changed.clear();
+
+	// Parents come first, by the time an entity is reached its parent's world transform and dirty flag are final
+	const size_t count = m_Parent.size();
+	for (size_t entity = 0; entity < count; entity++)
+	{
+		const Entity parent = m_Parent[entity];
+		if (parent != NullEntity)
+		{
+			m_Dirty[entity] |= m_Dirty[parent];
+		}
+
+		if (!m_Dirty[entity])
+			continue;
+
+		if (parent == NullEntity)
+		{
+			m_World[entity] = m_Local[entity];
+		}
+		else
+		{
+			MultiplyTransform(m_World[parent], m_Local[entity], m_World[entity]);
+		}
+
+		m_Changed.push_back(static_cast<Entity>(entity));
+	}
+
+	for (Entity entity : m_Changed)
+	{
+		m_Dirty[entity] = 0;
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Scene entities as structure of arrays. Every entity has a transform (local, world, parent), the components an entity
+// has on top decide which table (archetype) it also lives in, each table keeping its components in dense columns.
+// Parents are always created before their children, so a single forward pass over the columns updates whole hierarchies.
+namespace vk
+{
+	using Entity = uint32_t;
+	inline constexpr Entity NullEntity = UINT32_MAX;
+
+	class EntityStore
+	{
+	public:
+		Entity CreateEntity(const glm::mat4& local, Entity parent = NullEntity);
+		// Also an instance of a model: copy is the index of the copy among the model's instances
+		Entity CreateModelInstance(const glm::mat4& local, uint32_t model, uint32_t copy, Entity parent = NullEntity);
+
+		// Marks the entity dirty, its world transform and the ones of its descendants follow on the next UpdateTransforms
+		void SetLocalTransform(Entity entity, const glm::mat4& local);
+
+		const glm::mat4& GetLocalTransform(Entity entity) const { return m_Local[entity]; }
+		const glm::mat4& GetWorldTransform(Entity entity) const { return m_World[entity]; }
+		Entity			 GetParent(Entity entity) const { return m_Parent[entity]; }
+		uint32_t		 GetEntityCount() const { return static_cast<uint32_t>(m_Parent.size()); }
+
+		// Recomputes the world transform of every dirty entity and their descendants, only those.
+		// The entities updated are kept for the ForEachChanged* calls until the next update.
+		void UpdateTransforms();
+
+		// function(model, copy, world) for every model instance
+		template <typename Function>
+		void ForEachModelInstance(Function&& function) const
+		{
+			for (size_t row = 0; row < m_InstanceEntity.size(); row++)
+			{
+				function(m_InstanceModel[row], m_InstanceCopy[row], m_World[m_InstanceEntity[row]]);
+			}
+		}
+
+		// function(model, copy, world) for every model instance the last UpdateTransforms moved
+		template <typename Function>
+		void ForEachChangedModelInstance(Function&& function) const
+		{
+			for (Entity entity : m_Changed)
+			{
+				const uint32_t row = m_InstanceRow[entity];
+				if (row != UINT32_MAX)
+				{
+					function(m_InstanceModel[row], m_InstanceCopy[row], m_World[entity]);
+				}
+			}
+		}
+
+		bool HasChanges() const { return !m_Changed.empty(); }
+
+	private:
+		// Transform, every entity
+		std::vector<Entity> m_Parent;
+		std::vector<glm::mat4> m_Local;
+		std::vector<glm::mat4> m_World;
+		std::vector<uint8_t> m_Dirty;
+		std::vector<uint32_t> m_InstanceRow; // row in the model instance table, UINT32_MAX when the entity isn't one
+
+		// Model instance table
+		std::vector<Entity> m_InstanceEntity;
+		std::vector<uint32_t> m_InstanceModel;
+		std::vector<uint32_t> m_InstanceCopy;
+
+		std::vector<Entity> m_Changed;
+	};
+}
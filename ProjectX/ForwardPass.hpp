@@ -10,12 +10,13 @@ namespace vk
 	class Context;
 	class Scene;
 	class Buffer;
+	class CullingView;
 
 	class ForwardPass
 	{
 	public:
 
-		ForwardPass(Context& context, Image& shadowMap, Image& depthPrepass, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera);
+		ForwardPass(Context& context, Image& shadowMap, Image& depthPrepass, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera, CullingView& cullingView);
 		~ForwardPass();
 		void Execute(VkCommandBuffer cmd);
 		void Update();
@@ -25,14 +26,10 @@ namespace vk
 
 	private:
 		void CreatePipeline();
-		void CreateRenderPass();
-		void CreateFramebuffer();
 		void BuildDescriptors();
 
 		Image m_RenderTarget;
 		Image m_DepthTarget;
-		VkRenderPass m_renderPass;
-		VkFramebuffer m_framebuffer;
 		VkDescriptorSetLayout meshDescriptorSetLayout;
 
 		Context& context;
@@ -40,6 +37,7 @@ namespace vk
 		Image& depthPrepass;
 		std::shared_ptr<Scene> scene;
 		std::shared_ptr<Camera> camera;
+		CullingView& cullingView;
 		std::vector<VkDescriptorSet> m_descriptorSets;
 		std::unordered_map<int, std::pair<VkPipeline, VkPipelineLayout>> m_pipelines;
 
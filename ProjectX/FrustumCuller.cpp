@@ -0,0 +1,178 @@
+#include "FrustumCuller.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#if defined(__AVX__)
+#define FRUSTUM_CULLER_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLER_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	// Plane with the box components that are furthest along its normal, a box is outside when that corner is behind the plane
+	struct PlaneTest
+	{
+		glm::vec4 plane;
+		const float* x;
+		const float* y;
+		const float* z;
+	};
+}
+
+// Clip space planes of Vulkan (-w <= x, y <= w, 0 <= z <= w) moved back to world space, not normalized as only the sign is tested
+std::array<glm::vec4, 6> vk::ExtractFrustumPlanes(const glm::mat4& viewProjection)
+{
+	const glm::mat4 rows = glm::transpose(viewProjection);
+
+	return {
+		rows[3] + rows[0],
+		rows[3] - rows[0],
+		rows[3] + rows[1],
+		rows[3] - rows[1],
+		rows[2],
+		rows[3] - rows[2]
+	};
+}
+
+bool vk::IntersectsFrustum(const std::array<glm::vec4, 6>& planes, const ObjectBounds& bounds)
+{
+	for (const glm::vec4& plane : planes)
+	{
+		// The corner furthest along the normal, when even that one is behind the plane the whole box is
+		const glm::vec3 corner(
+			plane.x >= 0.0f ? bounds.max.x : bounds.min.x,
+			plane.y >= 0.0f ? bounds.max.y : bounds.min.y,
+			plane.z >= 0.0f ? bounds.max.z : bounds.min.z);
+
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+void vk::FrustumCuller::Build(const std::vector<ObjectBounds>& bounds)
+{
+	m_BoxCount = static_cast<uint32_t>(bounds.size());
+
+	// The padding is never reported visible, Cull masks off the bits past the last box
+	const size_t padded = (bounds.size() + BoxesPerGroup - 1) / BoxesPerGroup * BoxesPerGroup;
+	for (std::vector<float>* component : { &m_MinX, &m_MinY, &m_MinZ, &m_MaxX, &m_MaxY, &m_MaxZ })
+	{
+		component->assign(padded, 0.0f);
+	}
+
+	for (uint32_t i = 0; i < m_BoxCount; i++)
+	{
+		SetBounds(i, bounds[i]);
+	}
+}
+
+void vk::FrustumCuller::SetBounds(uint32_t box, const ObjectBounds& bounds)
+{
+	m_MinX[box] = bounds.min.x; m_MinY[box] = bounds.min.y; m_MinZ[box] = bounds.min.z;
+	m_MaxX[box] = bounds.max.x; m_MaxY[box] = bounds.max.y; m_MaxZ[box] = bounds.max.z;
+}
+
+uint32_t vk::FrustumCuller::Cull(const glm::mat4& viewProjection, std::vector<uint8_t>& visibility) const
+{
+	const uint32_t groupCount = (m_BoxCount + BoxesPerGroup - 1) / BoxesPerGroup;
+	visibility.assign(groupCount, 0);
+
+	// The corner tested against a plane only depends on the signs of its normal, pick its components once per plane
+	std::array<PlaneTest, 6> tests;
+	const std::array<glm::vec4, 6> planes = ExtractFrustumPlanes(viewProjection);
+	for (size_t p = 0; p < planes.size(); p++)
+	{
+		tests[p].plane = planes[p];
+		tests[p].x = planes[p].x >= 0.0f ? m_MaxX.data() : m_MinX.data();
+		tests[p].y = planes[p].y >= 0.0f ? m_MaxY.data() : m_MinY.data();
+		tests[p].z = planes[p].z >= 0.0f ? m_MaxZ.data() : m_MinZ.data();
+	}
+
+	uint32_t visibleCount = 0;
+
+#if defined(FRUSTUM_CULLER_AVX)
+	__m256 nx[6], ny[6], nz[6], nw[6];
+	for (size_t p = 0; p < tests.size(); p++)
+	{
+		nx[p] = _mm256_set1_ps(tests[p].plane.x);
+		ny[p] = _mm256_set1_ps(tests[p].plane.y);
+		nz[p] = _mm256_set1_ps(tests[p].plane.z);
+		nw[p] = _mm256_set1_ps(tests[p].plane.w);
+	}
+	const __m256 zero = _mm256_setzero_ps();
+#elif defined(FRUSTUM_CULLER_SSE)
+	__m128 nx[6], ny[6], nz[6], nw[6];
+	for (size_t p = 0; p < tests.size(); p++)
+	{
+		nx[p] = _mm_set1_ps(tests[p].plane.x);
+		ny[p] = _mm_set1_ps(tests[p].plane.y);
+		nz[p] = _mm_set1_ps(tests[p].plane.z);
+		nw[p] = _mm_set1_ps(tests[p].plane.w);
+	}
+	const __m128 zero = _mm_setzero_ps();
+#endif
+
+	for (uint32_t group = 0; group < groupCount; group++)
+	{
+		const uint32_t first = group * BoxesPerGroup;
+		uint32_t outside = 0;
+
+#if defined(FRUSTUM_CULLER_AVX)
+		__m256 behind = zero;
+		for (size_t p = 0; p < tests.size(); p++)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(nx[p], _mm256_loadu_ps(tests[p].x + first)), nw[p]);
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(ny[p], _mm256_loadu_ps(tests[p].y + first)));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(nz[p], _mm256_loadu_ps(tests[p].z + first)));
+			behind = _mm256_or_ps(behind, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+		}
+		outside = static_cast<uint32_t>(_mm256_movemask_ps(behind));
+#elif defined(FRUSTUM_CULLER_SSE)
+		for (uint32_t half = 0; half < 2; half++)
+		{
+			const uint32_t offset = first + half * 4;
+
+			__m128 behind = zero;
+			for (size_t p = 0; p < tests.size(); p++)
+			{
+				__m128 distance = _mm_add_ps(_mm_mul_ps(nx[p], _mm_loadu_ps(tests[p].x + offset)), nw[p]);
+				distance = _mm_add_ps(distance, _mm_mul_ps(ny[p], _mm_loadu_ps(tests[p].y + offset)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(nz[p], _mm_loadu_ps(tests[p].z + offset)));
+				behind = _mm_or_ps(behind, _mm_cmplt_ps(distance, zero));
+			}
+			outside |= static_cast<uint32_t>(_mm_movemask_ps(behind)) << (half * 4);
+		}
+#else
+		for (uint32_t lane = 0; lane < BoxesPerGroup; lane++)
+		{
+			const uint32_t box = first + lane;
+			for (const PlaneTest& test : tests)
+			{
+				if (test.plane.x * test.x[box] + test.plane.y * test.y[box] + test.plane.z * test.z[box] + test.plane.w < 0.0f)
+				{
+					outside |= 1u << lane;
+					break;
+				}
+			}
+		}
+#endif
+
+		uint32_t visible = ~outside & 0xffu;
+		if (first + BoxesPerGroup > m_BoxCount)
+		{
+			visible &= (1u << (m_BoxCount - first)) - 1u;
+		}
+
+		visibility[group] = static_cast<uint8_t>(visible);
+		visibleCount += static_cast<uint32_t>(std::popcount(visible));
+	}
+
+	return visibleCount;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Utils.hpp"
+
+// CPU frustum culling of the scene's draws. World space boxes are kept as structure of arrays, padded to a multiple
+// of eight, so one iteration tests eight boxes against a plane: a single AVX register, or two SSE registers without AVX.
+namespace vk
+{
+	// World space planes of the frustum, normals pointing inside: left, right, bottom, top, near, far
+	std::array<glm::vec4, 6> ExtractFrustumPlanes(const glm::mat4& viewProjection);
+	// Single box test against those planes, conservative like Cull: boxes across a frustum corner may pass
+	bool IntersectsFrustum(const std::array<glm::vec4, 6>& planes, const ObjectBounds& bounds);
+
+	class FrustumCuller
+	{
+	public:
+		static constexpr uint32_t BoxesPerGroup = 8;
+
+		FrustumCuller() = default;
+
+		// World space boxes, indexed like the scene's draws
+		void Build(const std::vector<ObjectBounds>& bounds);
+		// Replaces a single box, for draws whose instances moved
+		void SetBounds(uint32_t box, const ObjectBounds& bounds);
+
+		// One bit per box in visibility (bit i of byte i / 8) set when it intersects the frustum of viewProjection.
+		// Returns the number of visible boxes. Safe to call from several threads with their own visibility.
+		uint32_t Cull(const glm::mat4& viewProjection, std::vector<uint8_t>& visibility) const;
+
+		uint32_t GetBoxCount() const { return m_BoxCount; }
+		glm::vec3 GetCenter(uint32_t box) const
+		{
+			return 0.5f * glm::vec3(m_MinX[box] + m_MaxX[box], m_MinY[box] + m_MaxY[box], m_MinZ[box] + m_MaxZ[box]);
+		}
+
+	private:
+		uint32_t m_BoxCount = 0;
+		std::vector<float> m_MinX, m_MinY, m_MinZ;
+		std::vector<float> m_MaxX, m_MaxY, m_MaxZ;
+	};
+}
@@ -5,69 +5,52 @@
 #include "baked_model.hpp"
 #include "Utils.hpp"
 #include "Buffer.hpp"
-#include "RenderPass.hpp"
+#include "Rendering.hpp"
 #include "Camera.hpp"
+#include "CullingView.hpp"
 
-vk::GBuffer::GBuffer(Context& context, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera) : context{ context }, scene{ scene }, camera{ camera }
+vk::GBuffer::GBuffer(Context& context, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera, CullingView& cullingView, Image& prepassDepth) :
+	context{ context }, scene{ scene }, camera{ camera }, cullingView{ cullingView }, m_PrepassDepth{ prepassDepth }
 {
-	m_GBufferMRT.AlbedoTarget = CreateImageTexture2D(
+	m_GBufferMRT.AlbedoTarget = context.transientAllocator->CreateImage(
 		"GBuffer_Albedo_RT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_R8G8B8A8_SRGB,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_GBufferMRT.NormalTarget = CreateImageTexture2D(
+	m_GBufferMRT.NormalTarget = context.transientAllocator->CreateImage(
 		"GBuffer_Normal_RT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_A2R10G10B10_UNORM_PACK32,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_GBufferMRT.MetRoughnessTarget = CreateImageTexture2D(
+	m_GBufferMRT.MetRoughnessTarget = context.transientAllocator->CreateImage(
 		"GBuffer_MetRoughness_RT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_R8G8_UNORM,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_GBufferMRT.EmissiveTarget = CreateImageTexture2D(
+	m_GBufferMRT.EmissiveTarget = context.transientAllocator->CreateImage(
 		"GBuffer_Emissive_RT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_R16G16B16A16_SFLOAT, // HDR format for emissive
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_GBufferMRT.DepthTarget = CreateImageTexture2D(
-		"GBuffer_Depth_RT",
-		context,
-		context.extent.width,
-		context.extent.height,
-		VK_FORMAT_D32_SFLOAT,
-		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_DEPTH_BIT,
-		1
-	);
+	CreateDepthTarget();
 
 	BuildDescriptors();
-	CreateRenderPass();
-	CreateFramebuffer();
 	CreatePipeline();
 }
 
@@ -85,80 +68,73 @@ vk::GBuffer::~GBuffer()
 	vkDestroyPipeline(context.device, m_AlphaMaskingPipeline, nullptr);
 	vkDestroyPipelineLayout(context.device, m_AlphaMaskingPipelineLayout, nullptr);
 
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-	vkDestroyRenderPass(context.device, m_renderPass, nullptr);
+	vkDestroyPipeline(context.device, m_DepthEqualPipeline, nullptr);
+	vkDestroyPipelineLayout(context.device, m_DepthEqualPipelineLayout, nullptr);
+
 	vkDestroyDescriptorSetLayout(context.device, m_descriptorSetLayout, nullptr);
 }
 
 void vk::GBuffer::Resize()
 {
-	uint32_t width = context.extent.width;
-	uint32_t height = context.extent.height;
-
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-
 	m_GBufferMRT.AlbedoTarget.Destroy(context.device);
 	m_GBufferMRT.NormalTarget.Destroy(context.device);
 	m_GBufferMRT.MetRoughnessTarget.Destroy(context.device);
 	m_GBufferMRT.EmissiveTarget.Destroy(context.device);
 	m_GBufferMRT.DepthTarget.Destroy(context.device);
 
-	m_GBufferMRT.AlbedoTarget = CreateImageTexture2D(
+	m_GBufferMRT.AlbedoTarget = context.transientAllocator->CreateImage(
 		"GBuffer_Albedo_RT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_R8G8B8A8_SRGB,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_GBufferMRT.NormalTarget = CreateImageTexture2D(
+	m_GBufferMRT.NormalTarget = context.transientAllocator->CreateImage(
 		"GBuffer_Normal_RT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_A2R10G10B10_UNORM_PACK32,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_GBufferMRT.MetRoughnessTarget = CreateImageTexture2D(
+	m_GBufferMRT.MetRoughnessTarget = context.transientAllocator->CreateImage(
 		"GBuffer_MetRoughness_RT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_R8G8_UNORM,
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_GBufferMRT.EmissiveTarget = CreateImageTexture2D(
+	m_GBufferMRT.EmissiveTarget = context.transientAllocator->CreateImage(
 		"GBuffer_Emissive_RT",
-		context,
 		context.extent.width,
 		context.extent.height,
 		VK_FORMAT_R16G16B16A16_SFLOAT, // HDR format for emissive
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_COLOR_BIT,
-		1
+		VK_IMAGE_ASPECT_COLOR_BIT
 	);
 
-	m_GBufferMRT.DepthTarget = CreateImageTexture2D(
+	CreateDepthTarget();
+}
+
+void vk::GBuffer::CreateDepthTarget()
+{
+	// Nothing to draw into when the prepass depth is reused
+	if (gbufferReusesPrepassDepth)
+		return;
+
+	m_GBufferMRT.DepthTarget = context.transientAllocator->CreateImage(
 		"GBuffer_Depth_RT",
-		context,
-		width,
-		height,
+		context.extent.width,
+		context.extent.height,
 		VK_FORMAT_D32_SFLOAT,
 		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_DEPTH_BIT,
-		1
+		VK_IMAGE_ASPECT_DEPTH_BIT
 	);
-
-	CreateFramebuffer();
 }
 
 void vk::GBuffer::Execute(VkCommandBuffer cmd)
@@ -166,22 +142,29 @@ void vk::GBuffer::Execute(VkCommandBuffer cmd)
 
 #ifdef _DEBUG
 	RenderPassLabel(cmd, "G-Buffer");
-#endif // !DEBUG
-
-	VkRenderPassBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	beginInfo.renderPass = m_renderPass;
-	beginInfo.framebuffer = m_framebuffer;
-	beginInfo.renderArea.extent = context.extent;
-
-	VkClearValue clearValues[5];
-	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	clearValues[1].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	clearValues[2].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	clearValues[3].color = { {0.0f, 0.0f} };
-	clearValues[4].depthStencil.depth = { 1.0f };
-	beginInfo.clearValueCount = 5;
-	beginInfo.pClearValues = clearValues;
+#endif
+
+	Image* colorTargets[] = { &m_GBufferMRT.AlbedoTarget, &m_GBufferMRT.NormalTarget, &m_GBufferMRT.EmissiveTarget, &m_GBufferMRT.MetRoughnessTarget };
+
+	BarrierBatch barriers;
+	RenderingInfo rendering(context.extent);
+	for (Image* target : colorTargets)
+	{
+		BeginColorTarget(barriers, target->image);
+		rendering.AddColorAttachment(target->imageView, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+	}
+
+	// The prepass depth is a read-only attachment, the render graph already moved it to its layout
+	if (gbufferReusesPrepassDepth)
+	{
+		rendering.SetDepthAttachment(m_PrepassDepth.imageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_NONE);
+	}
+	else
+	{
+		BeginDepthTarget(barriers, m_GBufferMRT.DepthTarget.image);
+		rendering.SetDepthAttachment(m_GBufferMRT.DepthTarget.imageView, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+	}
+	barriers.Flush(cmd);
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -197,17 +180,39 @@ void vk::GBuffer::Execute(VkCommandBuffer cmd)
 	scissor.extent = { context.extent.width, context.extent.height };
 	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
-	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_descriptorSets[currentFrame], 0, nullptr);
+	rendering.Begin(cmd);
+	// Set 1 is the bindless texture table the materials index, set 2 the scene's objects and materials
+	VkDescriptorSet sets[] = { m_descriptorSets[currentFrame], context.bindlessTextures->GetSet(), scene->GetDrawDataSet() };
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 3, sets, 0, nullptr);
+
+	// The camera's draws that survived the depth-prepass culling
+	if (gbufferReusesPrepassDepth)
+	{
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_DepthEqualPipeline);
+		cullingView.Draw(cmd, Scene::DrawFilter::All);
+	}
+	else
+	{
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
+		cullingView.Draw(cmd, Scene::DrawFilter::Opaque);
 
-	// Draw front freshes
-	scene->RenderFrontMeshes(cmd, m_PipelineLayout);
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_AlphaMaskingPipeline);
+		cullingView.Draw(cmd, Scene::DrawFilter::AlphaMasked);
+	}
+	vkCmdEndRendering(cmd);
 
-	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_AlphaMaskingPipeline);
-	scene->RenderBackMeshes(cmd, m_AlphaMaskingPipelineLayout);
+	for (Image* target : colorTargets)
+	{
+		EndColorTarget(barriers, target->image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
 
-	vkCmdEndRenderPass(cmd);
+	// Depth is released to later depth tests, the render graph adds the barrier for passes that sample it
+	if (!gbufferReusesPrepassDepth)
+	{
+		EndDepthTarget(barriers, m_GBufferMRT.DepthTarget.image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT);
+	}
+	barriers.Flush(cmd);
 
 #ifdef _DEBUG
 	EndRenderPassLabel(cmd);
@@ -216,128 +221,71 @@ void vk::GBuffer::Execute(VkCommandBuffer cmd)
 
 void vk::GBuffer::CreatePipeline()
 {
-	VkPushConstantRange pushConstantRange = {
-		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_GEOMETRY_BIT,
-		.offset = 0,
-		.size = sizeof(MeshPushConstants)
-	};
-
 	// G-Buffer for non-alpha material meshes
-	auto gBufferPipelineRes =
-		vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
 		.AddShader("../Engine/assets/shaders/default.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/gbuffer.frag.spv", ShaderType::FRAGMENT)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
 		.SetDynamicState({ {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR} })
 		.SetRasterizationState(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
-		.SetPipelineLayout({ {m_descriptorSetLayout} }, pushConstantRange)
+		.SetPipelineLayout({ m_descriptorSetLayout, context.bindlessTextures->GetLayout(), scene->GetDrawDataLayout() })
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
 		.AddBlendAttachmentState()
 		.AddBlendAttachmentState()
 		.AddBlendAttachmentState()
 		.AddBlendAttachmentState()
 		.SetDepthState(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL)
-		.SetRenderPass(m_renderPass)
-		.Build();
-
-	m_Pipeline		 = gBufferPipelineRes.first;
-	m_PipelineLayout = gBufferPipelineRes.second;
+		.SetRenderingFormats(m_ColorFormats, VK_FORMAT_D32_SFLOAT)
+		.BuildDeferred(m_Pipeline, m_PipelineLayout);
 
 	// G-Buffer alpha masking
-	auto gBufferAlphaMaskingPipelineRes =
-		vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
 		.AddShader("../Engine/assets/shaders/default.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/gbuffer_alpha.frag.spv", ShaderType::FRAGMENT)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
 		.SetDynamicState({ {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR} })
 		.SetRasterizationState(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
-		.SetPipelineLayout({ {m_descriptorSetLayout} }, pushConstantRange)
+		.SetPipelineLayout({ m_descriptorSetLayout, context.bindlessTextures->GetLayout(), scene->GetDrawDataLayout() })
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
 		.AddBlendAttachmentState()
 		.AddBlendAttachmentState()
 		.AddBlendAttachmentState()
 		.AddBlendAttachmentState()
 		.SetDepthState(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL)
-		.SetRenderPass(m_renderPass)
-		.Build();
+		.SetRenderingFormats(m_ColorFormats, VK_FORMAT_D32_SFLOAT)
+		.BuildDeferred(m_AlphaMaskingPipeline, m_AlphaMaskingPipelineLayout);
 
-	m_AlphaMaskingPipeline		 = gBufferAlphaMaskingPipelineRes.first;
-	m_AlphaMaskingPipelineLayout = gBufferAlphaMaskingPipelineRes.second;
-}
-
-void vk::GBuffer::CreateRenderPass()
-{
-	RenderPass builder(context.device, 1);
-
-	m_renderPass = builder
-		.AddAttachment(VK_FORMAT_R8G8B8A8_SRGB, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddAttachment(VK_FORMAT_A2R10G10B10_UNORM_PACK32, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddAttachment(VK_FORMAT_R16G16B16A16_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddAttachment(VK_FORMAT_R8G8_UNORM, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddAttachment(VK_FORMAT_D32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
-
-		.AddColorAttachmentRef(0, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-		.AddColorAttachmentRef(0, 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-		.AddColorAttachmentRef(0, 2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-		.AddColorAttachmentRef(0, 3, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-		.SetDepthAttachmentRef(0, 4, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-
-		// External -> 0 : Color
-		.AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-		// 0 -> External : Color : Wait for color writing to finish on the attachment before the fragment shader tries to read from it
-		.AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-		// External -> 0 : Depth
-		.AddDependency(VK_SUBPASS_EXTERNAL, 0,
-			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, // Written to during late fragment
-			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT)
-
-		// 0 -> External : Depth
-		.AddDependency(0, VK_SUBPASS_EXTERNAL,
-			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT)
-
-		.Build();
-}
-
-void vk::GBuffer::CreateFramebuffer()
-{
-	// Framebuffer
-	std::vector<VkImageView> attachments = {
-		m_GBufferMRT.AlbedoTarget.imageView,
-		m_GBufferMRT.NormalTarget.imageView,
-		m_GBufferMRT.EmissiveTarget.imageView,
-		m_GBufferMRT.MetRoughnessTarget.imageView,
-		m_GBufferMRT.DepthTarget.imageView
-	};
-	VkFramebufferCreateInfo fbcInfo = {
-		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-		.renderPass = m_renderPass,
-		.attachmentCount = static_cast<uint32_t>(attachments.size()),
-		.pAttachments = attachments.data(),
-		.width = context.extent.width,
-		.height = context.extent.height,
-		.layers = 1
-	};
-
-	VK_CHECK(vkCreateFramebuffer(context.device, &fbcInfo, nullptr, &m_framebuffer), "Failed to create Forward pass framebuffer.");
+	// G-Buffer on the prepass depth, both draw lists
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
+		.AddShader("../Engine/assets/shaders/default.vert.spv", ShaderType::VERTEX)
+		.AddShader("../Engine/assets/shaders/gbuffer.frag.spv", ShaderType::FRAGMENT)
+		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+		.SetDynamicState({ {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR} })
+		.SetRasterizationState(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
+		.SetPipelineLayout({ m_descriptorSetLayout, context.bindlessTextures->GetLayout(), scene->GetDrawDataLayout() })
+		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
+		.AddBlendAttachmentState()
+		.AddBlendAttachmentState()
+		.AddBlendAttachmentState()
+		.AddBlendAttachmentState()
+		.SetDepthState(VK_TRUE, VK_FALSE, VK_COMPARE_OP_EQUAL)
+		.SetRenderingFormats(m_ColorFormats, VK_FORMAT_D32_SFLOAT)
+		.BuildDeferred(m_DepthEqualPipeline, m_DepthEqualPipelineLayout);
 }
 
 void vk::GBuffer::BuildDescriptors()
 {
 	m_descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
 	{
-		// Set = 0, binding 0 = cameraUBO, binding = 1 = textures
+		// Set = 0, binding 0 = cameraUBO, binding 2 = sampler. Mesh textures are in the bindless table (set = 1)
 		std::vector<VkDescriptorSetLayoutBinding> bindings = {
 			CreateDescriptorBinding(0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT), // SceneUBO (projection, view etc..)
-			CreateDescriptorBinding(1, 200, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, VK_SHADER_STAGE_FRAGMENT_BIT), // Mesh textures
 			CreateDescriptorBinding(2, 1, VK_DESCRIPTOR_TYPE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT) // Anisotropic sampler
 		};
 
 		m_descriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
 
-		AllocateDescriptorSets(context, context.descriptorPool, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
+		AllocateDescriptorSets(context, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
 	}
 
 	// Camera Transform UBO
@@ -350,27 +298,6 @@ void vk::GBuffer::BuildDescriptors()
 		UpdateDescriptorSet(context, 0, bufferInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 	}
 
-	// Mesh textures
-	std::vector<VkDescriptorImageInfo> imageInfos;
-	for (auto& model : scene->GetModels())
-	{
-		for (size_t i = 0; i < model->loadedTextures.size(); i++)
-		{
-			VkDescriptorImageInfo imgInfo = {
-				.sampler = VK_NULL_HANDLE,
-				.imageView = model->loadedTextures[i].imageView,
-				.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-			};
-
-			imageInfos.push_back(imgInfo);
-		}
-	}
-
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		BulkImageUpdate(context, 1, imageInfos, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
-	}
-
 	// Anisotropic sampler
 	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
 	{
@@ -9,6 +9,7 @@ namespace vk
 	class Context;
 	class Scene;
 	class Buffer;
+	class CullingView;
 
 	class GBuffer
 	{
@@ -23,27 +24,31 @@ namespace vk
 			Image DepthTarget;
 		};
 
-		GBuffer(Context& context, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera);
+		GBuffer(Context& context, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera, CullingView& cullingView, Image& prepassDepth);
 		~GBuffer();
 		void Execute(VkCommandBuffer cmd);
 		void Update();
 
 		void Resize();
 		GBufferMRT& GetGBufferMRT() { return m_GBufferMRT; }
+		// Depth of the shaded surfaces: the prepass depth when it's reused, DepthTarget otherwise
+		Image& GetDepthTarget() { return gbufferReusesPrepassDepth ? m_PrepassDepth : m_GBufferMRT.DepthTarget; }
 
 	private:
 		void CreatePipeline();
-		void CreateRenderPass();
-		void CreateFramebuffer();
 		void BuildDescriptors();
+		void CreateDepthTarget();
 
 		GBufferMRT m_GBufferMRT;
-		VkRenderPass m_renderPass;
-		VkFramebuffer m_framebuffer;
+
+		// Attachment order the shaders write in: albedo, normal, emissive, metallic/roughness
+		const std::vector<VkFormat> m_ColorFormats = { VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_A2R10G10B10_UNORM_PACK32, VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_R8G8_UNORM };
 
 		Context& context;
 		std::shared_ptr<Scene> scene;
 		std::shared_ptr<Camera> camera;
+		CullingView& cullingView;
+		Image& m_PrepassDepth;
 		std::vector<VkDescriptorSet> m_descriptorSets;
 		VkDescriptorSetLayout m_descriptorSetLayout;
 
@@ -52,5 +57,9 @@ namespace vk
 
 		VkPipeline m_AlphaMaskingPipeline;
 		VkPipelineLayout m_AlphaMaskingPipelineLayout;
+
+		// Depth equal to the prepass, writes off. Alpha masked texels were discarded by the prepass, so both lists use it.
+		VkPipeline m_DepthEqualPipeline;
+		VkPipelineLayout m_DepthEqualPipelineLayout;
 	};
 }
\ No newline at end of file
@@ -1,13 +1,40 @@
 #include "Context.hpp"
 #include "Scene.hpp"
 #include "Camera.hpp"
-#include "RenderPass.hpp"
 #include "ImGuiRenderer.hpp"
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
 #include "Utils.hpp"
+#include "Barriers.hpp"
+#include "CullingView.hpp"
 
+#include <unordered_map>
+
+namespace
+{
+    // For counts the shaders are specialized on, the setting only takes the new value once the slider is let go
+    // instead of compiling a pipeline variant for every value dragged past
+    void SliderVariantInt(const char* label, int& setting, int min, int max)
+    {
+        static std::unordered_map<ImGuiID, int> dragging;
+
+        const ImGuiID id = ImGui::GetID(label);
+        auto it = dragging.find(id);
+        int value = it != dragging.end() ? it->second : setting;
+
+        ImGui::SliderInt(label, &value, min, max);
+
+        if (ImGui::IsItemActive())
+        {
+            dragging[id] = value;
+            return;
+        }
+
+        dragging.erase(id);
+        setting = value;
+    }
+}
 
 void vk::ImGuiRenderer::Initialize(const Context& context) {
 
@@ -35,18 +62,22 @@ void vk::ImGuiRenderer::Initialize(const Context& context) {
     info.Queue = context.graphicsQueue;
     info.QueueFamily = context.graphicsFamilyIndex;
     info.DescriptorPool = ImGuiRenderer::imGuiDescriptorPool;
-    info.MinImageCount = 3;
-    info.ImageCount = MAX_FRAMES_IN_FLIGHT;
+    info.MinImageCount = 2;
+    info.ImageCount = static_cast<uint32_t>(context.swapchainImages.size());
     info.Subpass = 0;
     info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-    info.RenderPass = context.renderPass;
+    // Drawn inside the present pass' dynamic rendering instance, the format pointer has to outlive the backend
+    info.UseDynamicRendering = true;
+    info.PipelineRenderingCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+    info.PipelineRenderingCreateInfo.colorAttachmentCount = 1;
+    info.PipelineRenderingCreateInfo.pColorAttachmentFormats = &context.swapchainFormat;
 
     ImGui_ImplVulkan_Init(&info);
 
     io.Fonts->AddFontDefault();
 }
 
-void vk::ImGuiRenderer::Update(const std::shared_ptr<Scene>& scene, const std::shared_ptr<Camera>& camera)
+void vk::ImGuiRenderer::Update(const std::shared_ptr<Scene>& scene, const std::shared_ptr<Camera>& camera, const std::vector<CullingView*>& cullingViews)
 {
     ImGui_ImplVulkan_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -58,6 +89,31 @@ void vk::ImGuiRenderer::Update(const std::shared_ptr<Scene>& scene, const std::s
         ImVec4(0.76, 0.5, 0.0, 1.0), "FPS: (%.1f FPS), %.3f ms/frame",
         ImGui::GetIO().Framerate, 1000.0f / ImGui::GetIO().Framerate);
 
+    const BarrierBatch::FrameStats barrierStats = BarrierBatch::GetLastFrameStats();
+    ImGui::Text("Barriers: %u in %u batches", barrierStats.barriers, barrierStats.flushes);
+
+    // GPU culled lists never come back to the CPU, the counts are only known for CPU culling
+    ImGui::Checkbox("GPU Culling", &gpuCulling);
+    ImGui::Checkbox("Camera Collision", &cameraCollision);
+    ImGui::Checkbox("Cache Shadow Map", &cacheShadowMap);
+    if (instancedPropsDemo)
+    {
+        ImGui::SliderFloat("Prop Spacing", &propSpacing, 0.0f, 60.0f, "%.1f");
+    }
+    if (!gpuCulling)
+    {
+        for (const CullingView* view : cullingViews)
+        {
+            const CullingView::CpuStats& stats = view->GetCpuStats();
+            ImGui::Text("%s: %u visible, %u culled", view->GetName().c_str(), stats.visible, stats.culled);
+        }
+    }
+
+    if (scene->GetPickedObject() != UINT32_MAX)
+    {
+        ImGui::Text("Picked Object: %u", scene->GetPickedObject());
+    }
+
     // Add camera position
     ImGui::Text("Camera Position: (%.2f, %.2f, %.2f)",
         camera->GetPosition().x,
@@ -107,10 +163,14 @@ void vk::ImGuiRenderer::Update(const std::shared_ptr<Scene>& scene, const std::s
         ImGui::SliderFloat("Elevation - Phi", &SunElevation, -1.5708f, 1.5708f, "%.2f");
         ImGui::SliderFloat("Azimuthal - Theta", &SunAzimuthal, -3.141f, 3.141f, "%.2f");
 
-        ImGui::Text("Light Camera Settings");
-        ImGui::SliderFloat("View", &sunLight.View, -200.0f, 200.0f, "%.2f");
-        ImGui::SliderFloat("Near", &sunLight.Near, -200.1f, 100.0f, "%.2f");
-        ImGui::SliderFloat("Far", &sunLight.Far, 0.1f, 50.0f, "%.2f");
+        ImGui::Text("Shadow Cascades");
+        ImGui::SliderInt("Cascades", &shadowSettings.CascadeCount, 1, static_cast<int>(MaxShadowCascades));
+        ImGui::SliderFloat("Split Lambda", &shadowSettings.SplitLambda, 0.0f, 1.0f, "%.2f");
+        ImGui::SliderFloat("Shadow Distance", &shadowSettings.Distance, 1.0f, 100.0f, "%.1f");
+        ImGui::SliderFloat("Depth Bias", &shadowSettings.DepthBias, 0.0f, 0.01f, "%.4f");
+
+        ImGui::Text("Shadow Filtering");
+        SliderVariantInt("PCF Range", lightingSettings.PCFRange, 0, 4);
     }
 
     if (ImGui::CollapsingHeader("Lights")) {
@@ -125,9 +185,9 @@ void vk::ImGuiRenderer::Update(const std::shared_ptr<Scene>& scene, const std::s
 
     if (ImGui::CollapsingHeader("SSR"))
     {
-        ImGui::SliderInt("MaxSteps: ", &ssrSettings.MaxSteps, 1, 500);
+        SliderVariantInt("MaxSteps: ", ssrSettings.MaxSteps, 1, 500);
         ImGui::SliderFloat("MaxDistance: ", &ssrSettings.MaxDistance, 0.0f, 20.0f);
-        ImGui::SliderInt("BSIterations: ", &ssrSettings.BinarySearchIterations, 0, 100);
+        SliderVariantInt("BSIterations: ", ssrSettings.BinarySearchIterations, 0, 100);
         ImGui::SliderFloat("Thickness: ", &ssrSettings.thickness, 0, 1.0f);
         ImGui::SliderFloat("StepSize: ", &ssrSettings.StepSize, 0.0f, 0.5f);
     }
@@ -145,8 +205,8 @@ void vk::ImGuiRenderer::Update(const std::shared_ptr<Scene>& scene, const std::s
 
     if (ImGui::CollapsingHeader("SSAO"))
     {
-        ImGui::SliderInt("Directions: ", &ssaoSettings.NumDirections, 1, 10);
-        ImGui::SliderInt("Steps: ", &ssaoSettings.NumSteps, 0, 20);
+        SliderVariantInt("Directions: ", ssaoSettings.NumDirections, 1, 10);
+        SliderVariantInt("Steps: ", ssaoSettings.NumSteps, 0, 20);
         ImGui::SliderFloat("Radius: ", &ssaoSettings.Radius, 0, 20.0f);
         ImGui::SliderFloat("StepSize: ", &ssaoSettings.StepSize, 0, 0.1f);
         ImGui::SliderFloat("K: ", &ssaoSettings.k, 0.0f, 10.0f);
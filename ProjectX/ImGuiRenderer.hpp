@@ -9,6 +9,7 @@ namespace vk
     class Context;
     class Scene;
     class Camera;
+    class CullingView;
     namespace ImGuiRenderer
     {
         static std::vector<std::function<void()>> ImGuiComponents;
@@ -45,7 +46,7 @@ namespace vk
 
         void Initialize(const Context& context);
         void Shutdown(const Context& context);
-        void Update(const std::shared_ptr<Scene>& scene, const std::shared_ptr<Camera>& camera);
+        void Update(const std::shared_ptr<Scene>& scene, const std::shared_ptr<Camera>& camera, const std::vector<CullingView*>& cullingViews);
         void Render(VkCommandBuffer cmd, const Context& context, uint32_t imageIndex);
 
         inline VkDescriptorPool imGuiDescriptorPool;
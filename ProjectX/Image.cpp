@@ -2,6 +2,8 @@
 #include "Image.hpp"
 #include "Utils.hpp"
 #include "Buffer.hpp"
+#include "TransientAllocator.hpp"
+#include "Barriers.hpp"
 #include "stb_image.h"
 #include <assert.h>
 
@@ -20,7 +22,7 @@ namespace {
 
 
 vk::Image::Image(const std::string name, uint32_t width, uint32_t height, VmaAllocator allocator, VkImage image, VkImageView imageView, VmaAllocation allocation) noexcept :
-	name{name}, allocation{allocation}, image{image}, imageView{imageView}, allocator{allocator} {}
+	name{name}, allocation{allocation}, image{image}, imageView{imageView}, allocator{allocator}, width{width}, height{height} {}
 
 
 vk::Image::Image(Image&& other) noexcept :
@@ -28,7 +30,10 @@ vk::Image::Image(Image&& other) noexcept :
 	allocation(std::exchange(other.allocation, VK_NULL_HANDLE)),
 	image(std::exchange(other.image, VK_NULL_HANDLE)),
 	imageView(std::exchange(other.imageView, VK_NULL_HANDLE)),
-	allocator(std::exchange(other.allocator, VK_NULL_HANDLE)) {}
+	allocator(std::exchange(other.allocator, VK_NULL_HANDLE)),
+	width(std::exchange(other.width, 0)),
+	height(std::exchange(other.height, 0)),
+	transientAllocator(std::exchange(other.transientAllocator, nullptr)) {}
 
 
 vk::Image& vk::Image::operator=(vk::Image&& other) noexcept
@@ -38,6 +43,9 @@ vk::Image& vk::Image::operator=(vk::Image&& other) noexcept
 	std::swap(image, other.image);
 	std::swap(imageView, other.imageView);
 	std::swap(allocator, other.allocator);
+	std::swap(width, other.width);
+	std::swap(height, other.height);
+	std::swap(transientAllocator, other.transientAllocator);
 
 	return *this;
 }
@@ -49,37 +57,33 @@ void vk::Image::Destroy(VkDevice device)
 		assert(allocator != VK_NULL_HANDLE);
 		assert(allocation != VK_NULL_HANDLE);
 		vkDestroyImageView(device, imageView, nullptr);
-		vmaDestroyImage(allocator, image, allocation);
+
+		// Aliased images don't own their memory, the block is freed once the last image in it is gone
+		if (transientAllocator != nullptr)
+		{
+			vkDestroyImage(device, image, nullptr);
+			transientAllocator->Release(image);
+		}
+		else
+		{
+			vmaDestroyImage(allocator, image, allocation);
+		}
 	}
 }
 
 void vk::ImageTransition(VkCommandBuffer cmd, VkImage image, VkFormat format, VkImageLayout currentLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
 	VkPipelineStageFlagBits srcStageMask, VkPipelineStageFlagBits dstStageMask)
 {
-	VkImageMemoryBarrier barrier = {};
-	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	barrier.oldLayout = currentLayout;
-	barrier.newLayout = newLayout;
-	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	barrier.image = image;
-	barrier.subresourceRange.aspectMask = format != VK_FORMAT_D32_SFLOAT ? VK_IMAGE_ASPECT_COLOR_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
-	barrier.subresourceRange.baseMipLevel = 0;
-	barrier.subresourceRange.levelCount = 1;
-	barrier.subresourceRange.baseArrayLayer = 0;
-	barrier.subresourceRange.layerCount = 1;
-	barrier.srcAccessMask = srcAccessMask; // No source access required // 0
-	barrier.dstAccessMask = dstAccessMask; // VK_ACCESS_TRANSFER_WRITE_BIT
-
-	vkCmdPipelineBarrier(
-		cmd,
-		srcStageMask, // VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
-		dstStageMask, // VK_PIPELINE_STAGE_TRANSFER_BIT
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &barrier
-	);
+	VkImageSubresourceRange range = {};
+	range.aspectMask = format != VK_FORMAT_D32_SFLOAT ? VK_IMAGE_ASPECT_COLOR_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+	range.baseMipLevel = 0;
+	range.levelCount = 1;
+	range.baseArrayLayer = 0;
+	range.layerCount = 1;
+
+	BarrierBatch barriers;
+	barriers.Image(image, currentLayout, newLayout, srcStageMask, srcAccessMask, dstStageMask, dstAccessMask, range);
+	barriers.Flush(cmd);
 }
 
 uint32_t vk::ComputeMipLevels(uint32_t width, uint32_t height)
@@ -89,24 +93,43 @@ uint32_t vk::ComputeMipLevels(uint32_t width, uint32_t height)
 
 vk::Image vk::LoadTextureFromDisk(const std::string& path, Context& context)
 {
+	TextureData texture = DecodeTexture(path);
+	return UploadTexture(texture, context);
+}
 
-	int width, height, texChannels;
-	stbi_set_flip_vertically_on_load(1);
-	stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &texChannels, 4);
+vk::TextureData vk::DecodeTexture(const std::string& path)
+{
+	TextureData texture = {};
+	texture.path = path;
 
-	const auto imageSize = width * height * 4; // width * height * rgba
+	int texChannels;
+	// The flip flag is per thread, textures may be decoded on any of the job system's workers
+	stbi_set_flip_vertically_on_load_thread(1);
+	texture.pixels = stbi_load(path.c_str(), &texture.width, &texture.height, &texChannels, 4);
 
-	if (!pixels)
+	if (!texture.pixels)
 	{
 		ERROR("Failed to load texture: " + path);
 	}
 
+	return texture;
+}
+
+vk::Image vk::UploadTexture(TextureData& texture, Context& context)
+{
+	const std::string& path = texture.path;
+	int width = texture.width;
+	int height = texture.height;
+
+	const auto imageSize = width * height * 4; // width * height * rgba
+
 	// Create a buffer to which we can copy data to from CPU -> staging buffer
 	vk::Buffer stagingBuffer = vk::CreateBuffer("stagingBuffer", context, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
 
-	stagingBuffer.WriteToBuffer(pixels, imageSize);
+	stagingBuffer.WriteToBuffer(texture.pixels, imageSize);
 
-	stbi_image_free(pixels);
+	stbi_image_free(texture.pixels);
+	texture.pixels = nullptr;
 
 	bool istexSpecular = isSpecular(path);
 	bool istexNormal = isNormal(path);
@@ -119,18 +142,15 @@ vk::Image vk::LoadTextureFromDisk(const std::string& path, Context& context)
 
 	ExecuteSingleTimeCommands(context, [&](VkCommandBuffer cmd)
 		{
+			BarrierBatch barriers;
+
 			// Transition from LAYOUT_UNDEFINED to LAYOUT_TRANSFER_DST_OPTIMAL to copy contents
 			// from buffer to the image
-			ImageBarrier(
-				cmd,
-				img.image,
-				0,
-				VK_ACCESS_TRANSFER_WRITE_BIT,
-				VK_IMAGE_LAYOUT_UNDEFINED,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
+			barriers.Image(img.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+				VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
 				VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 });
+			barriers.Flush(cmd);
 
 			VkBufferImageCopy bufferCopy = {
 				.bufferOffset = 0,
@@ -143,23 +163,16 @@ vk::Image vk::LoadTextureFromDisk(const std::string& path, Context& context)
 
 			vkCmdCopyBufferToImage(cmd, stagingBuffer.buffer, img.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &bufferCopy);
 
-			// Transition from DST_OPTIMAL Layout to SRC_OPTIMAL since it'll
-			// be used as a SOURCE of a transfer operation during mip generation
-			ImageBarrier(
-				cmd,
-				img.image,
-				VK_ACCESS_TRANSFER_WRITE_BIT,
-				VK_ACCESS_TRANSFER_READ_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
-
-
-			// now we need to process each mip to generate the mip maps
+			// now we need to process each mip to generate the mip maps. Every blit reads the level written just before it
+			// (by the copy or the previous blit), so that level needs its own barrier to become a transfer SOURCE first
 			for (uint32_t level = 1; level < mipLevels; level++)
 			{
+				barriers.Image(img.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+					VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+					VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0, 1 });
+				barriers.Flush(cmd);
+
 				VkImageBlit blit = {};
 				blit.srcSubresource = VkImageSubresourceLayers{ VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
 				blit.srcOffsets[0] = { 0, 0, 0 };
@@ -187,43 +200,22 @@ vk::Image vk::LoadTextureFromDisk(const std::string& path, Context& context)
 					1,
 					&blit,
 					VK_FILTER_LINEAR);
-
-
-				ImageBarrier(cmd,
-					img.image,
-					VK_ACCESS_TRANSFER_WRITE_BIT,
-					VK_ACCESS_TRANSFER_READ_BIT,
-					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-					VK_PIPELINE_STAGE_TRANSFER_BIT,
-					VK_PIPELINE_STAGE_TRANSFER_BIT,
-					VkImageSubresourceRange{
-						VK_IMAGE_ASPECT_COLOR_BIT,
-						level,
-						1,
-						0,
-						1
-					});
 			}
 
-			ImageBarrier(
-				cmd,
-				img.image,
-				VK_ACCESS_TRANSFER_READ_BIT,
-				VK_ACCESS_SHADER_READ_BIT,
-				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-				VK_PIPELINE_STAGE_TRANSFER_BIT,
-				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-				VkImageSubresourceRange{
-					VK_IMAGE_ASPECT_COLOR_BIT,
-					0,
-					mipLevels,
-					0,
-					1
-				}
-			);
+			// Every level is made readable by one flush: the ones read by a blit are in SRC, the last one written is still in DST
+			if (mipLevels > 1)
+			{
+				barriers.Image(img.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_NONE,
+					VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT,
+					VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels - 1, 0, 1 });
+			}
 
+			barriers.Image(img.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+				VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT,
+				VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, mipLevels - 1, 1, 0, 1 });
+			barriers.Flush(cmd);
 		});
 
 	stagingBuffer.Destroy(context.device);
@@ -265,7 +257,7 @@ vk::Image vk::CreateImageTexture2D(const std::string name, Context& context, uin
 	VkImageViewCreateInfo viewInfo{};
 	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	viewInfo.image = image;
-	viewInfo.viewType = (flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT) != 0 ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.viewType = (flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT) != 0 ? VK_IMAGE_VIEW_TYPE_CUBE : (arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D);
 	viewInfo.format = format;
 	viewInfo.components = VkComponentMapping{};
 	viewInfo.subresourceRange = VkImageSubresourceRange{ imageaspectFlags, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
@@ -7,6 +7,7 @@
 namespace vk
 {
 	class Context;
+	class TransientAllocator;
 
 	class Image
 	{
@@ -29,12 +30,26 @@ namespace vk
 		VkImage image;
 		VkImageView imageView;
 		VmaAllocator allocator;
-		uint32_t width;
-		uint32_t height;
+		uint32_t width = 0;
+		uint32_t height = 0;
+
+		// Set when the image is aliased onto memory owned by the transient allocator
+		TransientAllocator* transientAllocator = nullptr;
 	};
 
 	void ImageTransition(VkCommandBuffer cmd, VkImage image, VkFormat format, VkImageLayout currentLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask, VkPipelineStageFlagBits srcStageMask, VkPipelineStageFlagBits dstStageMask);
 	uint32_t ComputeMipLevels(uint32_t width, uint32_t height);
+	// Pixels of a texture decoded on the CPU. Decoding touches no Vulkan state, so it can run on any thread.
+	struct TextureData
+	{
+		std::string path;
+		int width = 0;
+		int height = 0;
+		unsigned char* pixels = nullptr; // RGBA8, freed by UploadTexture
+	};
+
+	TextureData DecodeTexture(const std::string& path);
+	Image UploadTexture(TextureData& texture, Context& context);
 	Image LoadTextureFromDisk(const std::string& path, Context& context);
 	Image CreateImageTexture2D(const std::string name, Context& context, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags imageaspectFlags, uint32_t mipLevels = 1, VkImageCreateFlags flags = 0, uint32_t arrayLayers = 1);
 }
@@ -0,0 +1,271 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#endif
+
+namespace
+{
+	thread_local uint32_t t_WorkerIndex = 0;
+
+	void PinToCore(std::thread::native_handle_type thread, uint32_t core)
+	{
+#if defined(_WIN32)
+		SetThreadAffinityMask(thread, DWORD_PTR(1) << core);
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(core, &set);
+		pthread_setaffinity_np(thread, sizeof(set), &set);
+#endif
+	}
+}
+
+vk::JobSystem::JobSystem(uint32_t workerCount, bool pinThreads) : m_Running{true}, m_StealableJobs{0}
+{
+	if (workerCount == 0)
+	{
+		workerCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	m_PinnedJobs = std::make_unique<std::atomic<uint32_t>[]>(workerCount);
+	for (uint32_t i = 0; i < workerCount; i++)
+	{
+		m_Workers.push_back(std::make_unique<Worker>());
+	}
+
+	// The main thread (worker 0) gets core 0 to itself, the others wrap around the remaining cores.
+	// The affinity mask only has room for the first 64 cores.
+	const uint32_t cores = std::min(std::thread::hardware_concurrency(), 64u);
+
+	t_WorkerIndex = 0;
+	if (pinThreads && cores > 1)
+	{
+#if defined(_WIN32)
+		PinToCore(GetCurrentThread(), 0);
+#elif defined(__linux__)
+		PinToCore(pthread_self(), 0);
+#endif
+	}
+
+	for (uint32_t i = 1; i < workerCount; i++)
+	{
+		m_Threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+
+		if (pinThreads && cores > 1)
+		{
+			PinToCore(m_Threads.back().native_handle(), 1 + (i - 1) % (cores - 1));
+		}
+	}
+}
+
+vk::JobSystem::~JobSystem()
+{
+	m_Running = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+	}
+	m_WakeCondition.notify_all();
+
+	for (auto& thread : m_Threads)
+	{
+		thread.join();
+	}
+}
+
+uint32_t vk::JobSystem::GetWorkerIndex()
+{
+	return t_WorkerIndex;
+}
+
+void vk::JobSystem::Schedule(std::function<void()> function, JobCounter* signal, JobCounter* dependency, uint32_t worker)
+{
+	Job job = { std::move(function), signal, worker };
+
+	if (signal != nullptr)
+	{
+		signal->m_Count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (dependency != nullptr)
+	{
+		// Checked under the counter's lock so it can't reach zero between the check and adding the continuation
+		std::lock_guard<std::mutex> lock(dependency->m_Mutex);
+		if (dependency->m_Count.load(std::memory_order_acquire) != 0)
+		{
+			dependency->m_Continuations.push_back(std::move(job));
+			return;
+		}
+	}
+
+	Enqueue(std::move(job));
+}
+
+void vk::JobSystem::Wait(JobCounter& counter)
+{
+	const uint32_t worker = GetWorkerIndex();
+
+	while (!counter.IsDone())
+	{
+		if (!RunOne(worker))
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// The last job may still be releasing the counter's lock, the counter must outlive it
+	std::lock_guard<std::mutex> lock(counter.m_Mutex);
+}
+
+void vk::JobSystem::ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)>& function, uint32_t grain)
+{
+	grain = std::max(grain, 1u);
+
+	JobCounter counter;
+	for (uint32_t begin = 0; begin < count; begin += grain)
+	{
+		const uint32_t end = std::min(begin + grain, count);
+		Schedule([&function, begin, end]()
+		{
+			const uint32_t worker = GetWorkerIndex();
+			for (uint32_t i = begin; i < end; i++)
+			{
+				function(i, worker);
+			}
+		}, &counter);
+	}
+
+	Wait(counter);
+}
+
+void vk::JobSystem::Enqueue(Job job)
+{
+	if (job.worker != AnyWorker)
+	{
+		const uint32_t worker = job.worker;
+		{
+			std::lock_guard<std::mutex> lock(m_Workers[worker]->mutex);
+			m_Workers[worker]->pinned.push_back(std::move(job));
+		}
+		m_PinnedJobs[worker]++;
+
+		// Only the one worker can take it, wake everyone so it's guaranteed to be among them
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_WakeCondition.notify_all();
+		return;
+	}
+
+	// New jobs go onto the queue of the worker that created them
+	Worker& owner = *m_Workers[std::min(GetWorkerIndex(), GetWorkerCount() - 1)];
+	{
+		std::lock_guard<std::mutex> lock(owner.mutex);
+		owner.jobs.push_back(std::move(job));
+	}
+	m_StealableJobs++;
+
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+	}
+	m_WakeCondition.notify_one();
+}
+
+void vk::JobSystem::Finish(Job& job)
+{
+	if (job.signal == nullptr)
+		return;
+
+	std::vector<Job> ready;
+	{
+		std::lock_guard<std::mutex> lock(job.signal->m_Mutex);
+		if (job.signal->m_Count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			ready.swap(job.signal->m_Continuations);
+		}
+	}
+
+	for (auto& continuation : ready)
+	{
+		Enqueue(std::move(continuation));
+	}
+}
+
+bool vk::JobSystem::RunOne(uint32_t worker)
+{
+	Job job;
+	if (!Pop(worker, job) && !Steal(worker, job))
+		return false;
+
+	job.function();
+	Finish(job);
+
+	return true;
+}
+
+bool vk::JobSystem::Pop(uint32_t worker, Job& job)
+{
+	Worker& self = *m_Workers[worker];
+	std::lock_guard<std::mutex> lock(self.mutex);
+
+	if (!self.pinned.empty())
+	{
+		job = std::move(self.pinned.front());
+		self.pinned.pop_front();
+		m_PinnedJobs[worker]--;
+		return true;
+	}
+
+	if (!self.jobs.empty())
+	{
+		job = std::move(self.jobs.back());
+		self.jobs.pop_back();
+		m_StealableJobs--;
+		return true;
+	}
+
+	return false;
+}
+
+bool vk::JobSystem::Steal(uint32_t thief, Job& job)
+{
+	const uint32_t workerCount = GetWorkerCount();
+
+	for (uint32_t offset = 1; offset < workerCount; offset++)
+	{
+		Worker& victim = *m_Workers[(thief + offset) % workerCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+
+		// Take the oldest job, it's the one the owner is least likely to want next
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			m_StealableJobs--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void vk::JobSystem::WorkerLoop(uint32_t worker)
+{
+	t_WorkerIndex = worker;
+
+	while (m_Running)
+	{
+		if (RunOne(worker))
+			continue;
+
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_WakeCondition.wait(lock, [&]() { return !m_Running || m_StealableJobs > 0 || m_PinnedJobs[worker] > 0; });
+	}
+}
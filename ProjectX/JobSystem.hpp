@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing job scheduler. Every worker owns a deque: it pushes and pops its own jobs at the back
+// (most recent first, cache warm) while idle workers steal the oldest jobs from the front of other deques.
+// The thread that creates the job system is worker 0 and runs jobs whenever it waits on a counter.
+namespace vk
+{
+	class JobCounter;
+
+	struct Job
+	{
+		std::function<void()> function;
+		JobCounter* signal = nullptr;
+		uint32_t worker = UINT32_MAX; // UINT32_MAX lets any worker run it
+	};
+
+	// Number of unfinished jobs signalling it. Jobs can depend on a counter, they are only queued once it reaches zero.
+	class JobCounter
+	{
+	public:
+		bool IsDone() const { return m_Count.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> m_Count = 0;
+		std::mutex m_Mutex;
+		std::vector<Job> m_Continuations;
+	};
+
+	class JobSystem
+	{
+	public:
+		static constexpr uint32_t AnyWorker = UINT32_MAX;
+
+		// workerCount includes the calling thread, 0 uses one worker per hardware thread.
+		// pinThreads locks the calling thread to core 0 and spreads the other workers over the remaining cores.
+		explicit JobSystem(uint32_t workerCount = 0, bool pinThreads = false);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// signal is incremented now and decremented once the job has run. The job isn't queued until dependency reaches zero.
+		// Jobs given a worker index only ever run on that worker.
+		void Schedule(std::function<void()> function, JobCounter* signal = nullptr, JobCounter* dependency = nullptr, uint32_t worker = AnyWorker);
+
+		// Runs other jobs until the counter reaches zero
+		void Wait(JobCounter& counter);
+
+		// Calls function(index, workerIndex) for every index in [0, count), grain indices per job, and waits for all of them
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)>& function, uint32_t grain = 1);
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+		// Index of the calling worker, worker 0 is the thread that created the job system
+		static uint32_t GetWorkerIndex();
+
+	private:
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<Job> jobs;
+			std::deque<Job> pinned; // never stolen
+		};
+
+		void Enqueue(Job job);
+		void Finish(Job& job);
+		bool RunOne(uint32_t worker);
+		bool Pop(uint32_t worker, Job& job);
+		bool Steal(uint32_t thief, Job& job);
+		void WorkerLoop(uint32_t worker);
+
+		std::vector<std::unique_ptr<Worker>> m_Workers;
+		std::vector<std::thread> m_Threads;
+
+		std::atomic<bool> m_Running;
+		std::atomic<uint32_t> m_StealableJobs;
+		std::unique_ptr<std::atomic<uint32_t>[]> m_PinnedJobs;
+		std::mutex m_SleepMutex;
+		std::condition_variable m_WakeCondition;
+	};
+}
@@ -19,9 +19,5 @@ namespace vk
 		LightType Type = LightType::Directional;
 		glm::vec4 position;
 		glm::vec4 colour = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-		glm::mat4 LightSpaceMatrix = glm::mat4(1.0f);
-		float View = 13.0f;
-		float Near = 100.1f;
-		float Far = -62.0f;
 	};
 }
\ No newline at end of file
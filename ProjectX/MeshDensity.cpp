@@ -5,16 +5,16 @@
 #include "baked_model.hpp"
 #include "Utils.hpp"
 #include "Buffer.hpp"
-#include "RenderPass.hpp"
+#include "Rendering.hpp"
 #include "Camera.hpp"
+#include "CullingView.hpp"
 
-vk::MeshDensity::MeshDensity(Context& context, Image& depthPrepass, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera) :
+vk::MeshDensity::MeshDensity(Context& context, Image& depthPrepass, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera, CullingView& cullingView) :
 	context{ context },
 	depthPrepass{ depthPrepass },
 	scene{ scene },
 	camera{ camera },
-	m_renderPass{ VK_NULL_HANDLE },
-	m_framebuffer{ VK_NULL_HANDLE },
+	cullingView{ cullingView },
 	m_descriptorSetLayout{VK_NULL_HANDLE},
 	m_pipeline{ VK_NULL_HANDLE },
 	m_pipelineLayout{VK_NULL_HANDLE}
@@ -31,8 +31,6 @@ vk::MeshDensity::MeshDensity(Context& context, Image& depthPrepass, std::shared_
 	);
 
 	BuildDescriptors();
-	CreateRenderPass();
-	CreateFramebuffer();
 	CreatePipeline();
 }
 
@@ -42,9 +40,7 @@ vk::MeshDensity::~MeshDensity()
 
 	vkDestroyPipeline(context.device, m_pipeline, nullptr);
 	vkDestroyPipelineLayout(context.device, m_pipelineLayout, nullptr);
-	
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-	vkDestroyRenderPass(context.device, m_renderPass, nullptr);
+
 	vkDestroyDescriptorSetLayout(context.device, m_descriptorSetLayout, nullptr);
 }
 
@@ -53,8 +49,6 @@ void vk::MeshDensity::Resize()
 	uint32_t width = context.extent.width;
 	uint32_t height = context.extent.height;
 
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-
 	m_RenderTarget.Destroy(context.device);
 
 	m_RenderTarget = CreateImageTexture2D(
@@ -67,8 +61,6 @@ void vk::MeshDensity::Resize()
 		VK_IMAGE_ASPECT_COLOR_BIT,
 		1
 	);
-
-	CreateFramebuffer();
 }
 
 void vk::MeshDensity::Execute(VkCommandBuffer cmd)
@@ -77,16 +69,12 @@ void vk::MeshDensity::Execute(VkCommandBuffer cmd)
 	RenderPassLabel(cmd, "MeshDensity");
 #endif // !DEBUG
 
-	VkRenderPassBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	beginInfo.renderPass = m_renderPass;
-	beginInfo.framebuffer = m_framebuffer;
-	beginInfo.renderArea.extent = context.extent;
+	BeginColorTarget(cmd, m_RenderTarget.image);
 
-	VkClearValue clearValues[1];
-	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	beginInfo.clearValueCount = 1;
-	beginInfo.pClearValues = clearValues;
+	// Only tests against the depth-prepass, which is already in the read-only layout it was released in
+	RenderingInfo rendering(context.extent);
+	rendering.AddColorAttachment(m_RenderTarget.imageView, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+	rendering.SetDepthAttachment(depthPrepass.imageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_NONE);
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -102,20 +90,20 @@ void vk::MeshDensity::Execute(VkCommandBuffer cmd)
 	scissor.extent = { context.extent.width, context.extent.height };
 	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	rendering.Begin(cmd);
 
 	// =========================
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
-	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_descriptorSets[currentFrame], 0, nullptr);
+	// Only the vertex shader's object lookup uses set 2, set 1 keeps the layout compatible with the textured passes
+	VkDescriptorSet sets[] = { m_descriptorSets[currentFrame], context.bindlessTextures->GetSet(), scene->GetDrawDataSet() };
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 3, sets, 0, nullptr);
 
-	// Draw front freshes
-	scene->RenderFrontMeshes(cmd, m_pipelineLayout);
+	// Density doesn't depend on alpha masking, every mesh goes through the same pipeline
+	cullingView.Draw(cmd, Scene::DrawFilter::All);
 
-	// Bind alpha masking pipeline for back meshes : Determine is we're rendering the default scene output, if so use alpha making pipeline else use debug pipelines
-	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
-	scene->RenderBackMeshes(cmd, m_pipelineLayout);
+	vkCmdEndRendering(cmd);
 
-	vkCmdEndRenderPass(cmd);
+	EndColorTarget(cmd, m_RenderTarget.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 #ifdef _DEBUG
 	EndRenderPassLabel(cmd);
@@ -124,83 +112,19 @@ void vk::MeshDensity::Execute(VkCommandBuffer cmd)
 
 void vk::MeshDensity::CreatePipeline()
 {
-	VkPushConstantRange pushConstantRange = {
-		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_GEOMETRY_BIT,
-		.offset = 0,
-		.size = sizeof(MeshPushConstants)
-	};
-
-	auto meshDensityPipeline = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
 		.AddShader("../Engine/assets/shaders/mesh_density.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/mesh_density.geom.spv", ShaderType::GEOM)
 		.AddShader("../Engine/assets/shaders/mesh_density.frag.spv", ShaderType::FRAGMENT)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
 		.SetDynamicState({ {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR} })
 		.SetRasterizationState(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
-		.SetPipelineLayout({ {m_descriptorSetLayout} }, pushConstantRange)
+		.SetPipelineLayout({ m_descriptorSetLayout, context.bindlessTextures->GetLayout(), scene->GetDrawDataLayout() })
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
 		.AddBlendAttachmentState()
 		.SetDepthState(VK_TRUE, VK_FALSE, VK_COMPARE_OP_LESS_OR_EQUAL)
-		.SetRenderPass(m_renderPass)
-		.Build();
-
-	m_pipeline = meshDensityPipeline.first;
-	m_pipelineLayout = meshDensityPipeline.second;
-}
-
-void vk::MeshDensity::CreateRenderPass()
-{
-	RenderPass builder(context.device, 1);
-
-	m_renderPass = builder
-		.AddAttachment(context.swapchainFormat, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddAttachment(VK_FORMAT_D32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_NONE, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-		.SetDepthAttachmentRef(0, 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
-		.AddColorAttachmentRef(0, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-
-		// External -> 0 : Color 
-		.AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-		// 0 -> External : Color : Wait for color writing to finish on the attachment before the fragment shader tries to read from it 
-		.AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-
-		// External -> 0 : Depth
-		// Wait for the depth-prepass to finish writing to the depth attachment before this pass uses it for depth comparison 
-		.AddDependency(
-			VK_SUBPASS_EXTERNAL, 0, 
-			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 
-			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, 
-			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 
-			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT)
-
-
-		 // 0 -> External : Depth
-		 // Wait for this pass to finish reading from the depth attachment to occlude fragments before the depth-prepass writes to it
-		.AddDependency(0, VK_SUBPASS_EXTERNAL, 
-			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 
-			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, 
-			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, 
-			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT)
-
-		.Build();
-}
-
-void vk::MeshDensity::CreateFramebuffer()
-{
-	// Framebuffer
-	std::vector<VkImageView> attachments = { m_RenderTarget.imageView, depthPrepass.imageView };
-	VkFramebufferCreateInfo fbcInfo = {
-		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-		.renderPass = m_renderPass,
-		.attachmentCount = static_cast<uint32_t>(attachments.size()),
-		.pAttachments = attachments.data(),
-		.width = context.extent.width,
-		.height = context.extent.height,
-		.layers = 1
-	};
-
-	VK_CHECK(vkCreateFramebuffer(context.device, &fbcInfo, nullptr, &m_framebuffer), "Failed to create mesh density pass framebuffer.");
+		.SetRenderingFormats({ context.swapchainFormat }, VK_FORMAT_D32_SFLOAT)
+		.BuildDeferred(m_pipeline, m_pipelineLayout);
 }
 
 void vk::MeshDensity::BuildDescriptors()
@@ -214,7 +138,7 @@ void vk::MeshDensity::BuildDescriptors()
 
 		m_descriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
 
-		AllocateDescriptorSets(context, context.descriptorPool, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
+		AllocateDescriptorSets(context, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
 	}
 
 	// Camera Transform UBO
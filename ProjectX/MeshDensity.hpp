@@ -9,12 +9,13 @@ namespace vk
 	class Context;
 	class Scene;
 	class Buffer;
+	class CullingView;
 
 	class MeshDensity
 	{
 	public:
 
-		MeshDensity(Context& context, Image& depthPrepass, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera);
+		MeshDensity(Context& context, Image& depthPrepass, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera, CullingView& cullingView);
 		~MeshDensity();
 		void Execute(VkCommandBuffer cmd);
 
@@ -23,17 +24,14 @@ namespace vk
 
 	private:
 		void CreatePipeline();
-		void CreateRenderPass();
-		void CreateFramebuffer();
 		void BuildDescriptors();
 
 		Context& context;
 		Image& depthPrepass;
 		std::shared_ptr<Scene> scene;
 		std::shared_ptr<Camera> camera;
+		CullingView& cullingView;
 		Image m_RenderTarget;
-		VkRenderPass m_renderPass;
-		VkFramebuffer m_framebuffer;
 		VkDescriptorSetLayout m_descriptorSetLayout;
 		VkPipeline m_pipeline;
 		VkPipelineLayout m_pipelineLayout;
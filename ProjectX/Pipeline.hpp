@@ -6,7 +6,12 @@
 #include <optional>
 #include <fstream>
 #include <utility>
+#include <memory>
+#include <tuple>
 #include "Utils.hpp"
+#include "PipelineCache.hpp"
+#include "ShaderLibrary.hpp"
+#include "PipelineVariants.hpp"
 #include "baked_model.hpp"
 
 /*
@@ -63,9 +68,11 @@ namespace vk {
 
             {}
 
-            // Add a shader to the pipeline
+            // Add a shader to the pipeline, the module is shared with every other pipeline using the same SPIR-V
             PipelineBuilder& AddShader(const std::string& shaderPath, ShaderType type) {
-                shaders.push_back({ ShaderTypeToVkShaderStage(type), CreateShaderModule(shaderPath) });
+                ShaderLibrary* library = ShaderLibrary::Get();
+                assert(library != nullptr);
+                shaders.push_back({ ShaderTypeToVkShaderStage(type), library->Load(shaderPath) });
                 return *this;
             }
 
@@ -81,10 +88,11 @@ namespace vk {
 
             PipelineBuilder& SetDynamicState(const std::vector<VkDynamicState>& dynamicStates) {
 
+                m_dynamicStates = dynamicStates;
+
                 m_dynamicStateInfo = {};
                 m_dynamicStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-                m_dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-                m_dynamicStateInfo.pDynamicStates = dynamicStates.data();
+                m_dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(m_dynamicStates.size());
 
                 return *this;
             }
@@ -105,6 +113,20 @@ namespace vk {
                 return *this;
             }
 
+            // Specialization constants of one of the added shaders, replaces earlier ones for the same stage
+            PipelineBuilder& SetSpecialization(ShaderType type, const SpecializationConstants& constants) {
+                const VkShaderStageFlagBits stage = ShaderTypeToVkShaderStage(type);
+                for (auto& specialization : m_specializations) {
+                    if (specialization.first == stage) {
+                        specialization.second = constants;
+                        return *this;
+                    }
+                }
+
+                m_specializations.push_back({ stage, constants });
+                return *this;
+            }
+
             // Set the pipeline layout
             PipelineBuilder& SetPipelineLayout(const std::vector<VkDescriptorSetLayout>& layouts, const std::optional<VkPushConstantRange>& pushConstant = std::nullopt) {
                 descriptorLayouts = layouts;
@@ -112,15 +134,13 @@ namespace vk {
                 m_pipelineLayout = {};
                 m_pipelineLayout.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
                 m_pipelineLayout.setLayoutCount = static_cast<uint32_t>(descriptorLayouts.size());
-                m_pipelineLayout.pSetLayouts = descriptorLayouts.data();
 
                 if (pushConstant.has_value()) {
+                    pushConstantRange = pushConstant.value();
                     m_pipelineLayout.pushConstantRangeCount = 1;
-                    m_pipelineLayout.pPushConstantRanges = &pushConstant.value();
                 }
                 else {
                     m_pipelineLayout.pushConstantRangeCount = 0;
-                    m_pipelineLayout.pPushConstantRanges = nullptr;
                 }
                 
 
@@ -173,9 +193,10 @@ namespace vk {
                 return *this;
             }
 
-            // Set the render pass (only for graphics pipelines)
-            PipelineBuilder& SetRenderPass(VkRenderPass renderPass) {
-                this->renderPass = renderPass;
+            // Attachment formats of the dynamic rendering instance the pipeline is used in (only for graphics pipelines)
+            PipelineBuilder& SetRenderingFormats(const std::vector<VkFormat>& colorFormats, VkFormat depthFormat = VK_FORMAT_UNDEFINED) {
+                m_colorFormats = colorFormats;
+                m_depthFormat = depthFormat;
 
                 return *this;
             }
@@ -191,15 +212,45 @@ namespace vk {
                 }
             }
 
+            // Variant cache for a pipeline whose specializedStage shader is specialized on quality settings. The layout is
+            // created now and shared, every set of constants asked for gets a copy of this description to compile.
+            PipelineVariants BuildVariants(ShaderType specializedStage) {
+                VkPipelineLayout layout = BuildLayout();
+                auto base = std::make_shared<PipelineBuilder>(*this);
+                const ShaderType stage = specializedStage;
+
+                return PipelineVariants(device, layout, [base, stage](const SpecializationConstants& constants) {
+                    return PipelineBuilder(*base).SetSpecialization(stage, constants).Build().first;
+                });
+            }
+
+            // Compiles on a worker thread of the job system instead. The description is moved into the job, which writes
+            // pipeline and layout when it's done, neither may be read before PipelineCache::WaitForCompiles() returned.
+            void BuildDeferred(VkPipeline& pipeline, VkPipelineLayout& layout) {
+                PipelineCache* cache = PipelineCache::Get();
+                if (cache == nullptr) {
+                    std::tie(pipeline, layout) = Build();
+                    return;
+                }
+
+                auto builder = std::make_shared<PipelineBuilder>(std::move(*this));
+                cache->Compile([builder, &pipeline, &layout]() {
+                    std::tie(pipeline, layout) = builder->Build();
+                });
+            }
+
         private:
             VkDevice device;
             uint32_t subpass;
             PipelineType pipelineType;
-            VkRenderPass renderPass = VK_NULL_HANDLE;
+            std::vector<VkFormat> m_colorFormats;
+            VkFormat m_depthFormat = VK_FORMAT_UNDEFINED;
             VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
             std::vector<std::pair<VkShaderStageFlagBits, VkShaderModule>> shaders;
             std::vector<VkDescriptorSetLayout> descriptorLayouts;
-            VkPushConstantRange pushConstantRange;
+            VkPushConstantRange pushConstantRange{};
+            std::vector<VkDynamicState> m_dynamicStates;
+            std::vector<std::pair<VkShaderStageFlagBits, SpecializationConstants>> m_specializations;
 
             VkPipelineInputAssemblyStateCreateInfo m_inputAssembly{};
             VkPipelineDynamicStateCreateInfo m_dynamicStateInfo{};
@@ -212,27 +263,37 @@ namespace vk {
 
             VertexBinding binding;
 
-            VkShaderModule CreateShaderModule(const std::string& shaderPath) {
-
-                std::vector<char> shaderCode = ReadShader(shaderPath);
+            // The create infos point into the builder's own members, only done right before use since the builder
+            // may have been moved into a job after they were set
+            void ResolveStatePointers() {
+                m_dynamicStateInfo.pDynamicStates = m_dynamicStates.data();
+                m_pipelineLayout.pSetLayouts = descriptorLayouts.data();
+                m_pipelineLayout.pPushConstantRanges = m_pipelineLayout.pushConstantRangeCount > 0 ? &pushConstantRange : nullptr;
+            }
 
-                VkShaderModuleCreateInfo createInfo = {};
-                createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-                createInfo.codeSize = shaderCode.size();
-                createInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+            // Creates only the layout, builds after this reuse it instead of creating their own
+            VkPipelineLayout BuildLayout() {
+                ResolveStatePointers();
+                VK_CHECK(vkCreatePipelineLayout(device, &m_pipelineLayout, nullptr, &pipelineLayout), "Failed to create pipeline layout");
+                return pipelineLayout;
+            }
 
-                VkShaderModule shaderModule;
-                if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-                    throw std::runtime_error("Failed to create shader module!");
+            const SpecializationConstants* FindSpecialization(VkShaderStageFlagBits stage) const {
+                for (const auto& specialization : m_specializations) {
+                    if (specialization.first == stage)
+                        return &specialization.second;
                 }
-
-                return shaderModule;
+                return nullptr;
             }
 
             // Create a graphics pipeline
             VkPipeline CreateGraphicsPipeline() {
 
+                ResolveStatePointers();
+
                 std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+                std::vector<VkSpecializationInfo> specializationInfos;
+                specializationInfos.reserve(shaders.size());
 
                 for (const auto& shader : shaders) {
                     VkPipelineShaderStageCreateInfo shaderStageInfo{};
@@ -240,6 +301,12 @@ namespace vk {
                     shaderStageInfo.stage = shader.first;
                     shaderStageInfo.module = shader.second;
                     shaderStageInfo.pName = "main";
+
+                    if (const SpecializationConstants* constants = FindSpecialization(shader.first)) {
+                        specializationInfos.push_back(constants->GetInfo());
+                        shaderStageInfo.pSpecializationInfo = &specializationInfos.back();
+                    }
+
                     shaderStages.push_back(shaderStageInfo);
                 }
 
@@ -274,11 +341,25 @@ namespace vk {
                 blendInfo.attachmentCount = static_cast<uint32_t>(m_blendAttachments.size());
                 blendInfo.pAttachments = m_blendAttachments.data();
 
-                VK_CHECK(vkCreatePipelineLayout(device, &m_pipelineLayout, nullptr, &pipelineLayout), "Failed to create pipeline layout");
+                if (pipelineLayout == VK_NULL_HANDLE) {
+                    VK_CHECK(vkCreatePipelineLayout(device, &m_pipelineLayout, nullptr, &pipelineLayout), "Failed to create pipeline layout");
+                }
+
+                VkPipelineRenderingCreateInfo renderingInfo{ VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO };
+                renderingInfo.colorAttachmentCount = static_cast<uint32_t>(m_colorFormats.size());
+                renderingInfo.pColorAttachmentFormats = m_colorFormats.data();
+                renderingInfo.depthAttachmentFormat = m_depthFormat;
+
+                // Tells whether the driver found the pipeline in the cache
+                VkPipelineCreationFeedback feedback{};
+                VkPipelineCreationFeedbackCreateInfo feedbackInfo{ VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+                feedbackInfo.pPipelineCreationFeedback = &feedback;
+                renderingInfo.pNext = &feedbackInfo;
 
                 // Create graphics pipeline
                 VkGraphicsPipelineCreateInfo pipelineInfo{};
                 pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                pipelineInfo.pNext = &renderingInfo;
                 pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
                 pipelineInfo.pStages = shaderStages.data();
                 pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -291,16 +372,18 @@ namespace vk {
                 pipelineInfo.pDepthStencilState = &m_depthState;
                 pipelineInfo.pColorBlendState = &blendInfo;
                 pipelineInfo.layout = pipelineLayout;
-                pipelineInfo.renderPass = renderPass;
+                pipelineInfo.renderPass = VK_NULL_HANDLE;
                 pipelineInfo.subpass = subpass;
 
+                PipelineCache* cache = PipelineCache::Get();
+
                 VkPipeline pipeline;
-                if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+                if (vkCreateGraphicsPipelines(device, cache ? cache->GetHandle() : VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
                     throw std::runtime_error("Failed to create graphics pipeline!");
                 }
 
-                for (auto& pair : shaders)
-                    vkDestroyShaderModule(device, pair.second, nullptr);
+                if (cache)
+                    cache->RecordCreation(feedback);
 
                 return pipeline;
             }
@@ -315,43 +398,39 @@ namespace vk {
                 computeShaderStageInfo.module = shaders[0].second;
                 computeShaderStageInfo.pName = "main";
 
-                VK_CHECK(vkCreatePipelineLayout(device, &m_pipelineLayout, nullptr, &pipelineLayout), "Failed to create compute pipeline layout");
+                VkSpecializationInfo specializationInfo{};
+                if (const SpecializationConstants* constants = FindSpecialization(VK_SHADER_STAGE_COMPUTE_BIT)) {
+                    specializationInfo = constants->GetInfo();
+                    computeShaderStageInfo.pSpecializationInfo = &specializationInfo;
+                }
+
+                ResolveStatePointers();
+                if (pipelineLayout == VK_NULL_HANDLE) {
+                    VK_CHECK(vkCreatePipelineLayout(device, &m_pipelineLayout, nullptr, &pipelineLayout), "Failed to create compute pipeline layout");
+                }
 
                 VkComputePipelineCreateInfo computePipelineInfo{};
                 computePipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
                 computePipelineInfo.stage = computeShaderStageInfo;
                 computePipelineInfo.layout = pipelineLayout;
 
+                VkPipelineCreationFeedback feedback{};
+                VkPipelineCreationFeedbackCreateInfo feedbackInfo{ VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+                feedbackInfo.pPipelineCreationFeedback = &feedback;
+                computePipelineInfo.pNext = &feedbackInfo;
+
+                PipelineCache* cache = PipelineCache::Get();
+
                 VkPipeline pipeline;
-                if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &computePipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+                if (vkCreateComputePipelines(device, cache ? cache->GetHandle() : VK_NULL_HANDLE, 1, &computePipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
                     throw std::runtime_error("Failed to create compute pipeline!");
                 }
 
-                for (auto& pair : shaders)
-                    vkDestroyShaderModule(device, pair.second, nullptr);
+                if (cache)
+                    cache->RecordCreation(feedback);
 
                 return pipeline;
             }
-
-            // Reference: https://vulkan-tutorial.com/Drawing_a_triangle/Graphics_pipeline_basics/Shader_modules
-            std::vector<char> ReadShader(const std::string& filename)
-            {
-                std::ifstream file(filename, std::ios::ate | std::ios::binary);
-                if (!file.is_open())
-                {
-                    throw std::runtime_error("Failed to open shader file.");
-                }
-
-                size_t fileSize = (size_t)file.tellg();
-                std::vector<char> buffer(fileSize);
-
-                file.seekg(0);
-                file.read(buffer.data(), fileSize);
-
-                file.close();
-
-                return buffer;
-            }
         };
     }
 }
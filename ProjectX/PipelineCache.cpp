@@ -0,0 +1,166 @@
+#include "PipelineCache.hpp"
+#include "Context.hpp"
+#include "Utils.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+	std::vector<char> ReadFile(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+			return {};
+
+		std::vector<char> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(data.data(), data.size());
+
+		return data;
+	}
+}
+
+vk::PipelineCache::PipelineCache(Context& context, const std::string& path) :
+	context{context}, m_Path{path}, m_Cache{VK_NULL_HANDLE}, m_LoadedBytes{0}, m_Pipelines{0}, m_Hits{0}, m_CreationNs{0}
+{
+	std::vector<char> data = ReadFile(path);
+	if (!data.empty() && !IsCompatible(data))
+	{
+		std::cout << "Pipeline cache: " << path << " was written by another device or driver, starting empty" << std::endl;
+		data.clear();
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+	cacheInfo.initialDataSize = data.size();
+	cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	if (vkCreatePipelineCache(context.device, &cacheInfo, nullptr, &m_Cache) != VK_SUCCESS)
+	{
+		// A driver may still reject data that passed the header check, fall back to an empty cache
+		ERROR("Failed to create pipeline cache from " + path);
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = nullptr;
+		data.clear();
+		VK_CHECK(vkCreatePipelineCache(context.device, &cacheInfo, nullptr, &m_Cache), "Failed to create pipeline cache");
+	}
+
+	m_LoadedBytes = data.size();
+	context.SetObjectName(context.device, (uint64_t)m_Cache, VK_OBJECT_TYPE_PIPELINE_CACHE, "PipelineCache");
+
+	s_Instance = this;
+}
+
+void vk::PipelineCache::Save() const
+{
+	size_t size = 0;
+	VK_CHECK(vkGetPipelineCacheData(context.device, m_Cache, &size, nullptr), "Failed to get pipeline cache size");
+
+	std::vector<char> data(size);
+	VK_CHECK(vkGetPipelineCacheData(context.device, m_Cache, &size, data.data()), "Failed to get pipeline cache data");
+
+	// Written next to the old file and swapped in, a crash while saving can't leave a truncated cache behind
+	const std::string tempPath = m_Path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			ERROR("Failed to write pipeline cache to " + tempPath);
+			return;
+		}
+
+		file.write(data.data(), size);
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, m_Path, error);
+	if (error)
+	{
+		ERROR("Failed to replace pipeline cache " + m_Path + ": " + error.message());
+	}
+}
+
+void vk::PipelineCache::Destroy()
+{
+	vkDestroyPipelineCache(context.device, m_Cache, nullptr);
+	m_Cache = VK_NULL_HANDLE;
+
+	if (s_Instance == this)
+	{
+		s_Instance = nullptr;
+	}
+}
+
+void vk::PipelineCache::Compile(std::function<void()> build)
+{
+	context.jobSystem->Schedule([this, build = std::move(build)]()
+	{
+		// An exception can't leave a worker thread, it's handed to whoever waits for the compiles
+		try
+		{
+			build();
+		}
+		catch (const std::exception& e)
+		{
+			std::lock_guard<std::mutex> lock(m_ErrorMutex);
+			m_CompileError = e.what();
+		}
+	}, &m_Compiles);
+}
+
+void vk::PipelineCache::WaitForCompiles()
+{
+	context.jobSystem->Wait(m_Compiles);
+
+	std::lock_guard<std::mutex> lock(m_ErrorMutex);
+	if (!m_CompileError.empty())
+	{
+		throw std::runtime_error(std::exchange(m_CompileError, ""));
+	}
+}
+
+void vk::PipelineCache::RecordCreation(const VkPipelineCreationFeedback& feedback)
+{
+	m_Pipelines.fetch_add(1, std::memory_order_relaxed);
+
+	if ((feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) == 0)
+		return;
+
+	if ((feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0)
+	{
+		m_Hits.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	m_CreationNs.fetch_add(feedback.duration, std::memory_order_relaxed);
+}
+
+vk::PipelineCache::Stats vk::PipelineCache::GetStats() const
+{
+	Stats stats;
+	stats.pipelines = m_Pipelines.load(std::memory_order_relaxed);
+	stats.hits = m_Hits.load(std::memory_order_relaxed);
+	stats.creationNs = m_CreationNs.load(std::memory_order_relaxed);
+	stats.loadedBytes = m_LoadedBytes;
+
+	return stats;
+}
+
+bool vk::PipelineCache::IsCompatible(const std::vector<char>& data) const
+{
+	VkPipelineCacheHeaderVersionOne header;
+	if (data.size() < sizeof(header))
+		return false;
+
+	std::memcpy(&header, data.data(), sizeof(header));
+
+	VkPhysicalDeviceProperties props;
+	vkGetPhysicalDeviceProperties(context.pDevice, &props);
+
+	return header.headerSize >= sizeof(header) &&
+		header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		header.vendorID == props.vendorID &&
+		header.deviceID == props.deviceID &&
+		std::memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
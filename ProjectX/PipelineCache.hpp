@@ -0,0 +1,65 @@
+#pragma once
+#include <volk/volk.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "JobSystem.hpp"
+
+// VkPipelineCache kept on disk between runs. The file is only used when its header matches the vendor, device and
+// pipeline cache UUID of the driver that's running, anything else (other GPU, driver update) starts from an empty cache.
+// There is one per process, every PipelineBuilder compiles through it.
+namespace vk
+{
+	class Context;
+
+	class PipelineCache
+	{
+	public:
+		struct Stats
+		{
+			uint32_t pipelines = 0;
+			uint32_t hits = 0;          // pipelines the driver could take from the cache without compiling
+			uint64_t creationNs = 0;    // summed over every pipeline
+			size_t loadedBytes = 0;     // 0 when nothing usable was found on disk
+		};
+
+		PipelineCache(Context& context, const std::string& path);
+
+		// Writes the cache back to the file it was loaded from, called on shutdown
+		void Save() const;
+		void Destroy();
+
+		VkPipelineCache GetHandle() const { return m_Cache; }
+
+		// Runs a pipeline build on the job system, see PipelineBuilder::BuildDeferred
+		void Compile(std::function<void()> build);
+		// Helps compiling until every scheduled build has finished, throws if any of them failed
+		void WaitForCompiles();
+
+		// Creation feedback of a pipeline built through the cache, safe to call from any thread
+		void RecordCreation(const VkPipelineCreationFeedback& feedback);
+		Stats GetStats() const;
+
+		// The process-wide cache, nullptr before the context has created it
+		static PipelineCache* Get() { return s_Instance; }
+
+	private:
+		bool IsCompatible(const std::vector<char>& data) const;
+
+		Context& context;
+		std::string m_Path;
+		VkPipelineCache m_Cache;
+		size_t m_LoadedBytes;
+		std::atomic<uint32_t> m_Pipelines;
+		std::atomic<uint32_t> m_Hits;
+		std::atomic<uint64_t> m_CreationNs;
+
+		JobCounter m_Compiles;
+		std::mutex m_ErrorMutex;
+		std::string m_CompileError;
+
+		static inline PipelineCache* s_Instance = nullptr;
+	};
+}
@@ -0,0 +1,90 @@
+#include "PipelineVariants.hpp"
+#include "PipelineCache.hpp"
+
+std::vector<uint32_t> vk::SpecializationConstants::GetKey() const
+{
+	std::vector<uint32_t> key;
+	key.reserve(m_Entries.size() * 2);
+	for (size_t i = 0; i < m_Entries.size(); i++)
+	{
+		key.push_back(m_Entries[i].constantID);
+		key.push_back(m_Data[i]);
+	}
+
+	return key;
+}
+
+VkSpecializationInfo vk::SpecializationConstants::GetInfo() const
+{
+	VkSpecializationInfo info{};
+	info.mapEntryCount = static_cast<uint32_t>(m_Entries.size());
+	info.pMapEntries = m_Entries.data();
+	info.dataSize = m_Data.size() * sizeof(uint32_t);
+	info.pData = m_Data.data();
+
+	return info;
+}
+
+vk::SpecializationConstants& vk::SpecializationConstants::SetBits(uint32_t constantID, uint32_t bits)
+{
+	for (size_t i = 0; i < m_Entries.size(); i++)
+	{
+		if (m_Entries[i].constantID == constantID)
+		{
+			m_Data[i] = bits;
+			return *this;
+		}
+	}
+
+	m_Entries.push_back({ constantID, static_cast<uint32_t>(m_Data.size() * sizeof(uint32_t)), sizeof(uint32_t) });
+	m_Data.push_back(bits);
+	return *this;
+}
+
+vk::PipelineVariants::PipelineVariants(VkDevice device, VkPipelineLayout layout, BuildFunction build) :
+	device{ device }, m_Layout{ layout }, m_Build{ std::move(build) }
+{
+}
+
+void vk::PipelineVariants::Prepare(const SpecializationConstants& constants)
+{
+	VkPipeline& pipeline = m_Pipelines[constants.GetKey()];
+	if (pipeline != VK_NULL_HANDLE)
+		return;
+
+	PipelineCache* cache = PipelineCache::Get();
+	if (cache == nullptr)
+	{
+		pipeline = m_Build(constants);
+		return;
+	}
+
+	// std::map never moves its values, the job writes the pipeline in place
+	cache->Compile([build = m_Build, constants, &pipeline]()
+	{
+		pipeline = build(constants);
+	});
+}
+
+VkPipeline vk::PipelineVariants::Get(const SpecializationConstants& constants)
+{
+	VkPipeline& pipeline = m_Pipelines[constants.GetKey()];
+	if (pipeline == VK_NULL_HANDLE)
+	{
+		pipeline = m_Build(constants);
+	}
+
+	return pipeline;
+}
+
+void vk::PipelineVariants::Destroy()
+{
+	for (auto& variant : m_Pipelines)
+	{
+		vkDestroyPipeline(device, variant.second, nullptr);
+	}
+	m_Pipelines.clear();
+
+	vkDestroyPipelineLayout(device, m_Layout, nullptr);
+	m_Layout = VK_NULL_HANDLE;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <volk/volk.h>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <vector>
+
+// Shader variants through specialization constants. A pass whose loop bounds or feature switches come from quality
+// settings declares them as layout(constant_id = N) in GLSL, the driver then compiles each combination with those values
+// known, so loops can be unrolled and disabled branches disappear. Variants are created by PipelineBuilder::BuildVariants.
+namespace vk
+{
+	// Values for the specialization constants of one shader stage. Every value is 4 bytes, matching the GLSL int,
+	// float and bool it replaces.
+	class SpecializationConstants
+	{
+	public:
+		SpecializationConstants& Set(uint32_t constantID, int32_t value) { return SetBits(constantID, static_cast<uint32_t>(value)); }
+		SpecializationConstants& Set(uint32_t constantID, bool value) { return SetBits(constantID, value ? VK_TRUE : VK_FALSE); }
+		SpecializationConstants& Set(uint32_t constantID, float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return SetBits(constantID, bits);
+		}
+
+		// Identifies the variant, constant IDs and values in the order they were set
+		std::vector<uint32_t> GetKey() const;
+
+		// Points into this object, only valid while it's alive and unchanged
+		VkSpecializationInfo GetInfo() const;
+
+	private:
+		SpecializationConstants& SetBits(uint32_t constantID, uint32_t bits);
+
+		std::vector<VkSpecializationMapEntry> m_Entries;
+		std::vector<uint32_t> m_Data;
+	};
+
+	// Variant cache of one pipeline. Every variant shares the layout, the first request for a set of constants compiles
+	// it and later ones return the cached pipeline. Variants are picked on the main thread (the passes' Update) before
+	// recording starts, the cache isn't meant to be used from the recording threads.
+	class PipelineVariants
+	{
+	public:
+		using BuildFunction = std::function<VkPipeline(const SpecializationConstants&)>;
+
+		PipelineVariants() = default;
+		PipelineVariants(VkDevice device, VkPipelineLayout layout, BuildFunction build);
+
+		// Compiles on the job system like PipelineBuilder::BuildDeferred, for the variant wanted on the first frame.
+		// Neither Get nor the pipeline may be used before PipelineCache::WaitForCompiles() returned.
+		void Prepare(const SpecializationConstants& constants);
+
+		// Compiles the variant right away when it hasn't been used before, a one off hitch when a setting changes
+		VkPipeline Get(const SpecializationConstants& constants);
+
+		VkPipelineLayout GetLayout() const { return m_Layout; }
+		size_t GetCount() const { return m_Pipelines.size(); }
+
+		void Destroy();
+
+	private:
+		VkDevice device = VK_NULL_HANDLE;
+		VkPipelineLayout m_Layout = VK_NULL_HANDLE;
+		BuildFunction m_Build;
+		std::map<std::vector<uint32_t>, VkPipeline> m_Pipelines;
+	};
+}
@@ -5,7 +5,7 @@
 #include "baked_model.hpp"
 #include "Utils.hpp"
 #include "Buffer.hpp"
-#include "RenderPass.hpp"
+#include "Rendering.hpp"
 #include "ImGuiRenderer.hpp"
 
 vk::PresentPass::PresentPass(Context& context, Image& renderedScene, Image& deferredRender, Image& meshDensity) :
@@ -15,6 +15,7 @@ vk::PresentPass::PresentPass(Context& context, Image& renderedScene, Image& defe
 	meshDensity{meshDensity},
 	m_pipeline { VK_NULL_HANDLE},
 	m_pipelineLayout{ VK_NULL_HANDLE },
+	m_descriptorUpdateTemplate{ VK_NULL_HANDLE },
 	m_renderType {renderType}
 {
 	m_postProcessUbo.resize(MAX_FRAMES_IN_FLIGHT);
@@ -37,22 +38,14 @@ vk::PresentPass::~PresentPass()
 
 	vkDestroyPipeline(context.device, m_pipeline, nullptr);
 	vkDestroyPipelineLayout(context.device, m_pipelineLayout, nullptr);
+	vkDestroyDescriptorUpdateTemplate(context.device, m_descriptorUpdateTemplate, nullptr);
 	vkDestroyDescriptorSetLayout(context.device, m_descriptorSetLayout, nullptr);
 }
 
 void vk::PresentPass::Resize()
 {
 	// Update the descriptor to the new updated re-sized renderedScene image
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorImageInfo imgInfo = {
-			.sampler = repeatSampler,
-			.imageView = (renderType == RenderType::FORWARD) ? renderedScene.imageView : (renderType == RenderType::DEFERRED) ? deferredRender.imageView : (renderType == RenderType::MESH_DENSITY) ? meshDensity.imageView : renderedScene.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 1, imgInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-	}
+	WriteDescriptors();
 }
 
 void vk::PresentPass::Update()
@@ -63,16 +56,7 @@ void vk::PresentPass::Update()
 	if (m_renderType != renderType)
 	{
 		vkDeviceWaitIdle(context.device);
-		for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-		{
-			VkDescriptorImageInfo imgInfo = {
-				.sampler = repeatSampler,
-				.imageView = (renderType == RenderType::FORWARD) ? renderedScene.imageView : (renderType == RenderType::DEFERRED) ? deferredRender.imageView : (renderType == RenderType::MESH_DENSITY) ? meshDensity.imageView : renderedScene.imageView,
-				.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-			};
-
-			UpdateDescriptorSet(context, 1, imgInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		}
+		WriteDescriptors();
 
 		std::string renderer = renderType == RenderType::FORWARD ? "Forward" : renderType == RenderType::DEFERRED ? "Deferred" : "Forward: Mesh Density";
 		std::cout << "Renderer: " << renderer << std::endl;
@@ -87,16 +71,11 @@ void vk::PresentPass::Execute(VkCommandBuffer cmd, uint32_t imageIndex)
 	RenderPassLabel(cmd, "PresentPass");
 #endif // !DEBUG
 
-	VkRenderPassBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	beginInfo.renderPass = context.renderPass;
-	beginInfo.framebuffer = context.swapchainFramebuffers[imageIndex];
-	beginInfo.renderArea.extent = context.extent;
+	// Waits on the acquire semaphore at COLOR_ATTACHMENT_OUTPUT, which is the stage this transition runs at
+	BeginColorTarget(cmd, context.swapchainImages[imageIndex]);
 
-	VkClearValue clearValues[1];
-	clearValues[0].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-	beginInfo.clearValueCount = 1;
-	beginInfo.pClearValues = clearValues;
+	RenderingInfo rendering(context.extent);
+	rendering.AddColorAttachment(context.swapchainImageViews[imageIndex], VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -112,7 +91,7 @@ void vk::PresentPass::Execute(VkCommandBuffer cmd, uint32_t imageIndex)
 	scissor.extent = { context.extent.width, context.extent.height };
 	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	rendering.Begin(cmd);
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline);
 	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_descriptorSets[currentFrame], 0, nullptr);
 
@@ -121,7 +100,10 @@ void vk::PresentPass::Execute(VkCommandBuffer cmd, uint32_t imageIndex)
 
 	ImGuiRenderer::Render(cmd, context, imageIndex);
 
-	vkCmdEndRenderPass(cmd);
+	vkCmdEndRendering(cmd);
+
+	// Presentation engine reads happen after the semaphore wait, no access to make visible
+	EndColorTarget(cmd, context.swapchainImages[imageIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE);
 
 #ifdef _DEBUG
 	EndRenderPassLabel(cmd);
@@ -132,7 +114,7 @@ void vk::PresentPass::CreatePipeline()
 {
 
 	// Create the pipeline
-	auto pipelineResult = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
 		.AddShader("../Engine/assets/shaders/fs_tri.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/present_pass.frag.spv", ShaderType::FRAGMENT)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
@@ -142,11 +124,8 @@ void vk::PresentPass::CreatePipeline()
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
 		.AddBlendAttachmentState()
 		.SetDepthState(VK_FALSE, VK_FALSE, VK_COMPARE_OP_LESS_OR_EQUAL) // Turn depth read and write OFF ========
-		.SetRenderPass(context.renderPass)
-		.Build();
-
-	m_pipeline = pipelineResult.first;
-	m_pipelineLayout = pipelineResult.second;
+		.SetRenderingFormats({ context.swapchainFormat })
+		.BuildDeferred(m_pipeline, m_pipelineLayout);
 }
 
 void vk::PresentPass::BuildDescriptors()
@@ -161,28 +140,24 @@ void vk::PresentPass::BuildDescriptors()
 
 	m_descriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
 
-	AllocateDescriptorSets(context, context.descriptorPool, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
+	m_descriptorUpdateTemplate = CreateDescriptorUpdateTemplate(context, m_descriptorSetLayout, bindings);
 
+	AllocateDescriptorSets(context, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
 
-	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = m_postProcessUbo[i].buffer;
-		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(PostProcessing);
-		UpdateDescriptorSet(context, 0, bufferInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-	}
+	WriteDescriptors();
+}
 
+void vk::PresentPass::WriteDescriptors()
+{
+	// Binding 1 is the output of whichever renderer is active
+	VkImageView presentedView = (renderType == RenderType::FORWARD) ? renderedScene.imageView : (renderType == RenderType::DEFERRED) ? deferredRender.imageView : (renderType == RenderType::MESH_DENSITY) ? meshDensity.imageView : renderedScene.imageView;
 
 	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
 	{
-		VkDescriptorImageInfo imgInfo = {
-			.sampler = repeatSampler,
-			.imageView = (renderType == RenderType::FORWARD) ? renderedScene.imageView : (renderType == RenderType::DEFERRED) ? deferredRender.imageView : (renderType == RenderType::MESH_DENSITY) ? meshDensity.imageView : renderedScene.imageView,
-			.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL // VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-		};
-
-		UpdateDescriptorSet(context, 1, imgInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		UpdateDescriptorSet(context, m_descriptorUpdateTemplate, m_descriptorSets[i], {
+			DescriptorInfo(m_postProcessUbo[i].buffer, sizeof(PostProcessing)),
+			DescriptorInfo(repeatSampler, presentedView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		});
 	}
 }
 
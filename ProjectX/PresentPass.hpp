@@ -21,6 +21,7 @@ namespace vk
 	private:
 		void CreatePipeline();
 		void BuildDescriptors();
+		void WriteDescriptors();
 
 		Context& context;
 		Image& renderedScene;
@@ -33,6 +34,7 @@ namespace vk
 		VkPipelineLayout m_pipelineLayout;
 		std::vector<VkDescriptorSet> m_descriptorSets;
 		VkDescriptorSetLayout m_descriptorSetLayout;
+		VkDescriptorUpdateTemplate m_descriptorUpdateTemplate;
 		std::vector<Buffer> m_postProcessUbo;
 		RenderType m_renderType;
 	};
@@ -0,0 +1,102 @@
+#include "RadixSort.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+	constexpr uint32_t DigitBits = 8;
+	constexpr uint32_t DigitCount = 1u << DigitBits;
+	constexpr uint32_t PassCount = 64 / DigitBits;
+
+	// Below this many keys per chunk the jobs cost more than the work they split
+	constexpr size_t MinKeysPerChunk = 8192;
+
+	using Histogram = std::array<uint32_t, DigitCount>;
+
+	uint32_t Digit(uint64_t key, uint32_t pass)
+	{
+		return static_cast<uint32_t>(key >> (pass * DigitBits)) & (DigitCount - 1);
+	}
+}
+
+void vk::RadixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch, JobSystem* jobSystem)
+{
+	const size_t count = keys.size();
+	scratch.resize(count);
+	if (count < 2)
+		return;
+
+	// Every chunk keeps its keys in order within each digit, which is what keeps the sort stable across chunks
+	const uint32_t chunkCount = jobSystem ? static_cast<uint32_t>(std::clamp<size_t>(count / MinKeysPerChunk, 1, jobSystem->GetWorkerCount())) : 1;
+	const size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+	std::vector<Histogram> histograms(chunkCount);
+
+	auto forEachChunk = [&](const auto& function)
+	{
+		if (chunkCount == 1)
+		{
+			function(0u);
+			return;
+		}
+
+		jobSystem->ParallelFor(chunkCount, [&](uint32_t chunk, uint32_t) { function(chunk); });
+	};
+
+	uint64_t* source = keys.data();
+	uint64_t* destination = scratch.data();
+
+	for (uint32_t pass = 0; pass < PassCount; pass++)
+	{
+		forEachChunk([&](uint32_t chunk)
+		{
+			Histogram& histogram = histograms[chunk];
+			histogram.fill(0);
+
+			const size_t end = std::min(count, (chunk + 1) * chunkSize);
+			for (size_t i = chunk * chunkSize; i < end; i++)
+			{
+				histogram[Digit(source[i], pass)]++;
+			}
+		});
+
+		// Offsets per chunk and digit: all smaller digits first, then the same digit in the chunks before
+		uint32_t offset = 0;
+		bool sharedDigit = false;
+		for (uint32_t digit = 0; digit < DigitCount; digit++)
+		{
+			const uint32_t digitStart = offset;
+			for (Histogram& histogram : histograms)
+			{
+				const uint32_t keysInChunk = histogram[digit];
+				histogram[digit] = offset;
+				offset += keysInChunk;
+			}
+
+			sharedDigit |= offset - digitStart == count;
+		}
+
+		// Every key lands where it already is
+		if (sharedDigit)
+			continue;
+
+		forEachChunk([&](uint32_t chunk)
+		{
+			Histogram& offsets = histograms[chunk];
+
+			const size_t end = std::min(count, (chunk + 1) * chunkSize);
+			for (size_t i = chunk * chunkSize; i < end; i++)
+			{
+				destination[offsets[Digit(source[i], pass)]++] = source[i];
+			}
+		});
+
+		std::swap(source, destination);
+	}
+
+	if (source != keys.data())
+	{
+		std::copy(source, source + count, keys.data());
+	}
+}
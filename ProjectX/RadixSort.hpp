@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Sorting of 64-bit keys, used for the draw lists' sort keys
+namespace vk
+{
+	class JobSystem;
+
+	// Stable least significant digit radix sort, 8 bits per pass, keys end up ascending. scratch is resized to the key count.
+	// Passes where every key has the same digit are skipped, keys that only differ in their low bytes cost few passes.
+	// Given a job system and enough keys, every pass splits its histogram and scatter across the workers.
+	void RadixSort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch, JobSystem* jobSystem = nullptr);
+}
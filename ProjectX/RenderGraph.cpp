@@ -0,0 +1,391 @@
+#include "RenderGraph.hpp"
+#include "CommandRecorder.hpp"
+#include "JobSystem.hpp"
+#include "TransientAllocator.hpp"
+#include "Barriers.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace
+{
+	constexpr VkPipelineStageFlags DepthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+	bool IsDepthLayout(VkImageLayout layout)
+	{
+		switch (layout)
+		{
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+		case VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL:
+		case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL:
+		case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL:
+		case VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	VkAccessFlags ReadAccess(VkPipelineStageFlags stages)
+	{
+		return (stages & DepthStages) != 0 ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT : VK_ACCESS_SHADER_READ_BIT;
+	}
+
+	const char* LayoutName(VkImageLayout layout)
+	{
+		switch (layout)
+		{
+		case VK_IMAGE_LAYOUT_UNDEFINED:								  return "UNDEFINED";
+		case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:				  return "COLOR_ATTACHMENT";
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:		  return "DEPTH_STENCIL_ATTACHMENT";
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:		  return "DEPTH_STENCIL_READ_ONLY";
+		case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL: return "DEPTH_ATTACHMENT_STENCIL_READ_ONLY";
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:				  return "SHADER_READ_ONLY";
+		default:													  return "OTHER";
+		}
+	}
+
+	// Tracked state of a resource while walking the passes of a frame
+	struct ResourceState
+	{
+		VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags writeStages = 0;
+		VkAccessFlags writeAccess = 0;
+		VkPipelineStageFlags visibleStages = 0;
+		VkPipelineStageFlags readStages = 0;
+		bool written = false;
+	};
+}
+
+vk::RenderGraph::PassBuilder& vk::RenderGraph::PassBuilder::Read(const std::string& resource, VkImageLayout layout, VkPipelineStageFlags stages)
+{
+	graph.m_Passes[pass].reads.push_back(Access{ graph.GetResource(resource), layout, stages });
+	return *this;
+}
+
+vk::RenderGraph::PassBuilder& vk::RenderGraph::PassBuilder::Write(const std::string& resource, VkImageLayout finalLayout, VkPipelineStageFlags releasedTo)
+{
+	graph.m_Passes[pass].writes.push_back(Access{ graph.GetResource(resource), finalLayout, releasedTo });
+	return *this;
+}
+
+vk::RenderGraph::PassBuilder& vk::RenderGraph::PassBuilder::SideEffect()
+{
+	graph.m_Passes[pass].sideEffect = true;
+	return *this;
+}
+
+vk::RenderGraph::PassBuilder& vk::RenderGraph::PassBuilder::Execute(std::function<void(VkCommandBuffer)> execute)
+{
+	graph.m_Passes[pass].execute = std::move(execute);
+	return *this;
+}
+
+void vk::RenderGraph::Reset()
+{
+	m_Passes.clear();
+	m_Resources.clear();
+	m_ResourceIndices.clear();
+	m_BarrierCount = 0;
+}
+
+vk::RenderGraph::PassBuilder vk::RenderGraph::AddPass(const std::string& name)
+{
+	Pass pass = {};
+	pass.name = name;
+	m_Passes.push_back(std::move(pass));
+
+	return PassBuilder(*this, static_cast<uint32_t>(m_Passes.size() - 1));
+}
+
+void vk::RenderGraph::BindImage(const std::string& resource, Image& image)
+{
+	m_Bindings[resource] = &image;
+
+	auto index = m_ResourceIndices.find(resource);
+	if (index != m_ResourceIndices.end())
+	{
+		m_Resources[index->second].image = &image;
+	}
+}
+
+uint32_t vk::RenderGraph::GetResource(const std::string& name)
+{
+	auto index = m_ResourceIndices.find(name);
+	if (index != m_ResourceIndices.end())
+		return index->second;
+
+	Resource resource = {};
+	resource.name = name;
+
+	auto binding = m_Bindings.find(name);
+	resource.image = binding != m_Bindings.end() ? binding->second : nullptr;
+
+	m_Resources.push_back(resource);
+	m_ResourceIndices[name] = static_cast<uint32_t>(m_Resources.size() - 1);
+
+	return static_cast<uint32_t>(m_Resources.size() - 1);
+}
+
+void vk::RenderGraph::Compile()
+{
+	// Cull: walk backwards from the passes with side effects, a pass is only kept if something later reads what it writes
+	std::unordered_set<uint32_t> needed;
+	for (auto pass = m_Passes.rbegin(); pass != m_Passes.rend(); ++pass)
+	{
+		const bool producesNeeded = std::any_of(pass->writes.begin(), pass->writes.end(), [&](const Access& w) { return needed.count(w.resource) != 0; });
+		pass->culled = !(pass->sideEffect || producesNeeded);
+
+		if (pass->culled)
+			continue;
+
+		for (const auto& write : pass->writes)
+			needed.erase(write.resource);
+
+		for (const auto& read : pass->reads)
+			needed.insert(read.resource);
+	}
+
+	// Walk forwards over the remaining passes tracking the layout and last access of every resource
+	std::vector<ResourceState> states(m_Resources.size());
+	for (auto& resource : m_Resources)
+	{
+		resource.firstPass = UINT32_MAX;
+		resource.lastPass = 0;
+	}
+
+	m_BarrierCount = 0;
+	uint32_t index = 0;
+	for (auto& pass : m_Passes)
+	{
+		pass.barriers.clear();
+		if (pass.culled)
+			continue;
+
+		for (const auto& read : pass.reads)
+		{
+			ResourceState& state = states[read.resource];
+			if (!state.written)
+			{
+				ERROR("Render graph: " + pass.name + " reads " + m_Resources[read.resource].name + " before anything writes it");
+			}
+
+			// The producer's end of rendering barrier already made the write visible to some stages in the layout it left the image in,
+			// anything else needs an explicit barrier
+			const bool layoutChange = state.written && state.layout != read.layout;
+			const bool hazard = state.written && (read.stages & ~state.visibleStages) != 0;
+
+			if (layoutChange || hazard)
+			{
+				pass.barriers.push_back(Barrier{
+					read.resource,
+					state.layout,
+					read.layout,
+					state.writeStages | (layoutChange ? state.readStages : 0),
+					state.writeAccess,
+					read.stages,
+					ReadAccess(read.stages)
+				});
+
+				state.layout = read.layout;
+				state.visibleStages |= read.stages;
+			}
+
+			state.readStages |= read.stages;
+		}
+
+		for (const auto& write : pass.writes)
+		{
+			ResourceState& state = states[write.resource];
+			const bool isDepth = IsDepthLayout(write.layout);
+			const VkPipelineStageFlags writeStages = isDepth ? DepthStages : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+			// Write after read within the frame: the new contents must not land before the earlier reads finished
+			if (state.readStages != 0)
+			{
+				pass.barriers.push_back(Barrier{ write.resource, state.layout, state.layout, state.readStages, 0, writeStages, 0 });
+			}
+
+			state.layout = write.layout;
+			state.writeStages = writeStages;
+			state.writeAccess = isDepth ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			state.visibleStages = write.stages;
+			state.readStages = 0;
+			state.written = true;
+		}
+
+		auto extendLifetime = [&](const Access& access)
+		{
+			Resource& resource = m_Resources[access.resource];
+			resource.firstPass = std::min(resource.firstPass, index);
+			resource.lastPass = std::max(resource.lastPass, index);
+		};
+
+		std::for_each(pass.reads.begin(), pass.reads.end(), extendLifetime);
+		std::for_each(pass.writes.begin(), pass.writes.end(), extendLifetime);
+
+		m_BarrierCount += static_cast<uint32_t>(pass.barriers.size());
+		index++;
+	}
+}
+
+void vk::RenderGraph::RecordBarriers(VkCommandBuffer cmd, const Pass& pass) const
+{
+	if (pass.barriers.empty())
+		return;
+
+	// Every barrier keeps its own stages, the batch doesn't make one pass' consumer wait on another's producer
+	BarrierBatch barriers;
+	for (const auto& barrier : pass.barriers)
+	{
+		const Image* image = m_Resources[barrier.resource].image;
+		if (image == nullptr)
+		{
+			throw std::runtime_error("Render graph: no image bound for " + m_Resources[barrier.resource].name);
+		}
+
+		barriers.Image(image->image, barrier.oldLayout, barrier.newLayout,
+			barrier.srcStages, barrier.srcAccess, barrier.dstStages, barrier.dstAccess,
+			VkImageSubresourceRange{
+				IsDepthLayout(barrier.newLayout) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS
+			});
+	}
+
+	barriers.Flush(cmd);
+}
+
+const std::vector<VkCommandBuffer>& vk::RenderGraph::Record(CommandRecorder& recorder, JobSystem& jobs)
+{
+	JobCounter recorded;
+
+	uint32_t slot = 0;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_Passes.size()); i++)
+	{
+		if (!m_Passes[i].culled)
+			slot++;
+	}
+	m_Recorded.assign(slot, VK_NULL_HANDLE);
+
+	slot = 0;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_Passes.size()); i++)
+	{
+		const Pass& pass = m_Passes[i];
+		if (pass.culled)
+			continue;
+
+		jobs.Schedule([&, i, slot]()
+		{
+			const Pass& pass = m_Passes[i];
+			VkCommandBuffer cmd = recorder.Allocate(JobSystem::GetWorkerIndex(), VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+			VkCommandBufferBeginInfo beginInfo = {
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+				.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+			};
+
+			VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo), "Failed to begin command buffer");
+
+			RecordBarriers(cmd, pass);
+
+			pass.execute(cmd);
+
+			VK_CHECK(vkEndCommandBuffer(cmd), "Failed to end command buffer");
+
+			m_Recorded[slot] = cmd;
+		}, &recorded);
+
+		slot++;
+	}
+
+	jobs.Wait(recorded);
+
+	return m_Recorded;
+}
+
+void vk::RenderGraph::ExportLifetimes(TransientAllocator& allocator) const
+{
+	std::vector<std::string> order;
+	for (const auto& pass : m_Passes)
+	{
+		if (!pass.culled)
+			order.push_back(pass.name);
+	}
+
+	allocator.SetPassOrder(order);
+
+	for (const auto& pass : m_Passes)
+	{
+		if (pass.culled)
+			continue;
+
+		for (const auto& read : pass.reads)
+			allocator.AddUsage(m_Resources[read.resource].name, pass.name);
+
+		for (const auto& write : pass.writes)
+			allocator.AddUsage(m_Resources[write.resource].name, pass.name);
+	}
+}
+
+bool vk::RenderGraph::IsCulled(const std::string& pass) const
+{
+	auto it = std::find_if(m_Passes.begin(), m_Passes.end(), [&](const Pass& p) { return p.name == pass; });
+	return it == m_Passes.end() || it->culled;
+}
+
+void vk::RenderGraph::DumpDot(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		ERROR("Failed to write render graph to: " + path);
+		return;
+	}
+
+	file << "digraph RenderGraph {\n";
+	file << "\trankdir=LR;\n";
+	file << "\tnode [fontname=\"Helvetica\", fontsize=10];\n";
+
+	for (const auto& pass : m_Passes)
+	{
+		file << "\t\"pass_" << pass.name << "\" [shape=box, label=\"" << pass.name;
+		if (pass.culled)
+		{
+			file << "\\n(culled)\", style=dashed, fontcolor=gray, color=gray];\n";
+		}
+		else
+		{
+			file << "\\n" << pass.barriers.size() << " barrier(s)\", style=filled, fillcolor=lightblue];\n";
+		}
+	}
+
+	for (const auto& resource : m_Resources)
+	{
+		file << "\t\"res_" << resource.name << "\" [shape=ellipse, label=\"" << resource.name;
+		if (resource.firstPass != UINT32_MAX)
+		{
+			file << "\\nlifetime [" << resource.firstPass << ", " << resource.lastPass << "]";
+		}
+		file << "\"];\n";
+	}
+
+	for (const auto& pass : m_Passes)
+	{
+		const char* style = pass.culled ? ", style=dashed, color=gray" : "";
+
+		for (const auto& write : pass.writes)
+		{
+			file << "\t\"pass_" << pass.name << "\" -> \"res_" << m_Resources[write.resource].name << "\" [label=\"" << LayoutName(write.layout) << "\"" << style << "];\n";
+		}
+
+		for (const auto& read : pass.reads)
+		{
+			file << "\t\"res_" << m_Resources[read.resource].name << "\" -> \"pass_" << pass.name << "\" [label=\"" << LayoutName(read.layout) << "\"" << style << "];\n";
+		}
+	}
+
+	file << "}\n";
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <volk/volk.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include "Image.hpp"
+
+// Passes declare the images they read and write, the graph works out the execution order dependencies,
+// which passes can be culled because nothing consumes their output, the barriers and layout transitions
+// needed between passes and how long each image has to stay alive.
+namespace vk
+{
+	class TransientAllocator;
+	class CommandRecorder;
+	class JobSystem;
+
+	class RenderGraph
+	{
+	public:
+		struct Access
+		{
+			uint32_t resource;
+			VkImageLayout layout;
+			VkPipelineStageFlags stages;
+		};
+
+		struct Barrier
+		{
+			uint32_t resource;
+			VkImageLayout oldLayout;
+			VkImageLayout newLayout;
+			VkPipelineStageFlags srcStages;
+			VkAccessFlags srcAccess;
+			VkPipelineStageFlags dstStages;
+			VkAccessFlags dstAccess;
+		};
+
+		struct Pass
+		{
+			std::string name;
+			std::vector<Access> reads;
+			std::vector<Access> writes; // stages are the ones the pass' end of rendering barrier makes the write visible to
+			std::function<void(VkCommandBuffer)> execute;
+			bool sideEffect = false;
+			bool culled = false;
+			std::vector<Barrier> barriers;
+		};
+
+		struct Resource
+		{
+			std::string name;
+			Image* image = nullptr;
+			uint32_t firstPass = UINT32_MAX;
+			uint32_t lastPass = 0;
+		};
+
+		class PassBuilder
+		{
+		public:
+			PassBuilder(RenderGraph& graph, uint32_t pass) : graph{graph}, pass{pass} {}
+
+			// Image sampled (or used as a read-only attachment) by the pass in the given layout
+			PassBuilder& Read(const std::string& resource, VkImageLayout layout, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+			// Attachment written by the pass, left in finalLayout and made visible to releasedTo stages by the barrier after its rendering
+			PassBuilder& Write(const std::string& resource, VkImageLayout finalLayout, VkPipelineStageFlags releasedTo = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+			// Pass has effects outside the graph (e.g. presenting) and is never culled
+			PassBuilder& SideEffect();
+			PassBuilder& Execute(std::function<void(VkCommandBuffer)> execute);
+
+		private:
+			RenderGraph& graph;
+			uint32_t pass;
+		};
+
+		void Reset();
+		PassBuilder AddPass(const std::string& name);
+
+		// Images are owned by the passes, the graph only refers to them. Bindings survive Reset().
+		void BindImage(const std::string& resource, Image& image);
+
+		void Compile();
+
+		// Records every pass that wasn't culled into its own primary command buffer as jobs on the job system.
+		// The buffers are returned in submission order.
+		const std::vector<VkCommandBuffer>& Record(CommandRecorder& recorder, JobSystem& jobs);
+
+		void ExportLifetimes(TransientAllocator& allocator) const;
+		void DumpDot(const std::string& path) const;
+
+		bool IsCulled(const std::string& pass) const;
+		uint32_t GetBarrierCount() const { return m_BarrierCount; }
+		const std::vector<Pass>& GetPasses() const { return m_Passes; }
+		const std::vector<Resource>& GetResources() const { return m_Resources; }
+
+	private:
+		uint32_t GetResource(const std::string& name);
+		void RecordBarriers(VkCommandBuffer cmd, const Pass& pass) const;
+
+		std::vector<Pass> m_Passes;
+		std::vector<Resource> m_Resources;
+		std::unordered_map<std::string, uint32_t> m_ResourceIndices;
+		std::unordered_map<std::string, Image*> m_Bindings;
+		std::vector<VkCommandBuffer> m_Recorded;
+		uint32_t m_BarrierCount = 0;
+	};
+}
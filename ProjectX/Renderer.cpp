@@ -3,12 +3,21 @@
 #include "Utils.hpp"
 #include "baked_model.hpp"
 #include "Light.hpp"
+#include "Barriers.hpp"
+#include "CullingView.hpp"
+#include <imgui.h>
 
 namespace
 {
 	constexpr glm::vec3 cameraPos = glm::vec3(1.0f, 2.0f, -24.0f);
 	constexpr glm::vec3 cameraDir = glm::vec3(1.0f, 1.0f, -1.0f);
 	constexpr glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0);
+
+	// Row 0 goes to the left of the hall, row 1 to the right
+	glm::mat4 PropRowTransform(uint32_t row, float spacing)
+	{
+		return glm::translate(glm::mat4(1.0f), glm::vec3(row == 0 ? -spacing : spacing, 0.0f, 0.0f));
+	}
 }
 
 vk::Renderer::Renderer(Context& context) : context{context}
@@ -68,8 +77,34 @@ vk::Renderer::Renderer(Context& context) : context{context}
 
 	// Define and Add to scene
 	m_scene = std::make_shared<Scene>(context);
-	m_scene->AddModel(std::make_unique<BakedModel>(load_baked_model("assets/suntemple.mesh"))); //comp5892mesh_new_packed
+	auto temple = std::make_shared<BakedModel>(load_baked_model("assets/suntemple.mesh")); //comp5892mesh_new_packed
+
+	// Demo of instancing: the fire pits and pillars are placed as instances, the temple's own set plus a copy of it down
+	// each side of the hall, so each of their meshes stays a single instanced draw however many copies there are.
+	// They keep drawing with the temple's textures. Each side's copy hangs off a row entity, moving the row moves its props.
+	if (instancedPropsDemo)
+	{
+		auto props = std::make_shared<BakedModel>(extract_baked_meshes(*temple, { "M_FirePit_Inst", "M_Pillar_Inst" }));
+
+		m_scene->AddModel(temple);
+		if (!props->meshes.empty())
+		{
+			m_scene->AddModel(props, temple);
+			m_PropRowSpacing = propSpacing;
+			for (uint32_t row = 0; row < 2; row++)
+			{
+				m_PropRows[row] = m_scene->GetEntities().CreateEntity(PropRowTransform(row, m_PropRowSpacing));
+				m_scene->AddInstances(props, { glm::mat4(1.0f) }, m_PropRows[row]);
+			}
+		}
+	}
+	else
+	{
+		m_scene->AddModel(temple);
+	}
+
 	m_scene->AddLightSource(directionalLight);
+	m_camera->SetCollisionScene(m_scene.get());
 
 	for (const auto& position : spotLightPositions)
 	{
@@ -82,21 +117,50 @@ vk::Renderer::Renderer(Context& context) : context{context}
 
 	std::cout << "Num lights: " << m_scene->GetLights().size() << std::endl;
 
+	// Declare the frame up front, the lifetimes of the deferred targets decide which of them can share memory
+	BuildRenderGraph();
+	m_RenderGraph.ExportLifetimes(*context.transientAllocator);
+
 	// Rendering passes
-	m_ShadowMap	   = std::make_unique<ShadowMap>(context, m_scene);
+	m_ShadowMap	   = std::make_unique<ShadowMap>(context, m_scene, m_camera);
 	m_DepthPrepass = std::make_unique<DepthPrepass>(context, m_scene, m_camera);
-	m_MeshDensity  = std::make_unique<MeshDensity>(context, m_DepthPrepass->GetRenderTarget(), m_scene, m_camera);
-	m_ForwardPass  = std::make_unique<ForwardPass>(context, m_ShadowMap->GetRenderTarget(), m_DepthPrepass->GetRenderTarget(), m_scene, m_camera);
-	m_GBuffer	   = std::make_unique<GBuffer>(context, m_scene, m_camera);
-	m_DefLighting  = std::make_unique<DefLighting>(context, m_camera, m_GBuffer->GetGBufferMRT(), m_ShadowMap->GetRenderTarget(), m_scene);
+	m_MeshDensity  = std::make_unique<MeshDensity>(context, m_DepthPrepass->GetRenderTarget(), m_scene, m_camera, m_DepthPrepass->GetCullingView());
+	m_ForwardPass  = std::make_unique<ForwardPass>(context, m_ShadowMap->GetRenderTarget(), m_DepthPrepass->GetRenderTarget(), m_scene, m_camera, m_DepthPrepass->GetCullingView());
+	m_GBuffer	   = std::make_unique<GBuffer>(context, m_scene, m_camera, m_DepthPrepass->GetCullingView(), m_DepthPrepass->GetRenderTarget());
+	m_DefLighting  = std::make_unique<DefLighting>(context, m_camera, m_GBuffer->GetGBufferMRT(), m_GBuffer->GetDepthTarget(), m_ShadowMap->GetRenderTarget(), m_ShadowMap->GetCascadeBuffers(), m_scene);
 	m_Bloom		   = std::make_unique<Bloom>(context, m_DefLighting->GetBrightnessRenderTarget());
-	m_SSR		   = std::make_unique<SSR>(context, m_DefLighting->GetRenderTarget(), m_GBuffer->GetGBufferMRT().DepthTarget, m_GBuffer->GetGBufferMRT().MetRoughnessTarget, m_GBuffer->GetGBufferMRT().NormalTarget, m_camera);
-	m_SSAO		   = std::make_unique<SSAO>(context, m_GBuffer->GetGBufferMRT().DepthTarget, m_GBuffer->GetGBufferMRT().NormalTarget, m_camera);
+	m_SSR		   = std::make_unique<SSR>(context, m_DefLighting->GetRenderTarget(), m_GBuffer->GetDepthTarget(), m_GBuffer->GetGBufferMRT().MetRoughnessTarget, m_GBuffer->GetGBufferMRT().NormalTarget, m_camera);
+	m_SSAO		   = std::make_unique<SSAO>(context, m_GBuffer->GetDepthTarget(), m_GBuffer->GetGBufferMRT().NormalTarget, m_camera);
 	m_DefComposite = std::make_unique<DefCompositePass>(context, m_DefLighting->GetRenderTarget(), m_Bloom->GetRenderTarget(), m_SSR->GetRenderTarget(), m_SSAO->GetRenderTarget());
 	m_PresentPass  = std::make_unique<PresentPass>(context, m_ForwardPass->GetRenderTarget(), m_DefComposite->GetRenderTarget(), m_MeshDensity->GetRenderTarget());
 
+	m_CullingViews = { &m_DepthPrepass->GetCullingView() };
+	for (uint32_t cascade = 0; cascade < MaxShadowCascades; cascade++)
+	{
+		m_CullingViews.push_back(&m_ShadowMap->GetCullingView(cascade));
+	}
+
+	BindRenderGraphImages();
+
+	std::cout << "Transient render targets: " << context.transientAllocator->GetRequestedBytes() / (1024 * 1024) << " MB requested, "
+		<< context.transientAllocator->GetAllocatedBytes() / (1024 * 1024) << " MB allocated" << std::endl;
+
 	ImGuiRenderer::Initialize(context);
 	//ImGuiRenderer::AddTexture(clampToEdgeSamplerAniso, m_ShadowMap->GetRenderTarget().imageView, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL);
+
+	// The passes' pipelines have been compiling on the job system since each pass was created,
+	// nothing records before the first frame so this is the first point they're needed
+	context.pipelineCache->WaitForCompiles();
+
+	for (CullingView* view : m_CullingViews)
+	{
+		view->ResolvePipelines();
+	}
+
+	const PipelineCache::Stats pipelineStats = context.pipelineCache->GetStats();
+	std::cout << "Pipelines: " << pipelineStats.pipelines << " compiled, " << pipelineStats.creationNs / 1000000 << " ms of compile time across the workers, "
+		<< pipelineStats.hits << " cache hits (" << pipelineStats.loadedBytes / 1024 << " KB loaded)" << std::endl;
+	std::cout << "Shaders: " << context.shaderLibrary->GetFileCount() << " files, " << context.shaderLibrary->GetModuleCount() << " modules" << std::endl;
 }
 
 void vk::Renderer::Destroy()
@@ -121,11 +185,6 @@ void vk::Renderer::Destroy()
 	vkDestroySampler(context.device, repeatSampler, nullptr);
 	vkDestroySampler(context.device, clampToEdgeSamplerAniso, nullptr);
 
-	for (auto& fence : m_Fences)
-	{
-		vkDestroyFence(context.device, fence, nullptr);
-	}
-
 	for (auto& semaphore : m_imageAvailableSemaphores)
 	{
 		vkDestroySemaphore(context.device, semaphore, nullptr);
@@ -136,39 +195,16 @@ void vk::Renderer::Destroy()
 		vkDestroySemaphore(context.device, semaphore, nullptr);
 	}
 
-	for (size_t i = 0; i < (size_t)vk::MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		vkFreeCommandBuffers(context.device, m_commandPool[i], 1, &m_commandBuffers[i]);
-	}
-
-	for (size_t i = 0; i < (size_t)vk::MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		vkDestroyCommandPool(context.device, m_commandPool[i], nullptr);
-	}
+	m_Recorder->Destroy();
 }
 
 void vk::Renderer::CreateResources()
 {
-	CreateFences();
+	// Nothing has been submitted yet, waiting for value 0 returns straight away
+	m_FrameTimelineValues.assign(vk::MAX_FRAMES_IN_FLIGHT, 0);
 	CreateSemaphores();
-	CreateCommandPool();
-	AllocateCommandBuffers();
-}
-
-void vk::Renderer::CreateFences()
-{
-	for (size_t i = 0; i < (size_t)vk::MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		// Fence
-		VkFenceCreateInfo fenceInfo{
-			.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-			.flags = VK_FENCE_CREATE_SIGNALED_BIT
-		};
-
-		VkFence fence = VK_NULL_HANDLE;
-		VK_CHECK(vkCreateFence(context.device, &fenceInfo, nullptr, &fence), "Failed to create Fence.");
-		m_Fences.push_back(std::move(fence));
-	}
+	CreatePresentSemaphores();
+	CreateCommandRecorder();
 }
 
 void vk::Renderer::CreateSemaphores()
@@ -183,9 +219,19 @@ void vk::Renderer::CreateSemaphores()
 		VK_CHECK(vkCreateSemaphore(context.device, &semaphoreInfo, nullptr, &semaphore), "Failed to create image available semaphore");
 		m_imageAvailableSemaphores.push_back(std::move(semaphore));
 	}
+}
 
-	// Render finished sempahore
-	for (size_t i = 0; i < (size_t)vk::MAX_FRAMES_IN_FLIGHT; i++) {
+void vk::Renderer::CreatePresentSemaphores()
+{
+	for (auto& semaphore : m_renderFinishedSemaphores)
+	{
+		vkDestroySemaphore(context.device, semaphore, nullptr);
+	}
+	m_renderFinishedSemaphores.clear();
+
+	// Render finished semaphore per swapchain image. A present may still be waiting on the semaphore when the frame's fence
+	// signals, but never by the time the same image has been acquired again.
+	for (size_t i = 0; i < context.swapchainImages.size(); i++) {
 		VkSemaphoreCreateInfo semaphoreInfo = {
 			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO
 		};
@@ -196,41 +242,17 @@ void vk::Renderer::CreateSemaphores()
 	}
 }
 
-void vk::Renderer::CreateCommandPool()
-{
-	for (size_t i = 0; i < (size_t)vk::MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		VkCommandPoolCreateInfo cmdPool{};
-		cmdPool.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		cmdPool.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-		cmdPool.queueFamilyIndex = context.graphicsFamilyIndex;
-
-		VkCommandPool commandPool = VK_NULL_HANDLE;
-		VK_CHECK(vkCreateCommandPool(context.device, &cmdPool, nullptr, &commandPool), "Failed to create command pool");
-		m_commandPool.push_back(std::move(commandPool));
-	}
-}
-
-void vk::Renderer::AllocateCommandBuffers()
+void vk::Renderer::CreateCommandRecorder()
 {
-	for (size_t i = 0; i < (size_t)vk::MAX_FRAMES_IN_FLIGHT; i++)
-	{
-		// Allocate command buffers from command pool
-		VkCommandBufferAllocateInfo cmdAlloc{};
-		cmdAlloc.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		cmdAlloc.commandPool = m_commandPool[i];
-		cmdAlloc.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		cmdAlloc.commandBufferCount = 1;
+	m_Recorder = std::make_unique<CommandRecorder>(context);
 
-		VkCommandBuffer cmd = VK_NULL_HANDLE;
-		VK_CHECK(vkAllocateCommandBuffers(context.device, &cmdAlloc, &cmd), "Failed to allocate command buffer");
-		m_commandBuffers.push_back(cmd);
-	}
+	std::cout << "Recording command buffers on " << m_Recorder->GetWorkerCount() << " worker(s)" << std::endl;
 }
 
 void vk::Renderer::Render()
 {
-	vkWaitForFences(context.device, 1, &m_Fences[vk::currentFrame], VK_TRUE, UINT64_MAX);
+	// Wait for the GPU to finish the last frame that used this frame's resources
+	context.graphicsTimeline->WaitFor(m_FrameTimelineValues[vk::currentFrame]);
 
 	uint32_t index;
 	VkResult getImageIndex = vkAcquireNextImageKHR(context.device, context.swapchain, UINT64_MAX, m_imageAvailableSemaphores[vk::currentFrame], VK_NULL_HANDLE, &index);
@@ -239,90 +261,175 @@ void vk::Renderer::Render()
 
 	if (getImageIndex == VK_ERROR_OUT_OF_DATE_KHR)
 	{
-		// Recreate swapchain
-		context.RecreateSwapchain();
-		m_DepthPrepass->Resize();
-		m_MeshDensity->Resize();
-		m_ForwardPass->Resize();
-		m_ShadowMap->Resize();
-		m_GBuffer->Resize();
-		m_DefLighting->Resize();
-		m_Bloom->Resize();
-		m_SSR->Resize();
-		m_SSAO->Resize();
-		m_DefComposite->Resize();
-		m_PresentPass->Resize();
+		// No image was acquired, the index can't be used to pick the present semaphore or framebuffer
+		Resize();
+		return;
 	}
 	else if (getImageIndex != VK_SUCCESS && getImageIndex != VK_SUBOPTIMAL_KHR)
 	{
 		throw std::runtime_error("Failed to aquire swapchain image");
 	}
 
-	vkResetFences(context.device, 1, &m_Fences[vk::currentFrame]);
-	vkResetCommandBuffer(m_commandBuffers[vk::currentFrame], 0);
-
-	VkCommandBuffer& cmd = m_commandBuffers[vk::currentFrame];
+	m_Recorder->BeginFrame();
+	BarrierBatch::BeginFrame();
 
+	if (m_GraphRenderType != renderType)
 	{
-		VkCommandBufferBeginInfo beginInfo = {
-			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO
-		};
-
-		VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo), "Failed to begin command buffer");
-
-		m_ShadowMap->Execute(cmd);
-		m_DepthPrepass->Execute(cmd);
-		if (renderType == RenderType::FORWARD)
-		{
-			m_ForwardPass->Execute(cmd);
-
-		}
-		else if (renderType == RenderType::MESH_DENSITY)
-		{
-			m_MeshDensity->Execute(cmd);
-		}
-		else
-		{
-			m_GBuffer->Execute(cmd);
-			m_DefLighting->Execute(cmd);
-			m_Bloom->Execute(cmd);
-			m_SSR->Execute(cmd);
-			m_SSAO->Execute(cmd);
-;			m_DefComposite->Execute(cmd);
-		}
-
-		m_PresentPass->Execute(cmd, index);
-		vkEndCommandBuffer(cmd);
+		BuildRenderGraph();
 	}
 
-	Submit();
+	// Every pass is recorded into its own command buffer on the job system
+	m_ImageIndex = index;
+	const std::vector<VkCommandBuffer>& commandBuffers = m_RenderGraph.Record(*m_Recorder, *context.jobSystem);
+
+	Submit(commandBuffers, index);
 	Present(index);
 
 	vk::currentFrame = (vk::currentFrame + 1) % vk::MAX_FRAMES_IN_FLIGHT;
 }
 
-void vk::Renderer::Submit()
+void vk::Renderer::BuildRenderGraph()
 {
-	VkPipelineStageFlags waitStage = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+	m_RenderGraph.Reset();
+	m_GraphRenderType = renderType;
 
-	VkSubmitInfo subtmitInfo = {
-		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-		.waitSemaphoreCount = 1,
-		.pWaitSemaphores = &m_imageAvailableSemaphores[vk::currentFrame],
-		.pWaitDstStageMask = &waitStage,
-		.commandBufferCount = 1,
-		.pCommandBuffers = &m_commandBuffers[vk::currentFrame],
-		.signalSemaphoreCount = 1,
-		.pSignalSemaphores = &m_renderFinishedSemaphores[vk::currentFrame]
-	};
+	constexpr VkPipelineStageFlags depthTests = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+	// Moved entities' transforms and bounds, everything after reads them
+	m_RenderGraph.AddPass("SceneUpload")
+		.SideEffect()
+		.Execute([this](VkCommandBuffer cmd) { m_scene->RecordUploads(cmd); });
+
+	m_RenderGraph.AddPass("ShadowMap")
+		.Write("ShadowMap_Depth_RT", VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL)
+		.Execute([this](VkCommandBuffer cmd) { m_ShadowMap->Execute(cmd); });
 
-	VkResult result = vkQueueSubmit(context.graphicsQueue, 1, &subtmitInfo, m_Fences[vk::currentFrame]);
+	m_RenderGraph.AddPass("DepthPrepass")
+		.Write("DepthPrepass_RT", VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, depthTests)
+		.Execute([this](VkCommandBuffer cmd) { m_DepthPrepass->Execute(cmd); });
 
-	if (result != VK_SUCCESS)
+	std::string presentInput;
+
+	if (renderType == RenderType::FORWARD)
+	{
+		// Reading the depth-prepass keeps it ahead of the passes drawing its culled lists
+		m_RenderGraph.AddPass("ForwardPass")
+			.Read("ShadowMap_Depth_RT", VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL)
+			.Read("DepthPrepass_RT", VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, depthTests)
+			.Write("ForwardPassRT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Execute([this](VkCommandBuffer cmd) { m_ForwardPass->Execute(cmd); });
+
+		presentInput = "ForwardPassRT";
+	}
+	else if (renderType == RenderType::MESH_DENSITY)
 	{
-		throw std::runtime_error("Failed to submit command buffers");
+		m_RenderGraph.AddPass("MeshDensity")
+			.Read("DepthPrepass_RT", VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, depthTests)
+			.Write("MeshDensity_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Execute([this](VkCommandBuffer cmd) { m_MeshDensity->Execute(cmd); });
+
+		presentInput = "MeshDensity_RT";
 	}
+	else
+	{
+		// With the prepass depth reused the GBuffer only tests against it, and it's the depth the lighting passes sample
+		const std::string sceneDepth = gbufferReusesPrepassDepth ? "DepthPrepass_RT" : "GBuffer_Depth_RT";
+
+		RenderGraph::PassBuilder gbufferPass = m_RenderGraph.AddPass("GBuffer")
+			.Read("DepthPrepass_RT", VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, depthTests)
+			.Write("GBuffer_Albedo_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Write("GBuffer_Normal_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Write("GBuffer_Emissive_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Write("GBuffer_MetRoughness_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		if (!gbufferReusesPrepassDepth)
+			gbufferPass.Write("GBuffer_Depth_RT", VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, depthTests);
+		gbufferPass.Execute([this](VkCommandBuffer cmd) { m_GBuffer->Execute(cmd); });
+
+		m_RenderGraph.AddPass("DefLighting")
+			.Read(sceneDepth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+			.Read("GBuffer_Albedo_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Read("GBuffer_Normal_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Read("GBuffer_MetRoughness_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Read("GBuffer_Emissive_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Read("ShadowMap_Depth_RT", VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL)
+			.Write("DefLightingRT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Write("DefLighting_BrightnessRT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Execute([this](VkCommandBuffer cmd) { m_DefLighting->Execute(cmd); });
+
+		m_RenderGraph.AddPass("Bloom")
+			.Read("DefLighting_BrightnessRT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Write("Bloom_Blur_X_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Write("Bloom_Blur_Y_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Execute([this](VkCommandBuffer cmd) { m_Bloom->Execute(cmd); });
+
+		m_RenderGraph.AddPass("SSR")
+			.Read("DefLightingRT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Read(sceneDepth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+			.Read("GBuffer_MetRoughness_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Read("GBuffer_Normal_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Write("SSR_RenderTarget", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Execute([this](VkCommandBuffer cmd) { m_SSR->Execute(cmd); });
+
+		m_RenderGraph.AddPass("SSAO")
+			.Read(sceneDepth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL)
+			.Read("GBuffer_Normal_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Write("SSAO_RenderTarget", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Execute([this](VkCommandBuffer cmd) { m_SSAO->Execute(cmd); });
+
+		m_RenderGraph.AddPass("DefComposite")
+			.Read("DefLightingRT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Read("Bloom_Blur_Y_RT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Read("SSR_RenderTarget", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Read("SSAO_RenderTarget", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Write("DefCompositePassRT", VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+			.Execute([this](VkCommandBuffer cmd) { m_DefComposite->Execute(cmd); });
+
+		presentInput = "DefCompositePassRT";
+	}
+
+	m_RenderGraph.AddPass("PresentPass")
+		.Read(presentInput, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+		.SideEffect()
+		.Execute([this](VkCommandBuffer cmd) { m_PresentPass->Execute(cmd, m_ImageIndex); });
 
+	m_RenderGraph.Compile();
+
+#ifdef _DEBUG
+	m_RenderGraph.DumpDot("render_graph.dot");
+#endif
+}
+
+void vk::Renderer::BindRenderGraphImages()
+{
+	GBuffer::GBufferMRT& gbuffer = m_GBuffer->GetGBufferMRT();
+
+	m_RenderGraph.BindImage("ShadowMap_Depth_RT", m_ShadowMap->GetRenderTarget());
+	m_RenderGraph.BindImage("DepthPrepass_RT", m_DepthPrepass->GetRenderTarget());
+	m_RenderGraph.BindImage("ForwardPassRT", m_ForwardPass->GetRenderTarget());
+	m_RenderGraph.BindImage("MeshDensity_RT", m_MeshDensity->GetRenderTarget());
+	m_RenderGraph.BindImage("GBuffer_Albedo_RT", gbuffer.AlbedoTarget);
+	m_RenderGraph.BindImage("GBuffer_Normal_RT", gbuffer.NormalTarget);
+	m_RenderGraph.BindImage("GBuffer_Emissive_RT", gbuffer.EmissiveTarget);
+	m_RenderGraph.BindImage("GBuffer_MetRoughness_RT", gbuffer.MetRoughnessTarget);
+	if (!gbufferReusesPrepassDepth)
+		m_RenderGraph.BindImage("GBuffer_Depth_RT", gbuffer.DepthTarget);
+	m_RenderGraph.BindImage("DefLightingRT", m_DefLighting->GetRenderTarget());
+	m_RenderGraph.BindImage("DefLighting_BrightnessRT", m_DefLighting->GetBrightnessRenderTarget());
+	m_RenderGraph.BindImage("Bloom_Blur_X_RT", m_Bloom->GetBlurXRenderTarget());
+	m_RenderGraph.BindImage("Bloom_Blur_Y_RT", m_Bloom->GetRenderTarget());
+	m_RenderGraph.BindImage("SSR_RenderTarget", m_SSR->GetRenderTarget());
+	m_RenderGraph.BindImage("SSAO_RenderTarget", m_SSAO->GetRenderTarget());
+	m_RenderGraph.BindImage("DefCompositePassRT", m_DefComposite->GetRenderTarget());
+}
+
+void vk::Renderer::Submit(const std::vector<VkCommandBuffer>& commandBuffers, uint32_t imageIndex)
+{
+	m_FrameTimelineValues[vk::currentFrame] = context.graphicsTimeline->Submit(
+		context.graphicsQueue,
+		commandBuffers,
+		{},
+		{ m_imageAvailableSemaphores[vk::currentFrame] }, { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
+		{ m_renderFinishedSemaphores[imageIndex] });
 }
 
 void vk::Renderer::Present(uint32_t imageIndex)
@@ -330,7 +437,7 @@ void vk::Renderer::Present(uint32_t imageIndex)
 	VkPresentInfoKHR presentInfo = {
 		.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
 		.waitSemaphoreCount = 1,
-		.pWaitSemaphores = &m_renderFinishedSemaphores[vk::currentFrame],
+		.pWaitSemaphores = &m_renderFinishedSemaphores[imageIndex],
 		.swapchainCount = 1,
 		.pSwapchains = &context.swapchain,
 		.pImageIndices = &imageIndex,
@@ -341,35 +448,94 @@ void vk::Renderer::Present(uint32_t imageIndex)
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
 	{
-		// Recreate the swapchain
-		context.RecreateSwapchain();
-		m_DepthPrepass->Resize();
-		m_MeshDensity->Resize();
-		m_ForwardPass->Resize();
-		m_ShadowMap->Resize();
-		m_GBuffer->Resize();
-		m_DefLighting->Resize();
-		m_Bloom->Resize();
-		m_SSR->Resize();
-		m_SSAO->Resize();
-		m_DefComposite->Resize();
-		m_PresentPass->Resize();
+		Resize();
+	}
+}
+
+void vk::Renderer::Resize()
+{
+	const size_t imageCount = context.swapchainImages.size();
+
+	// Recreate the swapchain
+	context.RecreateSwapchain();
+	m_DepthPrepass->Resize();
+	m_MeshDensity->Resize();
+	m_ForwardPass->Resize();
+	m_ShadowMap->Resize();
+	m_GBuffer->Resize();
+	m_DefLighting->Resize();
+	m_Bloom->Resize();
+	m_SSR->Resize();
+	m_SSAO->Resize();
+	m_DefComposite->Resize();
+	m_PresentPass->Resize();
+
+	// The new swapchain isn't guaranteed to have the same number of images
+	if (context.swapchainImages.size() != imageCount)
+	{
+		CreatePresentSemaphores();
 	}
 }
 
 void vk::Renderer::Update(double deltaTime)
 {
 	m_camera->Update(context.window, context.extent.width, context.extent.height, deltaTime);
+
+	// Only a changed spacing dirties the rows, the scene then uploads just the props' transforms and bounds
+	if (m_PropRows[0] != NullEntity && propSpacing != m_PropRowSpacing)
+	{
+		m_PropRowSpacing = propSpacing;
+		for (uint32_t row = 0; row < 2; row++)
+		{
+			m_scene->GetEntities().SetLocalTransform(m_PropRows[row], PropRowTransform(row, m_PropRowSpacing));
+		}
+	}
+
 	m_scene->Update(context.window);
 
+	// The ray through the clicked pixel, from the cursor's points on the near and far planes
+	if (m_camera->pickRequested)
+	{
+		m_camera->pickRequested = false;
+
+		const CameraTransform& transform = m_camera->GetCameraTransform();
+		const glm::mat4 inverseViewProjection = glm::inverse(transform.projection * transform.view);
+		const glm::vec2 ndc = glm::vec2(m_camera->mouseX / context.extent.width, m_camera->mouseY / context.extent.height) * 2.0f - 1.0f;
+
+		const glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, 0.0f, 1.0f);
+		const glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+		const glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - glm::vec3(nearPoint) / nearPoint.w);
+
+		m_scene->Pick(m_camera->GetPosition(), direction);
+	}
+
 	// Update passes
-	ImGuiRenderer::Update(m_scene, m_camera);
+	ImGuiRenderer::Update(m_scene, m_camera, m_CullingViews);
 	m_ShadowMap->Update();
 	m_ForwardPass->Update();
 	m_DefLighting->Update();
 	m_SSR->Update();
 	m_SSAO->Update();
 	m_PresentPass->Update();
+
+	// Without GPU culling every view is frustum culled here instead, each on its own job
+	if (!gpuCulling)
+	{
+		const CameraTransform& transform = m_camera->GetCameraTransform();
+		std::vector<std::pair<CullingView*, glm::mat4>> views = { { &m_DepthPrepass->GetCullingView(), transform.projection * transform.view } };
+
+		// Cached cascades draw nothing, their casters aren't needed
+		for (uint32_t cascade = 0; cascade < m_ShadowMap->GetCascadeCount(); cascade++)
+		{
+			if (m_ShadowMap->IsDirty(cascade))
+				views.push_back({ &m_ShadowMap->GetCullingView(cascade), m_ShadowMap->GetCascadeMatrix(cascade) });
+		}
+
+		context.jobSystem->ParallelFor(static_cast<uint32_t>(views.size()), [&](uint32_t i, uint32_t)
+		{
+			views[i].first->CullOnCpu(views[i].second);
+		});
+	}
 }
 
 void vk::Renderer::glfwHandleKeyboard(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -485,6 +651,12 @@ void vk::Renderer::glfwMouseButtonCallback(GLFWwindow* window, int button, int a
 	auto camera = static_cast<Camera*>(glfwGetWindowUserPointer(window));
 	assert(camera);
 
+	// Picking only with a free cursor, and not through the UI
+	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && !camera->inputMap[std::size_t(EInputState::MOUSING)] && !ImGui::GetIO().WantCaptureMouse)
+	{
+		camera->pickRequested = true;
+	}
+
 	if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
 	{
 		auto& flag = camera->inputMap[std::size_t(EInputState::MOUSING)];
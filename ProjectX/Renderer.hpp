@@ -19,12 +19,15 @@
 #include "SSAO.hpp"
 #include "Skybox.hpp"
 #include "ImGuiRenderer.hpp"
+#include "RenderGraph.hpp"
+#include "CommandRecorder.hpp"
 
 
 //Deferred
 namespace vk
 {
 	class Context;
+	class CullingView;
 	class Renderer
 	{
 	public:
@@ -43,21 +46,23 @@ namespace vk
 
 	private:
 		void CreateResources();
-		void CreateFences();
 		void CreateSemaphores();
-		void CreateCommandPool();
-		void AllocateCommandBuffers();
+		void CreatePresentSemaphores();
+		void Resize();
+		void CreateCommandRecorder();
 
-		void Submit();
+		void BuildRenderGraph();
+		void BindRenderGraphImages();
+
+		void Submit(const std::vector<VkCommandBuffer>& commandBuffers, uint32_t imageIndex);
 		void Present(uint32_t imageIndex);
 
 	private:
 		Context& context;
-		std::vector<VkFence> m_Fences;
+		std::vector<uint64_t> m_FrameTimelineValues; // graphics timeline value each frame in flight last signalled
 		std::vector<VkSemaphore> m_imageAvailableSemaphores;
-		std::vector<VkSemaphore> m_renderFinishedSemaphores;
-		std::vector<VkCommandBuffer> m_commandBuffers;
-		std::vector<VkCommandPool> m_commandPool;
+		std::vector<VkSemaphore> m_renderFinishedSemaphores; // one per swapchain image, the present wait isn't covered by the frame fence
+		std::unique_ptr<CommandRecorder> m_Recorder;
 
 		std::shared_ptr<Scene> m_scene;
 
@@ -75,5 +80,14 @@ namespace vk
 		std::unique_ptr<PresentPass>	  m_PresentPass;
 
 		std::shared_ptr<Camera> m_camera;
+		std::vector<CullingView*> m_CullingViews; // camera then every shadow cascade
+
+		// Parents of the copies of the temple's props on either side of the hall with instancedPropsDemo, moved when propSpacing changes
+		Entity m_PropRows[2] = { NullEntity, NullEntity };
+		float m_PropRowSpacing = 0.0f;
+
+		RenderGraph m_RenderGraph;
+		RenderType m_GraphRenderType;
+		uint32_t m_ImageIndex = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+#include <volk/volk.h>
+#include <vector>
+#include "Barriers.hpp"
+
+// Dynamic rendering replaces the VkRenderPass + VkFramebuffer pair of every pass. Attachments are plain image views
+// given when rendering begins, so nothing has to be rebuilt when a target is resized, and the layout transitions the
+// render pass used to do through its initial/final layouts and external dependencies are recorded as barriers instead.
+namespace vk {
+    class RenderingInfo {
+    public:
+        explicit RenderingInfo(VkExtent2D extent) : m_Extent(extent) {}
+
+        RenderingInfo& AddColorAttachment(VkImageView view, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp,
+            VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } }) {
+
+            VkRenderingAttachmentInfo attachment{ VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
+            attachment.imageView = view;
+            attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            attachment.loadOp = loadOp;
+            attachment.storeOp = storeOp;
+            attachment.clearValue.color = clearColor;
+
+            m_ColorAttachments.push_back(attachment);
+            return *this;
+        }
+
+        // layout is DEPTH_STENCIL_READ_ONLY_OPTIMAL for passes that only test against depth written earlier
+        RenderingInfo& SetDepthAttachment(VkImageView view, VkImageLayout layout, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp,
+            float clearDepth = 1.0f) {
+
+            m_DepthAttachment = { VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO };
+            m_DepthAttachment.imageView = view;
+            m_DepthAttachment.imageLayout = layout;
+            m_DepthAttachment.loadOp = loadOp;
+            m_DepthAttachment.storeOp = storeOp;
+            m_DepthAttachment.clearValue.depthStencil = { clearDepth, 0 };
+            m_HasDepth = true;
+
+            return *this;
+        }
+
+        void Begin(VkCommandBuffer cmd) const {
+            VkRenderingInfo info{ VK_STRUCTURE_TYPE_RENDERING_INFO };
+            info.renderArea = { { 0, 0 }, m_Extent };
+            info.layerCount = 1;
+            info.colorAttachmentCount = static_cast<uint32_t>(m_ColorAttachments.size());
+            info.pColorAttachments = m_ColorAttachments.data();
+            info.pDepthAttachment = m_HasDepth ? &m_DepthAttachment : nullptr;
+
+            vkCmdBeginRendering(cmd, &info);
+        }
+
+    private:
+        VkExtent2D m_Extent;
+        std::vector<VkRenderingAttachmentInfo> m_ColorAttachments;
+        VkRenderingAttachmentInfo m_DepthAttachment{};
+        bool m_HasDepth = false;
+    };
+
+    // Old contents are discarded, waits for whatever last sampled or rendered to the memory, including an aliased transient.
+    // Passes with several targets add them all to one batch so they're transitioned by a single barrier.
+    inline void BeginColorTarget(BarrierBatch& barriers, VkImage image) {
+        barriers.Image(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
+    }
+
+    // layer picks one layer of an array target, the others keep their layout and contents
+    inline void BeginDepthTarget(BarrierBatch& barriers, VkImage image, uint32_t layer = 0) {
+        barriers.Image(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, layer, 1 });
+    }
+
+    // Moves a rendered target into the layout its readers expect and makes the writes visible to dstStages.
+    // This is the release the render graph relies on, dstStages must match the releasedTo of the pass' Write.
+    inline void EndColorTarget(BarrierBatch& barriers, VkImage image, VkImageLayout finalLayout,
+        VkPipelineStageFlags2 dstStages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VkAccessFlags2 dstAccess = VK_ACCESS_2_SHADER_READ_BIT) {
+
+        barriers.Image(image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, finalLayout,
+            VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            dstStages, dstAccess,
+            { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
+    }
+
+    inline void EndDepthTarget(BarrierBatch& barriers, VkImage image, VkImageLayout finalLayout,
+        VkPipelineStageFlags2 dstStages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VkAccessFlags2 dstAccess = VK_ACCESS_2_SHADER_READ_BIT, uint32_t layer = 0) {
+
+        barriers.Image(image, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, finalLayout,
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            dstStages, dstAccess,
+            { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, layer, 1 });
+    }
+
+    // Renders to a depth target again after a compute shader read it in readLayout, the contents are kept (load op LOAD)
+    inline void ResumeDepthTarget(BarrierBatch& barriers, VkImage image, VkImageLayout readLayout, uint32_t layer = 0) {
+        barriers.Image(image, readLayout, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_NONE,
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, layer, 1 });
+    }
+
+    // Single target passes, the barrier is recorded straight away
+    inline void BeginColorTarget(VkCommandBuffer cmd, VkImage image) {
+        BarrierBatch barriers;
+        BeginColorTarget(barriers, image);
+        barriers.Flush(cmd);
+    }
+
+    inline void BeginDepthTarget(VkCommandBuffer cmd, VkImage image) {
+        BarrierBatch barriers;
+        BeginDepthTarget(barriers, image);
+        barriers.Flush(cmd);
+    }
+
+    inline void ResumeDepthTarget(VkCommandBuffer cmd, VkImage image, VkImageLayout readLayout) {
+        BarrierBatch barriers;
+        ResumeDepthTarget(barriers, image, readLayout);
+        barriers.Flush(cmd);
+    }
+
+    inline void EndColorTarget(VkCommandBuffer cmd, VkImage image, VkImageLayout finalLayout,
+        VkPipelineStageFlags2 dstStages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VkAccessFlags2 dstAccess = VK_ACCESS_2_SHADER_READ_BIT) {
+
+        BarrierBatch barriers;
+        EndColorTarget(barriers, image, finalLayout, dstStages, dstAccess);
+        barriers.Flush(cmd);
+    }
+
+    inline void EndDepthTarget(VkCommandBuffer cmd, VkImage image, VkImageLayout finalLayout,
+        VkPipelineStageFlags2 dstStages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VkAccessFlags2 dstAccess = VK_ACCESS_2_SHADER_READ_BIT) {
+
+        BarrierBatch barriers;
+        EndDepthTarget(barriers, image, finalLayout, dstStages, dstAccess);
+        barriers.Flush(cmd);
+    }
+}
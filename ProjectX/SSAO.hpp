@@ -4,6 +4,7 @@
 #include "Image.hpp"
 #include "Buffer.hpp"
 #include "Camera.hpp"
+#include "PipelineVariants.hpp"
 
 namespace vk
 {
@@ -24,8 +25,8 @@ namespace vk
 	private:
 		void CreatePipeline();
 		void BuildDescriptors();
-		void CreateFramebuffer();
-		void CreateRenderPass();
+		void WriteDescriptors();
+		SpecializationConstants GetSpecialization() const;
 	    void GenerateNoiseTexture(uint32_t width, uint32_t height);
 
 		Context& context;
@@ -38,13 +39,12 @@ namespace vk
 		uint32_t m_width;
 		uint32_t m_height;
 
-		VkRenderPass m_RenderPass;
-		VkFramebuffer m_Framebuffer;
-
-		VkPipeline m_Pipeline;
+		PipelineVariants m_PipelineVariants;
+		VkPipeline m_Pipeline; // variant matching the current settings
 		VkPipelineLayout m_PipelineLayout;
 		std::vector<VkDescriptorSet> m_DescriptorSets;
 		VkDescriptorSetLayout m_DescriptorSetLayout;
+		VkDescriptorUpdateTemplate m_DescriptorUpdateTemplate;
 		std::vector<Buffer> m_SSAOUniform;
 	};
 }
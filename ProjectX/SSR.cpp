@@ -2,7 +2,7 @@
 #include "SSR.h"
 #include "Utils.hpp"
 #include "Pipeline.hpp"
-#include "RenderPass.hpp"
+#include "Rendering.hpp"
 
 vk::SSR::SSR(Context& context,
     const Image& inputImage,
@@ -20,15 +20,13 @@ vk::SSR::SSR(Context& context,
     m_width = context.extent.width;
     m_height = context.extent.height;
 
-    m_RenderTarget = CreateImageTexture2D(
+    m_RenderTarget = context.transientAllocator->CreateImage(
         "SSR_RenderTarget",
-        context,
         m_width,
         m_height,
         VK_FORMAT_R16G16B16A16_SFLOAT,
         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT,
-        1
+        VK_IMAGE_ASPECT_COLOR_BIT
     );
 
     m_SSRUniform.resize(MAX_FRAMES_IN_FLIGHT);
@@ -38,14 +36,22 @@ vk::SSR::SSR(Context& context,
     }
 
     BuildDescriptors();
-    CreateRenderPass();
-    CreateFramebuffer();
     CreatePipeline();
 }
 
 void vk::SSR::Update()
 {
     m_SSRUniform[currentFrame].WriteToBuffer(ssrSettings, sizeof(SSRSettings));
+
+    // Step and refinement counts are compiled into the shader, a new combination switches to (or compiles) its variant
+    m_Pipeline = m_PipelineVariants.Get(GetSpecialization());
+}
+
+vk::SpecializationConstants vk::SSR::GetSpecialization() const
+{
+    return SpecializationConstants()
+        .Set(0, ssrSettings.MaxSteps)
+        .Set(1, ssrSettings.BinarySearchIterations);
 }
 
 vk::SSR::~SSR()
@@ -55,11 +61,9 @@ vk::SSR::~SSR()
         buffer.Destroy(context.device);
     }
     m_RenderTarget.Destroy(context.device);
-    vkDestroyPipeline(context.device, m_Pipeline, nullptr);
-    vkDestroyPipelineLayout(context.device, m_PipelineLayout, nullptr);
+    m_PipelineVariants.Destroy();
+    vkDestroyDescriptorUpdateTemplate(context.device, m_DescriptorUpdateTemplate, nullptr);
     vkDestroyDescriptorSetLayout(context.device, m_DescriptorSetLayout, nullptr);
-    vkDestroyFramebuffer(context.device, m_Framebuffer, nullptr);
-    vkDestroyRenderPass(context.device, m_RenderPass, nullptr);
 }
 
 void vk::SSR::Resize()
@@ -68,64 +72,17 @@ void vk::SSR::Resize()
     m_height = context.extent.height;
 
     m_RenderTarget.Destroy(context.device);
-	vkDestroyFramebuffer(context.device, m_Framebuffer, nullptr);
 
-    m_RenderTarget = CreateImageTexture2D(
+    m_RenderTarget = context.transientAllocator->CreateImage(
         "SSR_RenderTarget",
-        context,
         m_width,
         m_height,
         VK_FORMAT_R16G16B16A16_SFLOAT,
         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_IMAGE_ASPECT_COLOR_BIT,
-        1
+        VK_IMAGE_ASPECT_COLOR_BIT
     );
 
-    CreateFramebuffer();
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        VkDescriptorImageInfo imageInfo = {
-            .sampler = clampToEdgeSamplerAniso,
-            .imageView = depthBuffer.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-        };
-
-        UpdateDescriptorSet(context, 2, imageInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-    }
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        VkDescriptorImageInfo imageInfo = {
-            .sampler = clampToEdgeSamplerAniso,
-            .imageView = inputImage.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        UpdateDescriptorSet(context, 3, imageInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-    }
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        VkDescriptorImageInfo imageInfo = {
-            .sampler = clampToEdgeSamplerAniso,
-            .imageView = metallicRoughness.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        UpdateDescriptorSet(context, 4, imageInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-    }
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        VkDescriptorImageInfo imageInfo = {
-            .sampler = clampToEdgeSamplerAniso,
-            .imageView = normalsTexture.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        UpdateDescriptorSet(context, 5, imageInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-    }
+    WriteDescriptors();
 }
 
 void vk::SSR::Execute(VkCommandBuffer cmd)
@@ -134,20 +91,27 @@ void vk::SSR::Execute(VkCommandBuffer cmd)
     RenderPassLabel(cmd, "SSR");
 #endif // !DEBUG
 
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = m_RenderPass;
-    renderPassInfo.framebuffer = m_Framebuffer;
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = { m_width, m_height };
+    BeginColorTarget(cmd, m_RenderTarget.image);
 
-    std::array<VkClearValue, 1> clearValues{};
-    clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+    RenderingInfo rendering({ m_width, m_height });
+    rendering.AddColorAttachment(m_RenderTarget.imageView, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
 
-    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassInfo.pClearValues = clearValues.data();
+    // Every pass records into its own command buffer, dynamic state isn't carried over from the previous one
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)m_width;
+    viewport.height = (float)m_height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
 
-    vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    VkRect2D scissor{};
+    scissor.offset = { 0,0 };
+    scissor.extent = { m_width, m_height };
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+    rendering.Begin(cmd);
 
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
 
@@ -155,7 +119,9 @@ void vk::SSR::Execute(VkCommandBuffer cmd)
 
     vkCmdDraw(cmd, 3, 1, 0, 0);
 
-    vkCmdEndRenderPass(cmd);
+    vkCmdEndRendering(cmd);
+
+    EndColorTarget(cmd, m_RenderTarget.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 #ifdef _DEBUG
     EndRenderPassLabel(cmd);
@@ -164,7 +130,7 @@ void vk::SSR::Execute(VkCommandBuffer cmd)
 
 void vk::SSR::CreatePipeline()
 {
-    auto pipelineResult = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
+    vk::PipelineBuilder builder = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::NONE, 0)
         .AddShader("../Engine/assets/shaders/fs_tri.vert.spv", ShaderType::VERTEX)
         .AddShader("../Engine/assets/shaders/SSR.frag.spv", ShaderType::FRAGMENT)
         .SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
@@ -174,45 +140,13 @@ void vk::SSR::CreatePipeline()
         .SetSampling(VK_SAMPLE_COUNT_1_BIT)
         .AddBlendAttachmentState()
         .SetDepthState(VK_FALSE, VK_FALSE, VK_COMPARE_OP_LESS_OR_EQUAL)
-        .SetRenderPass(m_RenderPass)
-        .Build();
-
-    m_Pipeline = pipelineResult.first;
-    m_PipelineLayout = pipelineResult.second;
-}
-void vk::SSR::CreateRenderPass()
-{
-    RenderPass builder(context.device, 1);
+        .SetRenderingFormats({ VK_FORMAT_R16G16B16A16_SFLOAT });
 
-    m_RenderPass = builder
-        .AddAttachment(VK_FORMAT_R16G16B16A16_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-        .AddColorAttachmentRef(0, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+    m_PipelineVariants = builder.BuildVariants(ShaderType::FRAGMENT);
+    m_PipelineVariants.Prepare(GetSpecialization());
 
-        // External -> 0 : Color
-        .AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-        // 0 -> External : Color : Wait for color writing to finish on the attachment before the fragment shader tries to read from it
-        .AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-        .Build();
-
-    context.SetObjectName(context.device, (uint64_t)m_RenderPass, VK_OBJECT_TYPE_RENDER_PASS, "SSRRenderPass");
-}
-
-void vk::SSR::CreateFramebuffer()
-{
-    std::vector<VkImageView> attachments = { m_RenderTarget.imageView };
-
-    VkFramebufferCreateInfo fbcInfo = {
-        .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-        .renderPass = m_RenderPass,
-        .attachmentCount = static_cast<uint32_t>(attachments.size()),
-        .pAttachments = attachments.data(),
-        .width = m_width,
-        .height = m_height,
-        .layers = 1
-    };
-
-    VK_CHECK(vkCreateFramebuffer(context.device, &fbcInfo, nullptr, &m_Framebuffer), "Failed to create SSR framebuffer.");
+    m_Pipeline = VK_NULL_HANDLE;
+    m_PipelineLayout = m_PipelineVariants.GetLayout();
 }
 
 void vk::SSR::BuildDescriptors()
@@ -229,70 +163,26 @@ void vk::SSR::BuildDescriptors()
         };
 
         m_DescriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
+        m_DescriptorUpdateTemplate = CreateDescriptorUpdateTemplate(context, m_DescriptorSetLayout, bindings);
     }
 
-    AllocateDescriptorSets(context, context.descriptorPool, m_DescriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_DescriptorSets);
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = camera->GetBuffers()[i].buffer;
-        bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(CameraTransform);
-        UpdateDescriptorSet(context, 0, bufferInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-    }
+    AllocateDescriptorSets(context, m_DescriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_DescriptorSets);
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = m_SSRUniform[i].buffer;
-        bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(SSRSettings);
-        UpdateDescriptorSet(context, 1, bufferInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-    }
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        VkDescriptorImageInfo imageInfo = {
-            .sampler = clampToEdgeSamplerAniso,
-            .imageView = depthBuffer.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-        };
-
-        UpdateDescriptorSet(context, 2, imageInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-    }
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        VkDescriptorImageInfo imageInfo = {
-            .sampler = clampToEdgeSamplerAniso,
-            .imageView = inputImage.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        UpdateDescriptorSet(context, 3, imageInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-    }
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-    {
-        VkDescriptorImageInfo imageInfo = {
-            .sampler = clampToEdgeSamplerAniso,
-            .imageView = metallicRoughness.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        UpdateDescriptorSet(context, 4, imageInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-    }
+    WriteDescriptors();
+}
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+void vk::SSR::WriteDescriptors()
+{
+    for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
     {
-        VkDescriptorImageInfo imageInfo = {
-            .sampler = clampToEdgeSamplerAniso,
-            .imageView = normalsTexture.imageView,
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        };
-
-        UpdateDescriptorSet(context, 5, imageInfo, m_DescriptorSets[i], VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        UpdateDescriptorSet(context, m_DescriptorUpdateTemplate, m_DescriptorSets[i], {
+            DescriptorInfo(camera->GetBuffers()[i].buffer, sizeof(CameraTransform)),
+            DescriptorInfo(m_SSRUniform[i].buffer, sizeof(SSRSettings)),
+            DescriptorInfo(clampToEdgeSamplerAniso, depthBuffer.imageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL),
+            DescriptorInfo(clampToEdgeSamplerAniso, inputImage.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+            DescriptorInfo(clampToEdgeSamplerAniso, metallicRoughness.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+            DescriptorInfo(clampToEdgeSamplerAniso, normalsTexture.imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+        });
     }
 }
 
@@ -1,99 +1,412 @@
 #include "Scene.hpp"
+#include "Barriers.hpp"
 
-vk::Scene::Scene(Context& context) : context(context) {}
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
-void vk::Scene::AddModel(const std::shared_ptr<BakedModel>& model)
+namespace
 {
-	// Begin creating GPU texture ( image ) resource for each found texture
-	model->loadedTextures.resize(model->textures.size());
-	for (size_t i = 0; i < model->loadedTextures.size(); i++)
+	// Material texture IDs index the model's own textures, shaders index the bindless table. Missing textures (~0u) stay as they are.
+	uint32_t TextureSlot(const BakedModel& model, uint32_t textureId)
 	{
-		const std::string path = model->textures[i].path;
-		model->loadedTextures[i] = LoadTextureFromDisk(path, context);
+		return textureId < model.textureSlots.size() ? model.textureSlots[textureId] : textureId;
 	}
 
-	for (auto& mesh : model->meshes)
+	vk::ObjectBounds EmptyBounds()
 	{
-		VkDeviceSize vertexSize = sizeof(mesh.vertexData[0]) * mesh.vertexData.size();
-		CreateAndUploadBuffer(context, mesh.vertexData.data(), vertexSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, mesh.vertexBuffer);
-
-		VkDeviceSize indexSize = sizeof(mesh.indices[0]) * mesh.indices.size();
-		CreateAndUploadBuffer(context, mesh.indices.data(), indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mesh.indexBuffer);
-
+		return { glm::vec4(std::numeric_limits<float>::max()), glm::vec4(std::numeric_limits<float>::lowest()) };
 	}
 
-	// Seperate front and back meshes depending on whether or not they have a alpha mask texture id
-	for (size_t i = 0; i < model->meshes.size(); i++)
+	// Box around the transformed corners of a box
+	vk::ObjectBounds TransformBounds(const vk::ObjectBounds& local, const glm::mat4& transform)
 	{
-		// If the mesh has no alpha masking textures
-		if (model->materials[model->meshes[i].materialId].alphaMaskTextureId == std::numeric_limits<uint32_t>::max())
+		vk::ObjectBounds bounds = EmptyBounds();
+		for (uint32_t corner = 0; corner < 8; corner++)
 		{
-			m_FrontMeshes.push_back(i);
-		}
-		else
-		{
-			m_BackMeshes.push_back(i);
+			const glm::vec4 world = transform * glm::vec4(
+				(corner & 1) ? local.max.x : local.min.x,
+				(corner & 2) ? local.max.y : local.min.y,
+				(corner & 4) ? local.max.z : local.min.z,
+				1.0f);
+
+			bounds.min = glm::min(bounds.min, world);
+			bounds.max = glm::max(bounds.max, world);
 		}
+
+		return bounds;
 	}
 
-	m_models.push_back(model);
+	// Moller-Trumbore, distance along the ray or a negative value on a miss. Both sides of the triangle count.
+	float IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		const glm::vec3 edge1 = b - a;
+		const glm::vec3 edge2 = c - a;
+		const glm::vec3 p = glm::cross(direction, edge2);
+		const float determinant = glm::dot(edge1, p);
+		if (std::abs(determinant) < 1e-12f)
+			return -1.0f;
+
+		const float inverseDeterminant = 1.0f / determinant;
+		const glm::vec3 s = origin - a;
+		const float u = glm::dot(s, p) * inverseDeterminant;
+		if (u < 0.0f || u > 1.0f)
+			return -1.0f;
 
+		const glm::vec3 q = glm::cross(s, edge1);
+		const float v = glm::dot(direction, q) * inverseDeterminant;
+		if (v < 0.0f || u + v > 1.0f)
+			return -1.0f;
+
+		return glm::dot(edge2, q) * inverseDeterminant;
+	}
+}
+
+vk::Scene::Scene(Context& context) : context(context), m_OpaqueDrawCount{0}, m_DrawCount{0}, m_DrawDataLayout{VK_NULL_HANDLE}, m_DrawDataSet{VK_NULL_HANDLE}
+{
+	std::vector<VkDescriptorSetLayoutBinding> bindings = {
+		CreateDescriptorBinding(0, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_GEOMETRY_BIT | VK_SHADER_STAGE_FRAGMENT_BIT), // Objects
+		CreateDescriptorBinding(1, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT) // Materials
+	};
+
+	m_DrawDataLayout = CreateDescriptorSetLayout(context, bindings);
+	m_DrawDataSet = context.descriptorAllocator->Allocate(m_DrawDataLayout);
 
 	m_LightUBO.resize(MAX_FRAMES_IN_FLIGHT);
 	// Light uniform buffers
 	for (auto& buffer : m_LightUBO)
 		buffer = CreateBuffer("LightUBO", context, sizeof(LightBuffer), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-
 }
 
-void vk::Scene::RenderFrontMeshes(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout)
+vk::Entity vk::Scene::AddModel(const std::shared_ptr<BakedModel>& model, const std::shared_ptr<BakedModel>& textureSource)
 {
-	for (auto& model : m_models)
+	if (textureSource)
+	{
+		// Owned by the source, only its slots are taken
+		model->textureSlots = textureSource->textureSlots;
+	}
+	else
 	{
-		for (auto& index : m_FrontMeshes)
+		// Decoding dominates load time, decode every texture on the job system then upload them in order on this thread
+		std::vector<TextureData> decoded(model->textures.size());
+		context.jobSystem->ParallelFor(static_cast<uint32_t>(decoded.size()), [&](uint32_t i, uint32_t)
 		{
-			auto& mesh = model->meshes[index];
-			MeshPushConstants pc = {};
-			pc.ModelMatrix = glm::mat4(1.0f);
-			pc.dTextureID = model->materials[mesh.materialId].baseColorTextureId;
-			pc.mTextureID = model->materials[mesh.materialId].metalnessTextureId;
-			pc.rTextureID = model->materials[mesh.materialId].roughnessTextureId;
-			pc.eTextureID = model->materials[mesh.materialId].emissiveTextureId == 0xffffffff ? -1 : model->materials[mesh.materialId].emissiveTextureId;
-			pc.nTextureID = model->materials[mesh.materialId].normalMapTextureId;
-
-			vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_GEOMETRY_BIT, 0, sizeof(MeshPushConstants), &pc);
-			// Set up push constants
-			VkDeviceSize offset[] = { 0 };
-			vkCmdBindVertexBuffers(cmd, 0, 1, &mesh.vertexBuffer.buffer, offset);
-			vkCmdBindIndexBuffer(cmd, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-			vkCmdDrawIndexed(cmd, static_cast<uint32_t>(mesh.indices.size()), 1, 0, 0, 0);
+			decoded[i] = DecodeTexture(model->textures[i].path);
+		});
+
+		// Begin creating GPU texture ( image ) resource for each found texture
+		model->loadedTextures.resize(model->textures.size());
+		model->textureSlots.resize(model->textures.size());
+		for (size_t i = 0; i < model->loadedTextures.size(); i++)
+		{
+			model->loadedTextures[i] = UploadTexture(decoded[i], context);
+			model->textureSlots[i] = context.bindlessTextures->Add(model->loadedTextures[i].imageView);
 		}
 	}
+
+	// Triangle hierarchies in the model's own space, shared by every instance for ray casts
+	std::vector<Bvh>& meshBvhs = m_MeshBvhs.emplace_back(model->meshes.size());
+	context.jobSystem->ParallelFor(static_cast<uint32_t>(model->meshes.size()), [&](uint32_t i, uint32_t)
+	{
+		const BakedMeshData& mesh = model->meshes[i];
+
+		std::vector<ObjectBounds> triangles(mesh.indices.size() / 3);
+		for (size_t t = 0; t < triangles.size(); t++)
+		{
+			const glm::vec3& a = mesh.vertexData[mesh.indices[t * 3 + 0]].pos;
+			const glm::vec3& b = mesh.vertexData[mesh.indices[t * 3 + 1]].pos;
+			const glm::vec3& c = mesh.vertexData[mesh.indices[t * 3 + 2]].pos;
+			triangles[t] = { glm::vec4(glm::min(glm::min(a, b), c), 1.0f), glm::vec4(glm::max(glm::max(a, b), c), 1.0f) };
+		}
+
+		meshBvhs[i].Build(triangles);
+	});
+
+	// Geometry is uploaded with the rest of the draw data, merged with the other models'
+	const uint32_t modelIndex = static_cast<uint32_t>(m_models.size());
+	const Entity entity = m_Entities.CreateModelInstance(glm::mat4(1.0f), modelIndex, 0);
+	m_models.push_back(model);
+	m_ModelInstances.push_back({ entity });
+	BuildDrawData();
+
+	return entity;
 }
 
+std::vector<vk::Entity> vk::Scene::AddInstances(const std::shared_ptr<BakedModel>& model, const std::vector<glm::mat4>& transforms, Entity parent)
+{
+	auto it = std::find(m_models.begin(), m_models.end(), model);
+	if (it == m_models.end())
+		throw std::runtime_error("Instances can only be added for a model already in the scene");
+
+	const uint32_t modelIndex = static_cast<uint32_t>(it - m_models.begin());
+	std::vector<Entity>& instances = m_ModelInstances[modelIndex];
+
+	std::vector<Entity> entities;
+	for (const glm::mat4& transform : transforms)
+	{
+		entities.push_back(m_Entities.CreateModelInstance(transform, modelIndex, static_cast<uint32_t>(instances.size()), parent));
+		instances.push_back(entities.back());
+	}
+
+	BuildDrawData();
+	return entities;
+}
 
-void vk::Scene::RenderBackMeshes(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout)
+void vk::Scene::BuildDrawData()
 {
-	for (auto& model : m_models)
+	// A draw before it's sorted into its list, bounds are in world space and cover every instance
+	struct SceneDraw
 	{
-		for (auto& index : m_BackMeshes)
+		VkDrawIndexedIndirectCommand command;
+		ObjectBounds bounds;
+		MeshRef mesh;
+		uint32_t material;
+		bool alphaMasked;
+	};
+
+	// Instances are placed by their world transforms, settle the ones created since the last build
+	m_Entities.UpdateTransforms();
+
+	std::vector<std::vector<glm::mat4>> instanceWorlds(m_models.size());
+	for (size_t m = 0; m < m_models.size(); m++)
+	{
+		instanceWorlds[m].resize(m_ModelInstances[m].size());
+	}
+
+	m_Entities.ForEachModelInstance([&](uint32_t model, uint32_t copy, const glm::mat4& world)
+	{
+		instanceWorlds[model][copy] = world;
+	});
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<ObjectData> objects;
+	std::vector<MaterialData> materials;
+	std::vector<SceneDraw> sceneDraws;
+	m_MeshDraws.resize(m_models.size());
+	m_MeshBounds.resize(m_models.size());
+	m_ObjectBounds.clear();
+
+	for (size_t m = 0; m < m_models.size(); m++)
+	{
+		const auto& model = m_models[m];
+		const std::vector<Entity>& instances = m_ModelInstances[m];
+		m_MeshDraws[m].assign(model->meshes.size(), UINT32_MAX);
+		if (instances.empty())
+			continue;
+
+		// Material IDs are local to the model, its entries start where the previous model's ended
+		const uint32_t firstMaterial = static_cast<uint32_t>(materials.size());
+		for (const auto& material : model->materials)
 		{
-			auto& mesh = model->meshes[index];
-			MeshPushConstants pc = {};
-			pc.ModelMatrix = glm::mat4(1.0f);
-			pc.dTextureID = model->materials[mesh.materialId].baseColorTextureId;
-			pc.mTextureID = model->materials[mesh.materialId].metalnessTextureId;
-			pc.rTextureID = model->materials[mesh.materialId].roughnessTextureId;
-			pc.eTextureID = model->materials[mesh.materialId].emissiveTextureId == 0xffffffff ? -1 : model->materials[mesh.materialId].emissiveTextureId;
-
-			vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_GEOMETRY_BIT, 0, sizeof(MeshPushConstants), &pc);
-			// Set up push constants
-			VkDeviceSize offset[] = { 0 };
-			vkCmdBindVertexBuffers(cmd, 0, 1, &mesh.vertexBuffer.buffer, offset);
-			vkCmdBindIndexBuffer(cmd, mesh.indexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-			vkCmdDrawIndexed(cmd, static_cast<uint32_t>(mesh.indices.size()), 1, 0, 0, 0);
+			MaterialData data = {};
+			data.dTextureID = TextureSlot(*model, material.baseColorTextureId);
+			data.mTextureID = TextureSlot(*model, material.metalnessTextureId);
+			data.rTextureID = TextureSlot(*model, material.roughnessTextureId);
+			data.eTextureID = TextureSlot(*model, material.emissiveTextureId);
+			data.nTextureID = TextureSlot(*model, material.normalMapTextureId);
+			materials.push_back(data);
+		}
+
+		m_MeshBounds[m].resize(model->meshes.size());
+		for (uint32_t j = 0; j < static_cast<uint32_t>(model->meshes.size()); j++)
+		{
+			const auto& mesh = model->meshes[j];
+
+			ObjectBounds& meshBounds = m_MeshBounds[m][j];
+			meshBounds = EmptyBounds();
+			for (const auto& vertex : mesh.vertexData)
+			{
+				meshBounds.min = glm::min(meshBounds.min, glm::vec4(vertex.pos, 1.0f));
+				meshBounds.max = glm::max(meshBounds.max, glm::vec4(vertex.pos, 1.0f));
+			}
+
+			SceneDraw draw = {};
+			draw.mesh = { static_cast<uint32_t>(m), j };
+			draw.material = firstMaterial + mesh.materialId;
+			draw.alphaMasked = model->materials[mesh.materialId].alphaMaskTextureId != std::numeric_limits<uint32_t>::max();
+
+			// Mesh indices stay local to the mesh, vertexOffset moves them to where its vertices were placed.
+			// Every copy of the mesh shares its geometry and material, they're one draw with an object per instance and
+			// gl_InstanceIndex (firstInstance + instance) picks the instance's transform.
+			draw.command.indexCount = static_cast<uint32_t>(mesh.indices.size());
+			draw.command.instanceCount = static_cast<uint32_t>(instances.size());
+			draw.command.firstIndex = static_cast<uint32_t>(indices.size());
+			draw.command.vertexOffset = static_cast<int32_t>(vertices.size());
+			draw.command.firstInstance = static_cast<uint32_t>(objects.size());
+
+			for (const glm::mat4& world : instanceWorlds[m])
+			{
+				ObjectData object = {};
+				object.ModelMatrix = world;
+				object.materialIndex = draw.material;
+				objects.push_back(object);
+				m_ObjectBounds.push_back(TransformBounds(meshBounds, object.ModelMatrix));
+			}
+			draw.bounds = DrawBounds(draw.command);
+
+			sceneDraws.push_back(draw);
+
+			vertices.insert(vertices.end(), mesh.vertexData.begin(), mesh.vertexData.end());
+			indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
 		}
 	}
+
+	if (objects.empty() || materials.empty())
+		return;
+
+	// Opaque draws first, each list grouped by material. GPU culling appends the draws roughly in this order.
+	std::stable_sort(sceneDraws.begin(), sceneDraws.end(), [](const SceneDraw& a, const SceneDraw& b)
+	{
+		return a.alphaMasked != b.alphaMasked ? b.alphaMasked : a.material < b.material;
+	});
+
+	std::vector<VkDrawIndexedIndirectCommand> draws;
+	std::vector<ObjectBounds> bounds;
+	m_DrawMeshes.clear();
+	m_ObjectDraws.resize(objects.size());
+	m_OpaqueDrawCount = 0;
+	for (const SceneDraw& draw : sceneDraws)
+	{
+		m_MeshDraws[draw.mesh.model][draw.mesh.mesh] = static_cast<uint32_t>(draws.size());
+		m_DrawMeshes.push_back(draw.mesh);
+		std::fill_n(m_ObjectDraws.begin() + draw.command.firstInstance, draw.command.instanceCount, static_cast<uint32_t>(draws.size()));
+		draws.push_back(draw.command);
+		bounds.push_back(draw.bounds);
+		m_OpaqueDrawCount += draw.alphaMasked ? 0 : 1;
+	}
+	m_DrawCount = static_cast<uint32_t>(draws.size());
+
+	// Models are added while loading, nothing is in flight that could still read the old buffers
+	m_VertexBuffer.Destroy(context.device);
+	m_IndexBuffer.Destroy(context.device);
+	m_IndirectBuffer.Destroy(context.device);
+	m_ObjectBuffer.Destroy(context.device);
+	m_BoundsBuffer.Destroy(context.device);
+	m_MaterialBuffer.Destroy(context.device);
+	for (auto& buffer : m_UploadBuffers)
+	{
+		buffer.Destroy(context.device);
+	}
+
+	CreateAndUploadBuffer(context, vertices.data(), sizeof(Vertex) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, m_VertexBuffer);
+	CreateAndUploadBuffer(context, indices.data(), sizeof(uint32_t) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, m_IndexBuffer);
+	// Only read by the culling compute shaders
+	CreateAndUploadBuffer(context, draws.data(), sizeof(VkDrawIndexedIndirectCommand) * draws.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_IndirectBuffer);
+	CreateAndUploadBuffer(context, objects.data(), sizeof(ObjectData) * objects.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_ObjectBuffer);
+	CreateAndUploadBuffer(context, bounds.data(), sizeof(ObjectBounds) * bounds.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_BoundsBuffer);
+	CreateAndUploadBuffer(context, materials.data(), sizeof(MaterialData) * materials.size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, m_MaterialBuffer);
+
+	// Enough for every object and draw changing in the same frame
+	m_UploadBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+	for (auto& buffer : m_UploadBuffers)
+		buffer = CreateBuffer("SceneUpload", context, sizeof(ObjectData) * objects.size() + sizeof(ObjectBounds) * bounds.size(),
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+
+	m_FrustumCuller.Build(bounds);
+	m_Bvh.Build(m_ObjectBounds);
+	m_Draws = std::move(draws);
+	m_Objects = std::move(objects);
+	m_Bounds = std::move(bounds);
+
+	// Everything is on the GPU already
+	m_ObjectChanged.assign(m_Objects.size(), 0);
+	m_DrawChanged.assign(m_Draws.size(), 0);
+	m_ChangedObjects.clear();
+	m_ChangedDraws.clear();
+
+	VkDescriptorBufferInfo objectInfo = { m_ObjectBuffer.buffer, 0, VK_WHOLE_SIZE };
+	UpdateDescriptorSet(context, 0, objectInfo, m_DrawDataSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+	VkDescriptorBufferInfo materialInfo = { m_MaterialBuffer.buffer, 0, VK_WHOLE_SIZE };
+	UpdateDescriptorSet(context, 1, materialInfo, m_DrawDataSet, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+}
+
+vk::ObjectBounds vk::Scene::DrawBounds(const VkDrawIndexedIndirectCommand& draw) const
+{
+	ObjectBounds bounds = EmptyBounds();
+	for (uint32_t object = draw.firstInstance; object < draw.firstInstance + draw.instanceCount; object++)
+	{
+		bounds.min = glm::min(bounds.min, m_ObjectBounds[object].min);
+		bounds.max = glm::max(bounds.max, m_ObjectBounds[object].max);
+	}
+
+	return bounds;
+}
+
+bool vk::Scene::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const
+{
+	glm::vec3 normal(0.0f);
+	hit.distance = maxDistance;
+
+	// Objects by their world boxes, then the triangles of the ones the ray reaches in their mesh's hierarchy
+	const bool found = m_Bvh.Raycast(origin, direction, hit.distance, hit.object, [&](uint32_t object, float closest)
+	{
+		const MeshRef mesh = m_DrawMeshes[m_ObjectDraws[object]];
+		const BakedMeshData& data = m_models[mesh.model]->meshes[mesh.mesh];
+
+		// The direction isn't normalized again so distances along the ray stay the same in the mesh's space
+		const glm::mat4 toLocal = glm::inverse(m_Objects[object].ModelMatrix);
+		const glm::vec3 localOrigin = glm::vec3(toLocal * glm::vec4(origin, 1.0f));
+		const glm::vec3 localDirection = glm::vec3(toLocal * glm::vec4(direction, 0.0f));
+
+		auto corner = [&](uint32_t triangle, uint32_t i) -> const glm::vec3& { return data.vertexData[data.indices[triangle * 3 + i]].pos; };
+
+		float distance = closest;
+		uint32_t triangle = 0;
+		const bool triangleHit = m_MeshBvhs[mesh.model][mesh.mesh].Raycast(localOrigin, localDirection, distance, triangle, [&](uint32_t candidate, float)
+		{
+			return IntersectTriangle(localOrigin, localDirection, corner(candidate, 0), corner(candidate, 1), corner(candidate, 2));
+		});
+
+		if (!triangleHit)
+			return -1.0f;
+
+		// Normals go to world space with the inverse transpose, facing back along the ray
+		const glm::vec3 localNormal = glm::cross(corner(triangle, 1) - corner(triangle, 0), corner(triangle, 2) - corner(triangle, 0));
+		normal = glm::normalize(glm::mat3(glm::transpose(toLocal)) * localNormal);
+		if (glm::dot(normal, direction) > 0.0f)
+			normal = -normal;
+
+		return distance;
+	});
+
+	hit.normal = normal;
+	return found;
+}
+
+uint32_t vk::Scene::FindShadowCasters(const glm::mat4& lightViewProjection, std::vector<uint8_t>& visibility, std::vector<uint32_t>& objects) const
+{
+	objects.clear();
+	m_Bvh.QueryFrustum(lightViewProjection, objects);
+
+	// A draw casts when any of its instances is inside the light's volume
+	uint32_t casters = 0;
+	visibility.assign((m_DrawCount + FrustumCuller::BoxesPerGroup - 1) / FrustumCuller::BoxesPerGroup, 0);
+	for (uint32_t object : objects)
+	{
+		const uint32_t draw = m_ObjectDraws[object];
+		uint8_t& group = visibility[draw / FrustumCuller::BoxesPerGroup];
+		const uint8_t bit = static_cast<uint8_t>(1u << (draw % FrustumCuller::BoxesPerGroup));
+
+		casters += (group & bit) ? 0 : 1;
+		group |= bit;
+	}
+
+	return casters;
+}
+
+void vk::Scene::Pick(const glm::vec3& origin, const glm::vec3& direction)
+{
+	RayHit hit;
+	m_PickedObject = Raycast(origin, direction, std::numeric_limits<float>::max(), hit) ? hit.object : UINT32_MAX;
+}
+
+void vk::Scene::BindGeometry(VkCommandBuffer cmd)
+{
+	const VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(cmd, 0, 1, &m_VertexBuffer.buffer, &offset);
+	vkCmdBindIndexBuffer(cmd, m_IndexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
 }
 
 void vk::Scene::AddLightSource(Light& LightSource)
@@ -103,11 +416,45 @@ void vk::Scene::AddLightSource(Light& LightSource)
 
 void vk::Scene::Update(GLFWwindow* window)
 {
-	for (auto& light : m_Lights)
+	// Only the instances that moved, and the draws they belong to, are written and uploaded again
+	m_Entities.UpdateTransforms();
+	m_MovedBounds.clear();
+	m_Entities.ForEachChangedModelInstance([this](uint32_t model, uint32_t copy, const glm::mat4& world)
 	{
-		glm::mat4 ortho = glm::ortho(-light.View, light.View, -light.View, light.View, light.Near, light.Far);
-		glm::mat4 view = glm::lookAt(glm::vec3(light.position), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0));
-		light.LightSpaceMatrix = ortho * view;
+		for (uint32_t draw : m_MeshDraws[model])
+		{
+			if (draw == UINT32_MAX)
+				continue;
+
+			const uint32_t object = m_Draws[draw].firstInstance + copy;
+			const MeshRef mesh = m_DrawMeshes[draw];
+			m_Objects[object].ModelMatrix = world;
+			m_MovedBounds.push_back(m_ObjectBounds[object]);
+			m_ObjectBounds[object] = TransformBounds(m_MeshBounds[mesh.model][mesh.mesh], world);
+			m_MovedBounds.push_back(m_ObjectBounds[object]);
+			if (!m_ObjectChanged[object])
+			{
+				m_ObjectChanged[object] = 1;
+				m_ChangedObjects.push_back(object);
+			}
+
+			if (!m_DrawChanged[draw])
+			{
+				m_DrawChanged[draw] = 1;
+				m_ChangedDraws.push_back(draw);
+			}
+		}
+	});
+
+	if (m_Entities.HasChanges())
+	{
+		for (uint32_t draw : m_ChangedDraws)
+		{
+			m_Bounds[draw] = DrawBounds(m_Draws[draw]);
+			m_FrustumCuller.SetBounds(draw, m_Bounds[draw]);
+		}
+
+		m_Bvh.Refit(m_ObjectBounds);
 	}
 
 	// Fill GPU Data with data defined for the scene
@@ -116,13 +463,66 @@ void vk::Scene::Update(GLFWwindow* window)
 		m_LightBuffer.lights[i].type = static_cast<int>(m_Lights[i].Type);
 		m_LightBuffer.lights[i].LightPosition = m_Lights[i].position;
 		m_LightBuffer.lights[i].LightColour = m_Lights[i].colour;
-		m_LightBuffer.lights[i].LightSpaceMatrix = m_Lights[i].LightSpaceMatrix;
 	}
 
 	// Pass the light data to the GPU to update all light properties
 	m_LightUBO[currentFrame].WriteToBuffer(m_LightBuffer, sizeof(LightBuffer));
 }
 
+void vk::Scene::RecordUploads(VkCommandBuffer cmd)
+{
+	// Changes pile up until a frame gets recorded, a frame skipped for a resize doesn't lose them
+	if (m_ChangedObjects.empty() && m_ChangedDraws.empty())
+		return;
+
+	std::vector<uint8_t> staging;
+	std::vector<VkBufferCopy> objectCopies;
+	std::vector<VkBufferCopy> boundsCopies;
+
+	staging.reserve(m_ChangedObjects.size() * sizeof(ObjectData) + m_ChangedDraws.size() * sizeof(ObjectBounds));
+	for (uint32_t object : m_ChangedObjects)
+	{
+		objectCopies.push_back({ staging.size(), object * sizeof(ObjectData), sizeof(ObjectData) });
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(&m_Objects[object]);
+		staging.insert(staging.end(), data, data + sizeof(ObjectData));
+		m_ObjectChanged[object] = 0;
+	}
+
+	for (uint32_t draw : m_ChangedDraws)
+	{
+		boundsCopies.push_back({ staging.size(), draw * sizeof(ObjectBounds), sizeof(ObjectBounds) });
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(&m_Bounds[draw]);
+		staging.insert(staging.end(), data, data + sizeof(ObjectBounds));
+		m_DrawChanged[draw] = 0;
+	}
+
+	m_ChangedObjects.clear();
+	m_ChangedDraws.clear();
+
+	Buffer& upload = m_UploadBuffers[currentFrame];
+	upload.WriteToBuffer(staging.data(), staging.size());
+
+	// The previous frame may still read the transforms while drawing and the bounds while culling
+	BarrierBatch before;
+	before.Buffer(m_ObjectBuffer.buffer, VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+		VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+	before.Buffer(m_BoundsBuffer.buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+		VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+	before.Flush(cmd);
+
+	if (!objectCopies.empty())
+		vkCmdCopyBuffer(cmd, upload.buffer, m_ObjectBuffer.buffer, static_cast<uint32_t>(objectCopies.size()), objectCopies.data());
+	if (!boundsCopies.empty())
+		vkCmdCopyBuffer(cmd, upload.buffer, m_BoundsBuffer.buffer, static_cast<uint32_t>(boundsCopies.size()), boundsCopies.data());
+
+	BarrierBatch after;
+	after.Buffer(m_ObjectBuffer.buffer, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+	after.Buffer(m_BoundsBuffer.buffer, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+	after.Flush(cmd);
+}
+
 void vk::Scene::Destroy()
 {
 	for (auto& buffer : m_LightUBO)
@@ -130,20 +530,30 @@ void vk::Scene::Destroy()
 		buffer.Destroy(context.device);
 	}
 
+	for (auto& buffer : m_UploadBuffers)
+	{
+		buffer.Destroy(context.device);
+	}
+
+	m_VertexBuffer.Destroy(context.device);
+	m_IndexBuffer.Destroy(context.device);
+	m_IndirectBuffer.Destroy(context.device);
+	m_ObjectBuffer.Destroy(context.device);
+	m_BoundsBuffer.Destroy(context.device);
+	m_MaterialBuffer.Destroy(context.device);
+	vkDestroyDescriptorSetLayout(context.device, m_DrawDataLayout, nullptr);
+
 	if (!m_models.empty())
 	{
 		for (auto& model : m_models)
 		{
-			for (auto& mesh : model->meshes)
-			{
-				mesh.vertexBuffer.Destroy(context.device);
-				mesh.indexBuffer.Destroy(context.device);
-			}
-
-			for (auto& texture : model->loadedTextures)
+			// Models sharing another's textures have none loaded and leave its slots alone
+			for (size_t i = 0; i < model->loadedTextures.size(); i++)
 			{
-				texture.Destroy(context.device);
+				model->loadedTextures[i].Destroy(context.device);
+				context.bindlessTextures->Remove(model->textureSlots[i]);
 			}
+			model->textureSlots.clear();
 		}
 	}
 }
@@ -6,6 +6,9 @@
 #include "Utils.hpp"
 #include "Light.hpp"
 #include "Buffer.hpp"
+#include "FrustumCuller.hpp"
+#include "EntityStore.hpp"
+#include "Bvh.hpp"
 
 #include <cstddef>
 #include <memory>
@@ -20,13 +23,52 @@ namespace vk
 	public:
 
 		Scene(Context& context);
-		void AddModel(const std::shared_ptr<BakedModel>& model);
+		// Loads the model's textures and places one instance of it with an identity transform, returns its entity.
+		// textureSource is a model already in the scene with the same texture list, its textures are used instead.
+		Entity AddModel(const std::shared_ptr<BakedModel>& model, const std::shared_ptr<BakedModel>& textureSource = nullptr);
+		// More copies of a model already added, optionally attached to a parent entity. All copies of a mesh are drawn by
+		// a single instanced draw. Like AddModel it's for loading, before the passes that draw the scene are created.
+		std::vector<Entity> AddInstances(const std::shared_ptr<BakedModel>& model, const std::vector<glm::mat4>& transforms, Entity parent = NullEntity);
 
-		void RenderFrontMeshes(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout);
-		void RenderBackMeshes(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout);
+		struct RayHit
+		{
+			float distance;
+			uint32_t object; // index into GetObjects
+			glm::vec3 normal; // world space, facing the ray's origin
+		};
+
+		// Closest triangle of any object along origin + t * direction, t up to maxDistance
+		bool Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const;
+		// Draws with an instance inside the light's volume, one bit per draw laid out like FrustumCuller's visibility.
+		// objects is scratch for the query. Returns the number of draws set.
+		uint32_t FindShadowCasters(const glm::mat4& lightViewProjection, std::vector<uint8_t>& visibility, std::vector<uint32_t>& objects) const;
+		// Remembers the object under the ray, UINT32_MAX when there's none
+		void Pick(const glm::vec3& origin, const glm::vec3& direction);
+		uint32_t GetPickedObject() const { return m_PickedObject; }
+
+		// World space boxes of the objects for frustum, box and sphere queries, refit as entities move
+		const Bvh& GetBvh() const { return m_Bvh; }
+		// Boxes of the objects the last Update moved, where each was before and where it is now
+		const std::vector<ObjectBounds>& GetMovedBounds() const { return m_MovedBounds; }
+
+		// Entities move through SetLocalTransform, Update picks up whatever changed since the last frame
+		EntityStore& GetEntities() { return m_Entities; }
+
+		// Which part of a draw list a pass draws, alpha masked geometry needs its own pipeline in most passes
+		enum class DrawFilter
+		{
+			Opaque,
+			AlphaMasked,
+			All
+		};
+
+		// Vertex and index buffers every draw indexes into, bound once before a view's indirect draws
+		void BindGeometry(VkCommandBuffer cmd);
 
 		void AddLightSource(Light& LightSource);
 		void Update(GLFWwindow* window);
+		// Copies the transforms and bounds that changed into the GPU buffers, before anything reads them this frame
+		void RecordUploads(VkCommandBuffer cmd);
 
 		void Destroy();
 
@@ -34,12 +76,75 @@ namespace vk
 		std::vector<Light>&							   GetLights() { return m_Lights; }
 		std::vector<Buffer>&						   GetLightsUBO() { return m_LightUBO; }
 
+		// Object transforms (binding 0) and material table (binding 1), shared by every pass that draws the scene
+		static constexpr uint32_t DrawDataSet = 2;
+		VkDescriptorSetLayout GetDrawDataLayout() const { return m_DrawDataLayout; }
+		VkDescriptorSet		  GetDrawDataSet() const { return m_DrawDataSet; }
+
+		// Every draw of the scene, opaque ones first, the culling views compact them into their own lists
+		const Buffer& GetDrawBuffer() const { return m_IndirectBuffer; }
+		const Buffer& GetBoundsBuffer() const { return m_BoundsBuffer; }
+		uint32_t	  GetDrawCount() const { return m_DrawCount; }
+		uint32_t	  GetOpaqueDrawCount() const { return m_OpaqueDrawCount; }
+
+		// CPU copies for culling without the compute shaders. A draw's objects are firstInstance onwards, one per instance.
+		const std::vector<VkDrawIndexedIndirectCommand>& GetDraws() const { return m_Draws; }
+		const std::vector<ObjectData>&					 GetObjects() const { return m_Objects; }
+		const FrustumCuller&							 GetFrustumCuller() const { return m_FrustumCuller; }
+
 	private:
+		// A mesh of one of the models
+		struct MeshRef
+		{
+			uint32_t model;
+			uint32_t mesh;
+		};
+
+		void BuildDrawData();
+		// World space box around every instance the draw covers
+		ObjectBounds DrawBounds(const VkDrawIndexedIndirectCommand& draw) const;
+
 		Context& context;
 		std::vector<std::shared_ptr<BakedModel>> m_models;
+		std::vector<std::vector<Entity>> m_ModelInstances; // entity of every copy, indexed like m_models
+		EntityStore m_Entities;
+
+		std::vector<std::vector<uint32_t>> m_MeshDraws;		// draw of every mesh of every model
+		std::vector<std::vector<ObjectBounds>> m_MeshBounds; // model space box of every mesh of every model
+		std::vector<MeshRef> m_DrawMeshes;					 // mesh of every draw
+		std::vector<std::vector<Bvh>> m_MeshBvhs;			 // triangles of every mesh of every model, in model space
+
+		// Every mesh lives in one vertex and one index buffer so a single bind covers all draws
+		Buffer m_VertexBuffer;
+		Buffer m_IndexBuffer;
+
+		// Opaque commands first, then alpha masked ones
+		Buffer m_IndirectBuffer;
+		uint32_t m_OpaqueDrawCount;
+		uint32_t m_DrawCount;
+		std::vector<VkDrawIndexedIndirectCommand> m_Draws;
+		std::vector<ObjectData> m_Objects;
+		std::vector<ObjectBounds> m_Bounds;
+		FrustumCuller m_FrustumCuller;
+		std::vector<ObjectBounds> m_ObjectBounds; // world space box of every object
+		std::vector<uint32_t> m_ObjectDraws;	  // draw of every object
+		Bvh m_Bvh;
+		uint32_t m_PickedObject = UINT32_MAX;
+
+		// Objects and draws written since the last upload, the flags keep each listed once
+		std::vector<uint32_t> m_ChangedObjects;
+		std::vector<uint32_t> m_ChangedDraws;
+		std::vector<uint8_t> m_ObjectChanged;
+		std::vector<uint8_t> m_DrawChanged;
+		std::vector<ObjectBounds> m_MovedBounds;
+		std::vector<Buffer> m_UploadBuffers; // staging, one per frame in flight
+
+		Buffer m_ObjectBuffer;
+		Buffer m_BoundsBuffer; // world space box of each draw covering all its instances, for culling
+		Buffer m_MaterialBuffer;
+		VkDescriptorSetLayout m_DrawDataLayout;
+		VkDescriptorSet m_DrawDataSet;
 
-		std::vector<size_t> m_FrontMeshes;
-		std::vector<size_t> m_BackMeshes;
 		std::vector<Light>  m_Lights;
 		LightBuffer m_LightBuffer;
 		std::vector<Buffer> m_LightUBO;
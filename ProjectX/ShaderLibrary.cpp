@@ -0,0 +1,103 @@
+#include "ShaderLibrary.hpp"
+#include "Context.hpp"
+#include "Utils.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	std::vector<char> ReadSpirv(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open shader file " + path);
+		}
+
+		std::vector<char> code(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(code.data(), code.size());
+
+		return code;
+	}
+
+	// FNV-1a over the whole blob, 64 bits is plenty for the few dozen shaders the engine has
+	uint64_t HashSpirv(const std::vector<char>& code)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (char byte : code)
+		{
+			hash ^= static_cast<uint8_t>(byte);
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+}
+
+vk::ShaderLibrary::ShaderLibrary(Context& context) : context{context}
+{
+	s_Instance = this;
+}
+
+void vk::ShaderLibrary::Destroy()
+{
+	for (auto& [hash, entry] : m_Modules)
+	{
+		vkDestroyShaderModule(context.device, entry.module, nullptr);
+	}
+
+	m_Modules.clear();
+	m_Files.clear();
+
+	if (s_Instance == this)
+	{
+		s_Instance = nullptr;
+	}
+}
+
+VkShaderModule vk::ShaderLibrary::Load(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (auto file = m_Files.find(path); file != m_Files.end())
+		return file->second;
+
+	// Different paths can hold the same SPIR-V (copied or identically compiled shaders), those share a module too
+	std::vector<char> code = ReadSpirv(path);
+	const uint64_t hash = HashSpirv(code);
+
+	VkShaderModule module = VK_NULL_HANDLE;
+	auto [first, last] = m_Modules.equal_range(hash);
+	for (auto existing = first; existing != last; ++existing)
+	{
+		const std::vector<char>& other = existing->second.code;
+		if (other.size() == code.size() && std::memcmp(other.data(), code.data(), code.size()) == 0)
+		{
+			module = existing->second.module;
+			break;
+		}
+	}
+
+	if (module == VK_NULL_HANDLE)
+	{
+		VkShaderModuleCreateInfo createInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+		createInfo.codeSize = code.size();
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+		if (vkCreateShaderModule(context.device, &createInfo, nullptr, &module) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create shader module for " + path);
+		}
+
+		context.SetObjectName(context.device, (uint64_t)module, VK_OBJECT_TYPE_SHADER_MODULE, path.c_str());
+		m_Modules.emplace(hash, Module{ std::move(code), module });
+	}
+
+	m_Files.emplace(path, module);
+	return module;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <volk/volk.h>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Every SPIR-V file is read from disk once and every distinct blob (by content hash) gets a single VkShaderModule,
+// which all pipelines using it share. Modules stay alive until the library is destroyed with the context.
+// There is one per process, PipelineBuilder::AddShader loads through it.
+namespace vk
+{
+	class Context;
+
+	class ShaderLibrary
+	{
+	public:
+		explicit ShaderLibrary(Context& context);
+		void Destroy();
+
+		// Module for the SPIR-V at path, safe to call from any thread
+		VkShaderModule Load(const std::string& path);
+
+		uint32_t GetFileCount() const { return static_cast<uint32_t>(m_Files.size()); }
+		uint32_t GetModuleCount() const { return static_cast<uint32_t>(m_Modules.size()); }
+
+		// The process-wide library, nullptr before the context has created it
+		static ShaderLibrary* Get() { return s_Instance; }
+
+	private:
+		Context& context;
+		std::mutex m_Mutex;
+		std::unordered_map<std::string, VkShaderModule> m_Files;  // path -> module
+
+		// Blobs are kept so a hash hit can be compared byte for byte before its module is reused
+		struct Module
+		{
+			std::vector<char> code;
+			VkShaderModule module;
+		};
+		std::unordered_multimap<uint64_t, Module> m_Modules;      // content hash -> module
+
+		static inline ShaderLibrary* s_Instance = nullptr;
+	};
+}
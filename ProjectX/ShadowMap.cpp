@@ -5,11 +5,21 @@
 #include "baked_model.hpp"
 #include "Utils.hpp"
 #include "Buffer.hpp"
-#include "RenderPass.hpp"
+#include "Rendering.hpp"
 #include "Camera.hpp"
-
-#define USE 1024
-vk::ShadowMap::ShadowMap(Context& context, std::shared_ptr<Scene>& scene) : context{ context }, scene{ scene }
+#include "CullingView.hpp"
+#include "FrustumCuller.hpp"
+#include "Barriers.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <string>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Resolution of each cascade, four of them hold as many texels as the single 1024 map they replaced
+#define USE 512
+vk::ShadowMap::ShadowMap(Context& context, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera) : context{ context }, scene{ scene }, camera{ camera }
 {
 	assert(!scene->GetLights().empty());
 
@@ -17,39 +27,50 @@ vk::ShadowMap::ShadowMap(Context& context, std::shared_ptr<Scene>& scene) : cont
 	m_width = USE;
 	m_height = USE;
 
-	m_ShadowMap = CreateImageTexture2D(
-		"ShadowMap_Depth_RT",
-		context,
-		m_width,
-		m_height,
-		VK_FORMAT_D32_SFLOAT,
-		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_IMAGE_ASPECT_DEPTH_BIT,
-		1
-	);
+	CreateShadowMap();
+
+	for (uint32_t cascade = 0; cascade < MaxShadowCascades; cascade++)
+	{
+		m_CullingViews[cascade] = std::make_unique<CullingView>(context, scene, m_CascadeLayers[cascade], "ShadowCascade" + std::to_string(cascade), true);
+	}
+
+	m_CascadeUBO.resize(MAX_FRAMES_IN_FLIGHT);
+	for (auto& buffer : m_CascadeUBO)
+	{
+		buffer = CreateBuffer("ShadowCascadesUBO", context, sizeof(ShadowCascadesUBO), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+	}
 
 	BuildDescriptors();
-	CreateRenderPass();
-	CreateFramebuffer();
 	CreatePipeline();
 }
 
 vk::ShadowMap::~ShadowMap()
 {
-	m_ShadowMap.Destroy(context.device);
+	DestroyShadowMap();
+
+	for (auto& buffer : m_CascadeUBO)
+	{
+		buffer.Destroy(context.device);
+	}
+
 	vkDestroyPipeline(context.device, m_Pipeline, nullptr);
 	vkDestroyPipelineLayout(context.device, m_PipelineLayout, nullptr);
-
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-	vkDestroyRenderPass(context.device, m_renderPass, nullptr);
 	vkDestroyDescriptorSetLayout(context.device, m_descriptorSetLayout, nullptr);
 }
 
 void vk::ShadowMap::Resize()
 {
-	vkDestroyFramebuffer(context.device, m_framebuffer, nullptr);
-	m_ShadowMap.Destroy(context.device);
+	DestroyShadowMap();
+	CreateShadowMap();
 
+	for (auto& view : m_CullingViews)
+	{
+		view->Resize();
+	}
+}
+
+void vk::ShadowMap::CreateShadowMap()
+{
 	m_ShadowMap = CreateImageTexture2D(
 		"ShadowMap_Depth_RT",
 		context,
@@ -58,29 +79,82 @@ void vk::ShadowMap::Resize()
 		VK_FORMAT_D32_SFLOAT,
 		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		VK_IMAGE_ASPECT_DEPTH_BIT,
-		1
+		1,
+		0,
+		MaxShadowCascades
 	);
 
-	CreateFramebuffer();
+	// Each cascade renders to, and is culled against, its own layer
+	for (uint32_t cascade = 0; cascade < MaxShadowCascades; cascade++)
+	{
+		VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+		viewInfo.image = m_ShadowMap.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_D32_SFLOAT;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, cascade, 1 };
+
+		VkImageView view = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateImageView(context.device, &viewInfo, nullptr, &view), "Failed to create shadow cascade view");
+
+		m_CascadeLayers[cascade] = Image("ShadowCascade" + std::to_string(cascade), m_width, m_height, VK_NULL_HANDLE, m_ShadowMap.image, view, VK_NULL_HANDLE);
+	}
+
+	// Layers of cascades that were never drawn are still in the array the lighting samples, they need its layout as well
+	ExecuteSingleTimeCommands(context, [&](VkCommandBuffer cmd)
+	{
+		BarrierBatch barriers;
+		barriers.Image(m_ShadowMap.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+			VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+			{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, MaxShadowCascades });
+		barriers.Flush(cmd);
+	});
+
+	// New image, nothing drawn into it yet
+	m_Dirty.fill(true);
+}
+
+void vk::ShadowMap::DestroyShadowMap()
+{
+	// The layers only own their view
+	for (auto& layer : m_CascadeLayers)
+	{
+		vkDestroyImageView(context.device, layer.imageView, nullptr);
+		layer.imageView = VK_NULL_HANDLE;
+	}
+
+	m_ShadowMap.Destroy(context.device);
 }
 
 void vk::ShadowMap::Execute(VkCommandBuffer cmd)
 {
+	std::array<uint32_t, MaxShadowCascades> cascades;
+	uint32_t drawnCount = 0;
+	for (uint32_t cascade = 0; cascade < GetCascadeCount(); cascade++)
+	{
+		if (m_Dirty[cascade])
+			cascades[drawnCount++] = cascade;
+	}
+
+	// Cached layers are still in the layout their last draw left them in, which is the one the graph expects after this pass
+	if (drawnCount == 0)
+		return;
 
 #ifdef _DEBUG
 	RenderPassLabel(cmd, "ShadowMap");
 #endif
 
-	VkRenderPassBeginInfo beginInfo = {};
-	beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	beginInfo.renderPass = m_renderPass;
-	beginInfo.framebuffer = m_framebuffer;
-	beginInfo.renderArea.extent = { m_width, m_height };
+	for (uint32_t i = 0; i < drawnCount; i++)
+	{
+		m_CullingViews[cascades[i]]->CullEarly(cmd, m_Cascades.viewProjections[cascades[i]]);
+	}
 
-	VkClearValue clearValues[1];
-	clearValues[0].depthStencil.depth = { 1.0f };
-	beginInfo.clearValueCount = 1;
-	beginInfo.pClearValues = clearValues;
+	BarrierBatch barriers;
+	for (uint32_t i = 0; i < drawnCount; i++)
+	{
+		BeginDepthTarget(barriers, m_ShadowMap.image, cascades[i]);
+	}
+	barriers.Flush(cmd);
 
 	VkViewport viewport{};
 	viewport.x = 0.0f;
@@ -96,109 +170,214 @@ void vk::ShadowMap::Execute(VkCommandBuffer cmd)
 	scissor.extent = { m_width, m_height };
 	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	vkCmdBeginRenderPass(cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
 	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
-	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_descriptorSets[currentFrame], 0, nullptr);
+	// Only the vertex shader's object lookup uses set 2, set 1 keeps the layout compatible with the textured passes
+	VkDescriptorSet sets[] = { m_descriptorSets[currentFrame], context.bindlessTextures->GetSet(), scene->GetDrawDataSet() };
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 3, sets, 0, nullptr);
+
+	for (uint32_t i = 0; i < drawnCount; i++)
+	{
+		DrawCascade(cmd, cascades[i], false);
+	}
+
+	// Occluders drawn so far decide what else each cascade can see
+	for (uint32_t i = 0; i < drawnCount; i++)
+	{
+		EndDepthTarget(barriers, m_ShadowMap.image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, cascades[i]);
+	}
+	barriers.Flush(cmd);
 
-	// Draw front freshes
-	scene->RenderFrontMeshes(cmd, m_PipelineLayout);
-	scene->RenderBackMeshes(cmd, m_PipelineLayout);
+	for (uint32_t i = 0; i < drawnCount; i++)
+	{
+		m_CullingViews[cascades[i]]->CullLate(cmd);
+		ResumeDepthTarget(barriers, m_ShadowMap.image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, cascades[i]);
+	}
+	barriers.Flush(cmd);
 
-	vkCmdEndRenderPass(cmd);
+	for (uint32_t i = 0; i < drawnCount; i++)
+	{
+		DrawCascade(cmd, cascades[i], true);
+	}
+
+	// Sampled by the lighting passes
+	for (uint32_t i = 0; i < drawnCount; i++)
+	{
+		EndDepthTarget(barriers, m_ShadowMap.image, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT, cascades[i]);
+		m_Dirty[cascades[i]] = false;
+	}
+	barriers.Flush(cmd);
 
 #ifdef _DEBUG
 	EndRenderPassLabel(cmd);
 #endif
 }
 
+void vk::ShadowMap::DrawCascade(VkCommandBuffer cmd, uint32_t cascade, bool late)
+{
+	RenderingInfo rendering({ m_width, m_height });
+	rendering.SetDepthAttachment(m_CascadeLayers[cascade].imageView, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+		late ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE);
+
+	vkCmdPushConstants(cmd, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &cascade);
+
+	rendering.Begin(cmd);
+	m_CullingViews[cascade]->Draw(cmd, Scene::DrawFilter::All, late ? CullingView::Phase::Late : CullingView::Phase::Early);
+	vkCmdEndRendering(cmd);
+}
+
 void vk::ShadowMap::CreatePipeline()
 {
-	VkPushConstantRange pushConstantRange = {
-		.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_GEOMETRY_BIT,
-		.offset = 0,
-		.size = sizeof(MeshPushConstants)
-	};
+	// The vertex shader picks its cascade's matrix by index
+	const VkPushConstantRange cascadeConstant = { VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t) };
 
 	// Default pipeline
-	auto ShadowMapPipelineRes = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
 		.AddShader("../Engine/assets/shaders/shadow_map.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/shadow_map.frag.spv", ShaderType::FRAGMENT)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
 		.SetDynamicState({ {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR} })
 		.SetRasterizationState(VK_POLYGON_MODE_FILL, VK_CULL_MODE_FRONT_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
-		.SetPipelineLayout({ {m_descriptorSetLayout} }, pushConstantRange)
+		.SetPipelineLayout({ m_descriptorSetLayout, context.bindlessTextures->GetLayout(), scene->GetDrawDataLayout() }, cascadeConstant)
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
-		.AddBlendAttachmentState()
 		.SetDepthState(VK_TRUE, VK_TRUE, VK_COMPARE_OP_LESS_OR_EQUAL)
-		.SetRenderPass(m_renderPass)
-		.Build();
-
-	m_Pipeline = ShadowMapPipelineRes.first;
-	m_PipelineLayout = ShadowMapPipelineRes.second;
-}
-
-void vk::ShadowMap::CreateRenderPass()
-{
-	RenderPass builder(context.device, 1);
-
-	m_renderPass = builder
-		.AddAttachment(VK_FORMAT_D32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL)
-		.SetDepthAttachmentRef(0, 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-
-		// External -> 0 : Depth ( Wait for previous depth writes to finish before writing )
-		.AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-		// 0 -> External : Depth ( Wait for depth to finish writing in this render pass before allowing other render passes to try and sample from it )
-		.AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-		.Build();
-}
-
-void vk::ShadowMap::CreateFramebuffer()
-{
-	// Framebuffer
-	std::vector<VkImageView> attachments = {
-		m_ShadowMap.imageView
-	};
-	VkFramebufferCreateInfo fbcInfo = {
-		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-		.renderPass = m_renderPass,
-		.attachmentCount = static_cast<uint32_t>(attachments.size()),
-		.pAttachments = attachments.data(),
-		.width = m_width,
-		.height = m_height,
-		.layers = 1
-	};
-
-	VK_CHECK(vkCreateFramebuffer(context.device, &fbcInfo, nullptr, &m_framebuffer), "Failed to create Forward pass framebuffer.");
+		.SetRenderingFormats({}, VK_FORMAT_D32_SFLOAT)
+		.BuildDeferred(m_Pipeline, m_PipelineLayout);
 }
 
 void vk::ShadowMap::BuildDescriptors()
 {
 	m_descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
 	{
-		// Light UBO
+		// Cascades UBO
 		std::vector<VkDescriptorSetLayoutBinding> bindings = {
-			CreateDescriptorBinding(0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT), // SceneUBO (projection, view etc..)
+			CreateDescriptorBinding(0, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT),
 		};
 
 		m_descriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
-		AllocateDescriptorSets(context, context.descriptorPool, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
+		AllocateDescriptorSets(context, m_descriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
 	}
 
-	// Camera Transform UBO
 	for (size_t i = 0; i < (size_t)MAX_FRAMES_IN_FLIGHT; i++)
 	{
 		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = scene->GetLightsUBO()[i].buffer;
+		bufferInfo.buffer = m_CascadeUBO[i].buffer;
 		bufferInfo.offset = 0;
-		bufferInfo.range = sizeof(LightUBO);
+		bufferInfo.range = sizeof(ShadowCascadesUBO);
 		UpdateDescriptorSet(context, 0, bufferInfo, m_descriptorSets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 	}
 }
 
-void vk::ShadowMap::Update()
+void vk::ShadowMap::UpdateCascades()
 {
+	const CameraTransform& transform = camera->GetCameraTransform();
+	const uint32_t count = static_cast<uint32_t>(std::clamp(shadowSettings.CascadeCount, 1, static_cast<int>(MaxShadowCascades)));
+	const float nearPlane = transform.nearPlane;
+	const float farPlane = std::clamp(shadowSettings.Distance, nearPlane + 0.01f, transform.farPlane);
+
+	// Practical split scheme: logarithmic splits keep the texel to pixel ratio even, uniform ones stop the near cascades
+	// from getting too thin, the lambda blends the two
+	m_Cascades.count = static_cast<int>(count);
+	m_Cascades.depthBias = shadowSettings.DepthBias;
+	m_Cascades.splits = glm::vec4(farPlane);
+	for (uint32_t cascade = 0; cascade < count; cascade++)
+	{
+		const float t = static_cast<float>(cascade + 1) / static_cast<float>(count);
+		const float logarithmic = nearPlane * std::pow(farPlane / nearPlane, t);
+		const float uniform = nearPlane + (farPlane - nearPlane) * t;
+		m_Cascades.splits[cascade] = glm::mix(uniform, logarithmic, shadowSettings.SplitLambda);
+	}
+
+	// The light only rotates the world, the cascades are boxes of that space. Their depth covers the whole scene so
+	// casters between the light and the camera's frustum aren't clipped.
+	const glm::vec3 direction = glm::normalize(-glm::vec3(scene->GetLights()[0].position));
+	const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
 
+	const ObjectBounds sceneBounds = scene->GetBvh().GetBounds();
+	float minZ = FLT_MAX;
+	float maxZ = -FLT_MAX;
+	for (uint32_t corner = 0; corner < 8; corner++)
+	{
+		const glm::vec4 point(
+			(corner & 1) ? sceneBounds.max.x : sceneBounds.min.x,
+			(corner & 2) ? sceneBounds.max.y : sceneBounds.min.y,
+			(corner & 4) ? sceneBounds.max.z : sceneBounds.min.z,
+			1.0f);
+		const float z = (lightView * point).z;
+		minZ = std::min(minZ, z);
+		maxZ = std::max(maxZ, z);
+	}
+	const float zPadding = 0.01f * (maxZ - minZ) + 0.01f;
+
+	// Squared slopes of the frustum's corner rays, from the projection so it matches what the camera draws
+	const float slope = 1.0f / (transform.projection[0][0] * transform.projection[0][0]) + 1.0f / (transform.projection[1][1] * transform.projection[1][1]);
+	const glm::mat4 cameraToWorld = glm::inverse(transform.view);
+	const glm::vec3 eye = glm::vec3(cameraToWorld[3]);
+	const glm::vec3 forward = -glm::normalize(glm::vec3(cameraToWorld[2]));
+
+	for (uint32_t cascade = 0; cascade < count; cascade++)
+	{
+		const float sliceNear = cascade == 0 ? nearPlane : m_Cascades.splits[cascade - 1];
+		const float sliceFar = m_Cascades.splits[cascade];
+
+		// Smallest sphere around the slice, centered on the view axis as far from the near corners as from the far ones.
+		// It only depends on the split depths, not on where the camera looks, so the cascade's size never changes.
+		float center = 0.5f * (sliceNear + sliceFar) * (1.0f + slope);
+		float radius = 0.0f;
+		if (center >= sliceFar)
+		{
+			center = sliceFar;
+			radius = sliceFar * std::sqrt(slope);
+		}
+		else
+		{
+			radius = std::sqrt(sliceFar * sliceFar * slope + (sliceFar - center) * (sliceFar - center));
+		}
+
+		// Moving in whole texels keeps the shadow edges from crawling as the camera moves
+		const float texelSize = 2.0f * radius / static_cast<float>(m_width);
+		glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(eye + forward * center, 1.0f));
+		lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+		lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+
+		const glm::mat4 projection = glm::orthoRH_ZO(
+			lightCenter.x - radius, lightCenter.x + radius,
+			lightCenter.y - radius, lightCenter.y + radius,
+			-maxZ - zPadding, -minZ + zPadding);
+
+		m_Cascades.viewProjections[cascade] = projection * lightView;
+	}
 }
 
+void vk::ShadowMap::Update()
+{
+	UpdateCascades();
+	m_CascadeUBO[currentFrame].WriteToBuffer(m_Cascades, sizeof(ShadowCascadesUBO));
+
+	// A cascade stays dirty until a frame actually draws it, a frame dropped for a resize doesn't lose the change
+	const std::vector<ObjectBounds>& moved = scene->GetMovedBounds();
+	for (uint32_t cascade = 0; cascade < MaxShadowCascades; cascade++)
+	{
+		// Unused layers are forgotten, whatever moved meanwhile isn't in them
+		if (cascade >= GetCascadeCount())
+		{
+			m_DrawnMatrices[cascade] = glm::mat4(0.0f);
+			continue;
+		}
+
+		const glm::mat4& viewProjection = m_Cascades.viewProjections[cascade];
+		if (!cacheShadowMap || viewProjection != m_DrawnMatrices[cascade])
+		{
+			m_DrawnMatrices[cascade] = viewProjection;
+			m_Dirty[cascade] = true;
+			continue;
+		}
+
+		// An object entering or leaving the cascade's volume changes it as much as one moving inside it
+		if (m_Dirty[cascade] || moved.empty())
+			continue;
+
+		const std::array<glm::vec4, 6> planes = ExtractFrustumPlanes(viewProjection);
+		m_Dirty[cascade] = std::any_of(moved.begin(), moved.end(), [&](const ObjectBounds& bounds) { return IntersectsFrustum(planes, bounds); });
+	}
+}
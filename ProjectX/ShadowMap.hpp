@@ -1,46 +1,68 @@
 #pragma once
 #include <volk/volk.h>
+#include <array>
 #include <memory>
 #include <unordered_map>
 #include "Camera.hpp"
 
+// Cascaded shadow map of the directional light. The camera's view depth up to shadowSettings.Distance is split into
+// cascades, each fitted with a bounding sphere of its slice of the camera frustum and snapped to whole texels so the
+// projection only moves in texel steps. Every cascade is a layer of one texture array with its own culling view.
 namespace vk
 {
 	class Context;
 	class Scene;
 	class Buffer;
+	class CullingView;
 
 	class ShadowMap
 	{
 	public:
-		
-		ShadowMap(Context& context, std::shared_ptr<Scene>& scene);
+
+		ShadowMap(Context& context, std::shared_ptr<Scene>& scene, std::shared_ptr<Camera>& camera);
 		~ShadowMap();
 		void Execute(VkCommandBuffer cmd);
 		void Update();
 		void Resize();
 
+		// Whether Execute draws the cascade this frame, a cached one is left as it is
+		bool IsDirty(uint32_t cascade) const { return m_Dirty[cascade]; }
+
 		Image& GetRenderTarget() { return m_ShadowMap; }
+		std::vector<Buffer>& GetCascadeBuffers() { return m_CascadeUBO; }
+
+		uint32_t		 GetCascadeCount() const { return static_cast<uint32_t>(m_Cascades.count); }
+		const glm::mat4& GetCascadeMatrix(uint32_t cascade) const { return m_Cascades.viewProjections[cascade]; }
+		CullingView&	 GetCullingView(uint32_t cascade) { return *m_CullingViews[cascade]; }
 
 	private:
+		void CreateShadowMap();
+		void DestroyShadowMap();
+		void UpdateCascades();
+		// One phase of a cascade's draws into its layer, the early phase clears it
+		void DrawCascade(VkCommandBuffer cmd, uint32_t cascade, bool late);
 		void CreatePipeline();
-		void CreateRenderPass();
-		void CreateFramebuffer();
 		void BuildDescriptors();
 
-		VkRenderPass m_renderPass;
-		VkFramebuffer m_framebuffer;
-
 		Context& context;
-		Image m_ShadowMap;
+		Image m_ShadowMap; // one layer per cascade, sampled through the array view
+		std::array<Image, MaxShadowCascades> m_CascadeLayers; // single layer views of m_ShadowMap, the image isn't theirs
 		uint32_t m_width;
 		uint32_t m_height;
 
 		std::shared_ptr<Scene> scene;
+		std::shared_ptr<Camera> camera;
+		std::array<std::unique_ptr<CullingView>, MaxShadowCascades> m_CullingViews; // what each cascade sees
+		std::vector<Buffer> m_CascadeUBO;
 		std::vector<VkDescriptorSet> m_descriptorSets;
 		VkDescriptorSetLayout m_descriptorSetLayout;
 
 		VkPipeline m_Pipeline;
 		VkPipelineLayout m_PipelineLayout;
+
+		// A cascade stays valid until its projection or a caster in its volume changes
+		ShadowCascadesUBO m_Cascades{};
+		std::array<glm::mat4, MaxShadowCascades> m_DrawnMatrices{};
+		std::array<bool, MaxShadowCascades> m_Dirty{};
 	};
-}
\ No newline at end of file
+}
@@ -2,11 +2,10 @@
 #include "Skybox.hpp"
 #include "Utils.hpp"
 #include "Pipeline.hpp"
-#include "RenderPass.hpp"
 #include <stb_image.h>
 
-vk::Skybox::Skybox(Context& context, const Image& depthBuffer, std::shared_ptr<Camera> camera, VkRenderPass renderpass) :
-	context{context}, depthBuffer{depthBuffer}, camera{camera}, m_RenderPass{renderpass}
+vk::Skybox::Skybox(Context& context, const Image& depthBuffer, std::shared_ptr<Camera> camera, VkFormat colorFormat) :
+	context{context}, depthBuffer{depthBuffer}, camera{camera}, m_ColorFormat{colorFormat}
 {
 	// When transitioning this image, the subresource in subresourceRange needs to be set to 6
 	// to transition all layers of the imag, otherwise you transition only the first
@@ -166,7 +165,7 @@ void vk::Skybox::CreatePipeline()
 		.size = sizeof(MeshPushConstants)
 	};
 
-	auto skyboxPiplineRes = vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
+	vk::PipelineBuilder(context.device, PipelineType::GRAPHICS, VertexBinding::BIND, 0)
 		.AddShader("../Engine/assets/shaders/skybox.vert.spv", ShaderType::VERTEX)
 		.AddShader("../Engine/assets/shaders/skybox.frag.spv", ShaderType::FRAGMENT)
 		.SetInputAssembly(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
@@ -176,11 +175,8 @@ void vk::Skybox::CreatePipeline()
 		.SetSampling(VK_SAMPLE_COUNT_1_BIT)
 		.AddBlendAttachmentState()
 		.SetDepthState(VK_TRUE, VK_FALSE, VK_COMPARE_OP_LESS_OR_EQUAL)
-		.SetRenderPass(m_RenderPass)
-		.Build();
-
-	m_Pipeline = skyboxPiplineRes.first;
-	m_PipelineLayout = skyboxPiplineRes.second;
+		.SetRenderingFormats({ m_ColorFormat }, VK_FORMAT_D32_SFLOAT)
+		.BuildDeferred(m_Pipeline, m_PipelineLayout);
 }
 
 void vk::Skybox::BuildDescriptors()
@@ -195,7 +191,7 @@ void vk::Skybox::BuildDescriptors()
 
 		m_DescriptorSetLayout = CreateDescriptorSetLayout(context, bindings);
 
-		AllocateDescriptorSets(context, context.descriptorPool, m_DescriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
+		AllocateDescriptorSets(context, m_DescriptorSetLayout, MAX_FRAMES_IN_FLIGHT, m_descriptorSets);
 	}
 
 	// Camera Transform UBO
@@ -237,22 +233,3 @@ void vk::Skybox::LoadCubemapFace(const std::string facePath, char** pixelData)
 	*pixelData = reinterpret_cast<char*>(pixels);
 }
 
-
-void vk::Skybox::CreateRenderPass()
-{
-	RenderPass builder(context.device, 1);
-
-	m_RenderPass = builder
-		.AddAttachment(VK_FORMAT_R8G8B8A8_SRGB, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-		.AddColorAttachmentRef(0, 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
-
-		// External -> 0 : Color
-		.AddDependency(VK_SUBPASS_EXTERNAL, 0, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-
-		// 0 -> External : Color : Wait for color writing to finish on the attachment before the fragment shader tries to read from it
-		.AddDependency(0, VK_SUBPASS_EXTERNAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_DEPENDENCY_BY_REGION_BIT)
-		.Build();
-
-	context.SetObjectName(context.device, (uint64_t)m_RenderPass, VK_OBJECT_TYPE_RENDER_PASS, "SkyboxRenderPass");
-}
-
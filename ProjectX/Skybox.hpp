@@ -11,7 +11,7 @@ namespace vk
 	class Skybox
 	{
 	public:
-		Skybox(Context& context, const Image& depthBuffer, std::shared_ptr<Camera> camera, VkRenderPass renderpass);
+		Skybox(Context& context, const Image& depthBuffer, std::shared_ptr<Camera> camera, VkFormat colorFormat);
 		~Skybox();
 
 		void Execute(VkCommandBuffer cmd);
@@ -21,8 +21,6 @@ namespace vk
 
         void CreatePipeline();
         void BuildDescriptors();
-        void CreateRenderPass();
-        void CreateFramebuffer();
 		void LoadCubemapFace(const std::string facePath, char** pixelData);
 
 		Context& context;
@@ -34,8 +32,7 @@ namespace vk
 
         VkPipeline m_Pipeline;
         VkPipelineLayout m_PipelineLayout;
-        VkRenderPass m_RenderPass;
-        VkFramebuffer m_Framebuffer;
+        VkFormat m_ColorFormat; // of the pass it's drawn in
         VkDescriptorSetLayout m_DescriptorSetLayout;
         std::vector<VkDescriptorSet> m_descriptorSets;
 
@@ -0,0 +1,100 @@
+#include "Timeline.hpp"
+#include "Context.hpp"
+#include "Utils.hpp"
+
+#include <stdexcept>
+
+vk::Timeline::Timeline(Context& context, const char* name) : context{context}, m_Semaphore{VK_NULL_HANDLE}, m_Value{0}
+{
+	VkSemaphoreTypeCreateInfo typeInfo = {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+		.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+		.initialValue = 0
+	};
+
+	VkSemaphoreCreateInfo semaphoreInfo = {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+		.pNext = &typeInfo
+	};
+
+	VK_CHECK(vkCreateSemaphore(context.device, &semaphoreInfo, nullptr, &m_Semaphore), "Failed to create timeline semaphore");
+	context.SetObjectName(context.device, (uint64_t)m_Semaphore, VK_OBJECT_TYPE_SEMAPHORE, name);
+}
+
+void vk::Timeline::Destroy()
+{
+	vkDestroySemaphore(context.device, m_Semaphore, nullptr);
+	m_Semaphore = VK_NULL_HANDLE;
+}
+
+uint64_t vk::Timeline::Submit(VkQueue queue, const std::vector<VkCommandBuffer>& commandBuffers, const std::vector<Wait>& waits,
+	const std::vector<VkSemaphore>& binaryWaits, const std::vector<VkPipelineStageFlags>& binaryWaitStages, const std::vector<VkSemaphore>& binarySignals)
+{
+	// Values have to be signalled in increasing order, submissions to the queue must go through here one at a time
+	const uint64_t value = ++m_Value;
+
+	// Binary semaphores take a value of 0 in the value arrays, it is ignored
+	std::vector<VkSemaphore> waitSemaphores = binaryWaits;
+	std::vector<VkPipelineStageFlags> waitStages = binaryWaitStages;
+	std::vector<uint64_t> waitValues(binaryWaits.size(), 0);
+
+	for (const auto& wait : waits)
+	{
+		waitSemaphores.push_back(wait.timeline->GetSemaphore());
+		waitStages.push_back(wait.stages);
+		waitValues.push_back(wait.value);
+	}
+
+	std::vector<VkSemaphore> signalSemaphores = binarySignals;
+	std::vector<uint64_t> signalValues(binarySignals.size(), 0);
+	signalSemaphores.push_back(m_Semaphore);
+	signalValues.push_back(value);
+
+	VkTimelineSemaphoreSubmitInfo timelineInfo = {
+		.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+		.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size()),
+		.pWaitSemaphoreValues = waitValues.data(),
+		.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size()),
+		.pSignalSemaphoreValues = signalValues.data()
+	};
+
+	VkSubmitInfo submitInfo = {
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.pNext = &timelineInfo,
+		.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size()),
+		.pWaitSemaphores = waitSemaphores.data(),
+		.pWaitDstStageMask = waitStages.data(),
+		.commandBufferCount = static_cast<uint32_t>(commandBuffers.size()),
+		.pCommandBuffers = commandBuffers.data(),
+		.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size()),
+		.pSignalSemaphores = signalSemaphores.data()
+	};
+
+	VkResult result = vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
+
+	if (result != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to submit command buffers");
+	}
+
+	return value;
+}
+
+void vk::Timeline::WaitFor(uint64_t value) const
+{
+	VkSemaphoreWaitInfo waitInfo = {
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		.semaphoreCount = 1,
+		.pSemaphores = &m_Semaphore,
+		.pValues = &value
+	};
+
+	VK_CHECK(vkWaitSemaphores(context.device, &waitInfo, UINT64_MAX), "Failed to wait for timeline semaphore");
+}
+
+uint64_t vk::Timeline::GetCompletedValue() const
+{
+	uint64_t value = 0;
+	VK_CHECK(vkGetSemaphoreCounterValue(context.device, m_Semaphore, &value), "Failed to read timeline semaphore value");
+	return value;
+}
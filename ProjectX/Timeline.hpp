@@ -0,0 +1,44 @@
+#pragma once
+#include <volk/volk.h>
+#include <vector>
+
+// Timeline semaphore for one queue. Every submission to the queue signals the next value, the CPU waits for a value
+// instead of a fence and resources can be retired as soon as the value of the last submission using them has completed.
+namespace vk
+{
+	class Context;
+
+	class Timeline
+	{
+	public:
+		// Submission to another queue's timeline the work has to wait for
+		struct Wait
+		{
+			const Timeline* timeline;
+			uint64_t value;
+			VkPipelineStageFlags stages;
+		};
+
+		Timeline(Context& context, const char* name);
+		void Destroy();
+
+		// Submits the command buffers to the queue and signals the next value, which is returned.
+		// Binary semaphores (swapchain acquire/present) can be waited on and signalled alongside.
+		uint64_t Submit(VkQueue queue, const std::vector<VkCommandBuffer>& commandBuffers,
+			const std::vector<Wait>& waits = {},
+			const std::vector<VkSemaphore>& binaryWaits = {}, const std::vector<VkPipelineStageFlags>& binaryWaitStages = {},
+			const std::vector<VkSemaphore>& binarySignals = {});
+
+		// Blocks the CPU until the GPU has reached value
+		void WaitFor(uint64_t value) const;
+
+		uint64_t GetCompletedValue() const;
+		uint64_t GetSubmittedValue() const { return m_Value; }
+		VkSemaphore GetSemaphore() const { return m_Semaphore; }
+
+	private:
+		Context& context;
+		VkSemaphore m_Semaphore;
+		uint64_t m_Value;
+	};
+}
@@ -0,0 +1,239 @@
+#include "Context.hpp"
+#include "TransientAllocator.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace
+{
+	VkImageCreateInfo MakeImageInfo(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage)
+	{
+		VkImageCreateInfo imageInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = { width, height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		return imageInfo;
+	}
+
+	VkImageView CreateView(vk::Context& context, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, const std::string& name)
+	{
+		VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+		viewInfo.image = image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = format;
+		viewInfo.components = VkComponentMapping{};
+		viewInfo.subresourceRange = VkImageSubresourceRange{ aspectFlags, 0, 1, 0, 1 };
+
+		VkImageView imageView = VK_NULL_HANDLE;
+		VK_CHECK(vkCreateImageView(context.device, &viewInfo, nullptr, &imageView), "Failed to create transient image view");
+
+		context.SetObjectName(context.device, (uint64_t)imageView, VK_OBJECT_TYPE_IMAGE_VIEW, name.c_str());
+
+		return imageView;
+	}
+}
+
+vk::TransientAllocator::TransientAllocator(Context& context) :
+	context{context},
+	m_SupportsLazyMemory{false},
+	m_RequestedBytes{0},
+	m_AllocatedBytes{0}
+{
+	const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+	vmaGetMemoryProperties(context.allocator, &memoryProperties);
+
+	for (uint32_t i = 0; i < memoryProperties->memoryTypeCount; i++)
+	{
+		if (memoryProperties->memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+		{
+			m_SupportsLazyMemory = true;
+			break;
+		}
+	}
+}
+
+vk::TransientAllocator::~TransientAllocator()
+{
+	// Every image should have been destroyed by its pass by now
+	assert(std::all_of(m_Blocks.begin(), m_Blocks.end(), [](const Block& block) { return block.occupants.empty(); }));
+
+	for (auto& block : m_Blocks)
+	{
+		vmaFreeMemory(context.allocator, block.allocation);
+	}
+}
+
+void vk::TransientAllocator::SetPassOrder(const std::vector<std::string>& passes)
+{
+	m_PassIndices.clear();
+	for (uint32_t i = 0; i < static_cast<uint32_t>(passes.size()); i++)
+	{
+		m_PassIndices[passes[i]] = i;
+	}
+
+	m_Lifetimes.clear();
+}
+
+void vk::TransientAllocator::AddUsage(const std::string& imageName, const std::string& passName)
+{
+	auto pass = m_PassIndices.find(passName);
+	if (pass == m_PassIndices.end())
+	{
+		throw std::runtime_error("Transient usage declared for unknown pass: " + passName);
+	}
+
+	const uint32_t index = pass->second;
+
+	auto lifetime = m_Lifetimes.find(imageName);
+	if (lifetime == m_Lifetimes.end())
+	{
+		m_Lifetimes[imageName] = TransientLifetime{ index, index };
+		return;
+	}
+
+	lifetime->second.firstPass = std::min(lifetime->second.firstPass, index);
+	lifetime->second.lastPass  = std::max(lifetime->second.lastPass, index);
+}
+
+void vk::TransientAllocator::ClearUsages()
+{
+	m_Lifetimes.clear();
+}
+
+vk::Image vk::TransientAllocator::CreateImage(const std::string& name, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspectFlags)
+{
+	auto lifetime = m_Lifetimes.find(name);
+	if (lifetime == m_Lifetimes.end())
+	{
+		return CreateImageTexture2D(name, context, width, height, format, usage, aspectFlags, 1);
+	}
+
+	VkImageCreateInfo imageInfo = MakeImageInfo(width, height, format, usage);
+
+	VkImage image = VK_NULL_HANDLE;
+	VK_CHECK(vkCreateImage(context.device, &imageInfo, nullptr, &image), "Failed to create transient image");
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(context.device, image, &requirements);
+
+	Block* block = FindBlock(requirements, lifetime->second);
+	if (block == nullptr)
+	{
+		block = AllocateBlock(requirements, name);
+	}
+
+	VK_CHECK(vmaBindImageMemory(context.allocator, block->allocation, image), "Failed to bind transient image memory");
+	block->occupants.push_back(Occupant{ image, requirements.size, lifetime->second });
+	m_RequestedBytes += requirements.size;
+
+	context.SetObjectName(context.device, (uint64_t)image, VK_OBJECT_TYPE_IMAGE, name.c_str());
+
+	VkImageView imageView = CreateView(context, image, format, aspectFlags, name);
+
+	Image result(name, width, height, context.allocator, image, imageView, block->allocation);
+	result.transientAllocator = this;
+
+	return result;
+}
+
+vk::Image vk::TransientAllocator::CreateTileImage(const std::string& name, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspectFlags)
+{
+	if (!m_SupportsLazyMemory)
+	{
+		return CreateImageTexture2D(name, context, width, height, format, usage, aspectFlags, 1);
+	}
+
+	VkImageCreateInfo imageInfo = MakeImageInfo(width, height, format, usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT);
+
+	VmaAllocationCreateInfo allocInfo{};
+	allocInfo.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+
+	VkImage image = VK_NULL_HANDLE;
+	VmaAllocation allocation = VK_NULL_HANDLE;
+	VK_CHECK(vmaCreateImage(context.allocator, &imageInfo, &allocInfo, &image, &allocation, nullptr), "Failed to allocate lazily allocated image");
+
+	context.SetObjectName(context.device, (uint64_t)image, VK_OBJECT_TYPE_IMAGE, name.c_str());
+	vmaSetAllocationName(context.allocator, allocation, name.c_str());
+
+	VkImageView imageView = CreateView(context, image, format, aspectFlags, name);
+
+	return Image(name, width, height, context.allocator, image, imageView, allocation);
+}
+
+void vk::TransientAllocator::Release(VkImage image)
+{
+	for (auto block = m_Blocks.begin(); block != m_Blocks.end(); ++block)
+	{
+		auto occupant = std::find_if(block->occupants.begin(), block->occupants.end(), [image](const Occupant& o) { return o.image == image; });
+		if (occupant == block->occupants.end())
+			continue;
+
+		m_RequestedBytes -= occupant->size;
+		block->occupants.erase(occupant);
+
+		if (block->occupants.empty())
+		{
+			m_AllocatedBytes -= block->size;
+			vmaFreeMemory(context.allocator, block->allocation);
+			m_Blocks.erase(block);
+		}
+
+		return;
+	}
+}
+
+vk::TransientAllocator::Block* vk::TransientAllocator::FindBlock(const VkMemoryRequirements& requirements, const TransientLifetime& lifetime)
+{
+	Block* best = nullptr;
+
+	for (auto& block : m_Blocks)
+	{
+		if (block.size < requirements.size)
+			continue;
+
+		if ((requirements.memoryTypeBits & (1u << block.memoryTypeIndex)) == 0)
+			continue;
+
+		if (block.offset % requirements.alignment != 0)
+			continue;
+
+		const bool overlaps = std::any_of(block.occupants.begin(), block.occupants.end(), [&](const Occupant& o) { return o.lifetime.Overlaps(lifetime); });
+		if (overlaps)
+			continue;
+
+		// Prefer the smallest block that fits so large blocks stay free for large targets
+		if (best == nullptr || block.size < best->size)
+		{
+			best = &block;
+		}
+	}
+
+	return best;
+}
+
+vk::TransientAllocator::Block* vk::TransientAllocator::AllocateBlock(const VkMemoryRequirements& requirements, const std::string& name)
+{
+	VmaAllocationCreateInfo allocInfo{};
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+	VmaAllocation allocation = VK_NULL_HANDLE;
+	VmaAllocationInfo info{};
+	VK_CHECK(vmaAllocateMemory(context.allocator, &requirements, &allocInfo, &allocation, &info), "Failed to allocate transient memory block");
+
+	vmaSetAllocationName(context.allocator, allocation, ("Transient_" + name).c_str());
+
+	m_AllocatedBytes += requirements.size;
+	m_Blocks.push_back(Block{ allocation, requirements.size, info.offset, info.memoryType, {} });
+
+	return &m_Blocks.back();
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <volk/volk.h>
+#include <vk_mem_alloc.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Image.hpp"
+
+// Transient render targets only live between the first pass that writes them and the last pass that reads them.
+// Targets whose lifetimes don't overlap are placed on the same memory block, so the frame only pays for the
+// peak number of live targets rather than the sum of all of them.
+namespace vk
+{
+	class Context;
+
+	// Inclusive range of pass indices an image is alive for
+	struct TransientLifetime
+	{
+		uint32_t firstPass;
+		uint32_t lastPass;
+
+		bool Overlaps(const TransientLifetime& other) const { return firstPass <= other.lastPass && other.firstPass <= lastPass; }
+	};
+
+	class TransientAllocator
+	{
+	public:
+		explicit TransientAllocator(Context& context);
+		~TransientAllocator();
+
+		TransientAllocator(const TransientAllocator&) = delete;
+		TransientAllocator& operator=(const TransientAllocator&) = delete;
+
+		// Order the passes execute in, lifetimes are computed from the index of each pass in this list
+		void SetPassOrder(const std::vector<std::string>& passes);
+
+		// Declare that a pass writes or reads the named image
+		void AddUsage(const std::string& imageName, const std::string& passName);
+		void ClearUsages();
+
+		// Images with declared usages are aliased with any other image they don't overlap with.
+		// Images without any usages fall back to a dedicated allocation.
+		Image CreateImage(const std::string& name, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspectFlags);
+
+		// Attachments which are cleared and discarded within a single render pass never have to leave tile memory.
+		// Uses lazily allocated memory where the device supports it.
+		Image CreateTileImage(const std::string& name, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspectFlags);
+
+		// Called by Image::Destroy on aliased images, frees the block once nothing else lives in it
+		void Release(VkImage image);
+
+		bool HasLifetime(const std::string& imageName) const { return m_Lifetimes.find(imageName) != m_Lifetimes.end(); }
+		TransientLifetime GetLifetime(const std::string& imageName) const { return m_Lifetimes.at(imageName); }
+
+		VkDeviceSize GetRequestedBytes() const { return m_RequestedBytes; }
+		VkDeviceSize GetAllocatedBytes() const { return m_AllocatedBytes; }
+
+	private:
+		struct Occupant
+		{
+			VkImage image;
+			VkDeviceSize size;
+			TransientLifetime lifetime;
+		};
+
+		struct Block
+		{
+			VmaAllocation allocation;
+			VkDeviceSize size;
+			VkDeviceSize offset;
+			uint32_t memoryTypeIndex;
+			std::vector<Occupant> occupants;
+		};
+
+		Block* FindBlock(const VkMemoryRequirements& requirements, const TransientLifetime& lifetime);
+		Block* AllocateBlock(const VkMemoryRequirements& requirements, const std::string& name);
+
+		Context& context;
+		std::unordered_map<std::string, uint32_t> m_PassIndices;
+		std::unordered_map<std::string, TransientLifetime> m_Lifetimes;
+		std::vector<Block> m_Blocks;
+
+		bool m_SupportsLazyMemory;
+		VkDeviceSize m_RequestedBytes;
+		VkDeviceSize m_AllocatedBytes;
+	};
+}
@@ -1,5 +1,6 @@
 #include "Context.hpp"
 #include "Utils.hpp"
+#include "Barriers.hpp"
 
 namespace vk
 {
@@ -23,34 +24,15 @@ void vk::ExecuteSingleTimeCommands(Context& context, std::function<void(VkComman
 		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
 	};
 
-	// Create the fence
-	VkFenceCreateInfo fenceInfo{
-		.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-		.flags = VK_FENCE_CREATE_SIGNALED_BIT
-	};
-
-	VkFence fence = VK_NULL_HANDLE;
-	VK_CHECK(vkCreateFence(context.device, &fenceInfo, nullptr, &fence), "Failed to create Fence.");
-
-	vkResetFences(context.device, 1, &fence);
-
 	vkBeginCommandBuffer(cmd, &beginInfo);
 	recordCommands(cmd);
 	vkEndCommandBuffer(cmd);
 
-	VkSubmitInfo submitInfo = {
-		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-		.commandBufferCount = 1,
-		.pCommandBuffers = &cmd
-	};
-
-	VkResult result = vkQueueSubmit(context.graphicsQueue, 1, &submitInfo, fence);
-	//vkQueueWaitIdle(context.graphicsQueue);
-
-	VK_CHECK(vkWaitForFences(context.device, 1, &fence, VK_TRUE, UINT64_MAX), "Failed to wait for fence.");
+	// Signals the graphics timeline like any other submission, no fence has to be created for the wait
+	const uint64_t value = context.graphicsTimeline->Submit(context.graphicsQueue, { cmd });
+	context.graphicsTimeline->WaitFor(value);
 
 	vkFreeCommandBuffers(context.device, context.transientCommandPool, 1, &cmd);
-	vkDestroyFence(context.device, fence, nullptr);
 
 	vkResetCommandPool(context.device, context.transientCommandPool, 0);
 }
@@ -61,23 +43,11 @@ void vk::ImageBarrier(
 	VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
 	VkImageLayout srcLayout, VkImageLayout dstLayout,
 	VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
-	VkImageSubresourceRange subresourceRange,
-	uint32_t srcQueueFamilyIndex,
-	uint32_t dstQueueFamilyIndex)
+	VkImageSubresourceRange subresourceRange)
 {
-	VkImageMemoryBarrier imgBarrier = {
-		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-		.srcAccessMask = srcAccessMask,
-		.dstAccessMask = dstAccessMask,
-		.oldLayout = srcLayout,
-		.newLayout = dstLayout,
-		.srcQueueFamilyIndex = srcQueueFamilyIndex,
-		.dstQueueFamilyIndex = dstQueueFamilyIndex,
-		.image = img,
-		.subresourceRange = subresourceRange
-	};
-
-	vkCmdPipelineBarrier(cmd, srcStageMask, dstStageMask, 0, 0, nullptr, 0, nullptr, 1, &imgBarrier);
+	BarrierBatch barriers;
+	barriers.Image(img, srcLayout, dstLayout, srcStageMask, srcAccessMask, dstStageMask, dstAccessMask, subresourceRange);
+	barriers.Flush(cmd);
 }
 
 VkDescriptorSetLayout vk::CreateDescriptorSetLayout(vk::Context& context, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
@@ -92,18 +62,10 @@ VkDescriptorSetLayout vk::CreateDescriptorSetLayout(vk::Context& context, const
 	return layout;
 }
 
-void vk::AllocateDescriptorSets(Context& context, VkDescriptorPool descriptorPool, const VkDescriptorSetLayout descriptorLayout, uint32_t setCount, std::vector<VkDescriptorSet>& descriptorSet)
+void vk::AllocateDescriptorSets(Context& context, const VkDescriptorSetLayout descriptorLayout, uint32_t setCount, std::vector<VkDescriptorSet>& descriptorSet)
 {
-	std::vector<VkDescriptorSetLayout> setLayout(vk::MAX_FRAMES_IN_FLIGHT, descriptorLayout);
-
-	VkDescriptorSetAllocateInfo allocInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-	allocInfo.descriptorPool = descriptorPool;
-	allocInfo.descriptorSetCount = setCount;
-	allocInfo.pSetLayouts = setLayout.data();
-
-	descriptorSet.resize(vk::MAX_FRAMES_IN_FLIGHT);
-
-	VK_CHECK(vkAllocateDescriptorSets(context.device, &allocInfo, descriptorSet.data()), "Failed to allocate descriptor sets");
+	descriptorSet.resize(setCount);
+	context.descriptorAllocator->Allocate(descriptorLayout, setCount, descriptorSet.data());
 }
 
 // Define a descriptor set layout binding
@@ -149,6 +111,43 @@ void vk::UpdateDescriptorSet(Context& context, uint32_t binding, VkDescriptorIma
 	vkUpdateDescriptorSets(context.device, 1, &descriptorWrite, 0, nullptr);
 }
 
+VkDescriptorUpdateTemplate vk::CreateDescriptorUpdateTemplate(Context& context, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+	std::vector<VkDescriptorUpdateTemplateEntry> entries;
+	entries.reserve(bindings.size());
+
+	size_t index = 0;
+	for (const auto& binding : bindings)
+	{
+		VkDescriptorUpdateTemplateEntry entry{};
+		entry.dstBinding = binding.binding;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = binding.descriptorCount;
+		entry.descriptorType = binding.descriptorType;
+		entry.offset = index * sizeof(DescriptorInfo);
+		entry.stride = sizeof(DescriptorInfo);
+		entries.push_back(entry);
+
+		index += binding.descriptorCount;
+	}
+
+	VkDescriptorUpdateTemplateCreateInfo info{ VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO };
+	info.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+	info.pDescriptorUpdateEntries = entries.data();
+	info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	info.descriptorSetLayout = layout;
+
+	VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+	VK_CHECK(vkCreateDescriptorUpdateTemplate(context.device, &info, nullptr, &updateTemplate), "Failed to create descriptor update template");
+
+	return updateTemplate;
+}
+
+void vk::UpdateDescriptorSet(Context& context, VkDescriptorUpdateTemplate updateTemplate, VkDescriptorSet descriptorSet, const std::vector<DescriptorInfo>& infos)
+{
+	vkUpdateDescriptorSetWithTemplate(context.device, descriptorSet, updateTemplate, infos.data());
+}
+
 VkSampler vk::CreateSampler(Context& context, VkSamplerAddressMode mode, VkBool32 EnableAnisotropic, VkCompareOp compareOp,
 	VkFilter magFilter, VkFilter minFilter, VkSamplerMipmapMode samplerMipmapMode)
 {
@@ -174,16 +173,3 @@ VkSampler vk::CreateSampler(Context& context, VkSamplerAddressMode mode, VkBool3
 
 	return sampler;
 }
-
-void vk::BulkImageUpdate(Context& context, uint32_t binding, std::vector<VkDescriptorImageInfo> imageInfos, VkDescriptorSet descriptorSet, VkDescriptorType descriptorType)
-{
-	VkWriteDescriptorSet descriptorWrite{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-	descriptorWrite.dstSet = descriptorSet;
-	descriptorWrite.dstBinding = binding;
-	descriptorWrite.dstArrayElement = 0;
-	descriptorWrite.descriptorType = descriptorType;
-	descriptorWrite.descriptorCount = static_cast<uint32_t>(imageInfos.size());
-	descriptorWrite.pImageInfo = imageInfos.data();
-
-	vkUpdateDescriptorSets(context.device, 1, &descriptorWrite, 0, nullptr);
-}
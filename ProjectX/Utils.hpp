@@ -35,7 +35,9 @@ namespace vk
 	};
 
 
-	inline int MAX_FRAMES_IN_FLIGHT;
+	// Frames the CPU may record ahead of the GPU. Kept independent of the swapchain's image count so latency and
+	// the number of per-frame uniform buffers, descriptor sets and command pools don't depend on the driver.
+	inline constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 	inline int currentFrame;
 
 	inline VkSampler repeatSamplerAniso;
@@ -58,12 +60,36 @@ namespace vk
 		uint32_t nTextureID; // NormalMap
 	};
 
+	// Entry of the scene's object buffer (std430), a draw's firstInstance is its index
+	struct ObjectData
+	{
+		glm::mat4 ModelMatrix;
+		uint32_t materialIndex;
+		uint32_t padding[3]; // std430 rounds the array stride up to 16
+	};
+
+	// World space box of a draw, covering every instance it draws (w is unused)
+	struct ObjectBounds
+	{
+		glm::vec4 min;
+		glm::vec4 max;
+	};
+
+	// Entry of the scene's material table (std430), texture IDs are slots in the bindless table
+	struct MaterialData
+	{
+		uint32_t dTextureID; // Diffuse
+		uint32_t mTextureID; // Metalness
+		uint32_t rTextureID; // Roughness
+		uint32_t eTextureID; // Emissive, ~0u when there is none
+		uint32_t nTextureID; // NormalMap
+	};
+
 	struct LightUBO
 	{
 		alignas(4)	int type;
 		alignas(16) glm::vec4 LightPosition;
 		alignas(16) glm::vec4 LightColour;
-		alignas(16) glm::mat4 LightSpaceMatrix;
 	};
 
 	struct PostProcessing
@@ -76,6 +102,17 @@ namespace vk
 		LightUBO lights[NUM_LIGHTS];
 	};
 
+	inline constexpr uint32_t MaxShadowCascades = 4;
+
+	// Cascades of the directional light's shadow map, cascade i is layer i
+	struct ShadowCascadesUBO
+	{
+		alignas(16) glm::mat4 viewProjections[MaxShadowCascades];
+		alignas(16) glm::vec4 splits; // view space depth each cascade ends at
+		alignas(4)	int count;
+		alignas(4)	float depthBias;
+	};
+
 	struct GuassianWeightsBuffer
 	{
 		float weights[22];
@@ -102,31 +139,55 @@ namespace vk
 		float time;
 	};
 
+	struct LightingSettings
+	{
+		int PCFRange; // half width of the shadow filter kernel, 0 takes a single tap
+	};
+
+	struct ShadowSettings
+	{
+		int CascadeCount; // 1 to MaxShadowCascades
+		float SplitLambda; // blend between uniform (0) and logarithmic (1) cascade splits
+		float Distance;	   // view depth the last cascade ends at, nothing further is shadowed
+		float DepthBias;
+	};
+
 	inline PostProcessing postProcessSettings = {};
 	inline double deltaTime;
 	inline uint32_t setRenderingPipeline = 1;
 	inline uint32_t setAlphaMakingPipeline = 5;
 	inline SSRSettings ssrSettings = { 20, 1, 0.0f, 0.001f, 0.001f };
 	inline SSAOSettings ssaoSettings = {6,6, 1.0f, 0.005, 0.0f, 1.7f, 0.0f};
+	inline LightingSettings lightingSettings = { 2 };
+	inline ShadowSettings shadowSettings = { 4, 0.8f, 60.0f, 0.002f };
+	inline bool gpuCulling = true; // off: the culling views only frustum cull, on the CPU
+	inline bool cameraCollision = true; // the camera stops at and slides along the scene's triangles
+	inline bool cacheShadowMap = true; // a shadow cascade is only drawn again when its projection or a caster in its volume changes
+	// Read when the passes are created. The GBuffer draws against the prepass depth with an EQUAL test and no depth writes,
+	// every pixel is shaded once and the lighting passes sample the prepass depth. Off: the GBuffer draws its own depth.
+	inline bool gbufferReusesPrepassDepth = true;
+	// Read when the scene is built. Adds a copy of the temple's fire pits and pillars down each side of the hall, drawn
+	// instanced with the originals, propSpacing away from them.
+	inline bool instancedPropsDemo = false;
+	inline float propSpacing = 20.0f;
 }
 
 namespace vk
 {
 	void ExecuteSingleTimeCommands(Context& context, std::function<void(VkCommandBuffer)> recordCommands);
 
-	// Sync
+	// Sync: a single image barrier recorded straight away, use a BarrierBatch when several are needed at the same point
 	void ImageBarrier(
 		VkCommandBuffer cmd,
 		VkImage img,
 		VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
 		VkImageLayout srcLayout, VkImageLayout dstLayout,
 		VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask,
-		VkImageSubresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
-		uint32_t srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-		uint32_t dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED);
+		VkImageSubresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 });
 
 	VkDescriptorSetLayout CreateDescriptorSetLayout(Context& context, const std::vector<VkDescriptorSetLayoutBinding>& bindings);
-	void AllocateDescriptorSets(Context& context, VkDescriptorPool descriptorPool, const VkDescriptorSetLayout descriptorLayout, uint32_t setCount, std::vector<VkDescriptorSet>& descriptorSet);
+	// Sets that live as long as the pass, from the context's growable descriptor allocator
+	void AllocateDescriptorSets(Context& context, const VkDescriptorSetLayout descriptorLayout, uint32_t setCount, std::vector<VkDescriptorSet>& descriptorSet);
 	VkDescriptorSetLayoutBinding CreateDescriptorBinding(uint32_t binding, uint32_t count, VkDescriptorType type, VkShaderStageFlags shaderStage);
 
 	// Update buffer descriptor
@@ -134,9 +195,24 @@ namespace vk
 	// Update image descriptor
 	void UpdateDescriptorSet(Context& context, uint32_t binding, VkDescriptorImageInfo imageInfo, VkDescriptorSet descriptorSet, VkDescriptorType descriptorType);
 
-	VkSampler CreateSampler(Context& context, VkSamplerAddressMode mode, VkBool32 EnableAnisotropic, VkCompareOp compareOp, VkFilter magFilter = VK_FILTER_LINEAR, VkFilter minFilter = VK_FILTER_LINEAR, VkSamplerMipmapMode samplerMipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR);
+	// One descriptor written through an update template, buffers and images share the slot so a whole set is a flat array
+	union DescriptorInfo
+	{
+		VkDescriptorBufferInfo buffer;
+		VkDescriptorImageInfo image;
 
-	void BulkImageUpdate(Context& context, uint32_t binding, std::vector<VkDescriptorImageInfo> imageInfos, VkDescriptorSet descriptorSet, VkDescriptorType descriptorType);
+		DescriptorInfo(VkBuffer buffer, VkDeviceSize range, VkDeviceSize offset = 0) : buffer{ buffer, offset, range } {}
+		DescriptorInfo(VkSampler sampler, VkImageView imageView, VkImageLayout layout) : image{ sampler, imageView, layout } {}
+		DescriptorInfo(VkImageView imageView, VkImageLayout layout) : image{ VK_NULL_HANDLE, imageView, layout } {}
+		explicit DescriptorInfo(VkSampler sampler) : image{ sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED } {}
+	};
+
+	// Template writing every binding of the layout in one call, the infos are expected in the order of the bindings
+	VkDescriptorUpdateTemplate CreateDescriptorUpdateTemplate(Context& context, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+	// Update all descriptors of the set at once
+	void UpdateDescriptorSet(Context& context, VkDescriptorUpdateTemplate updateTemplate, VkDescriptorSet descriptorSet, const std::vector<DescriptorInfo>& infos);
+
+	VkSampler CreateSampler(Context& context, VkSamplerAddressMode mode, VkBool32 EnableAnisotropic, VkCompareOp compareOp, VkFilter magFilter = VK_FILTER_LINEAR, VkFilter minFilter = VK_FILTER_LINEAR, VkSamplerMipmapMode samplerMipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR);
 
 	inline void RenderPassLabel(VkCommandBuffer commandBuffer, const char* labelName) {
 		VkDebugUtilsLabelEXT label = {};
@@ -2,9 +2,11 @@
 #include "baked_model.hpp"
 #include "Utils.hpp"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <format>
+#include <unordered_map>
 
 namespace
 {
@@ -37,6 +39,44 @@ BakedModel load_baked_model( char const* aModelPath )
 	}
 }
 
+BakedModel extract_baked_meshes( BakedModel& aModel, std::vector<std::string> const& aNames )
+{
+	auto const matches = [&]( BakedMeshData const& aMesh )
+	{
+		auto const textureId = aModel.materials[aMesh.materialId].baseColorTextureId;
+		if( textureId >= aModel.textures.size() )
+			return false;
+
+		auto const& path = aModel.textures[textureId].path;
+		return std::any_of( aNames.begin(), aNames.end(), [&]( std::string const& aName ) { return path.find( aName ) != std::string::npos; } );
+	};
+
+	// Texture IDs stay valid as the texture list is the same, only the materials are renumbered
+	BakedModel ret;
+	ret.textures = aModel.textures;
+	std::unordered_map<std::uint32_t, std::uint32_t> materials; // old index -> index in ret
+
+	std::vector<BakedMeshData> kept;
+	for( auto& mesh : aModel.meshes )
+	{
+		if( !matches( mesh ) )
+		{
+			kept.emplace_back( std::move(mesh) );
+			continue;
+		}
+
+		auto [it, inserted] = materials.try_emplace( mesh.materialId, std::uint32_t(ret.materials.size()) );
+		if( inserted )
+			ret.materials.push_back( aModel.materials[mesh.materialId] );
+
+		mesh.materialId = it->second;
+		ret.meshes.emplace_back( std::move(mesh) );
+	}
+
+	aModel.meshes = std::move(kept);
+	return ret;
+}
+
 namespace
 {
 	void checked_read_( FILE* aFin, std::size_t aBytes, void* aBuffer )
@@ -166,9 +166,6 @@ struct BakedMeshData
 	std::vector<std::array<uint8_t, 3>> compressedTBN;
 
 	std::vector<vk::Vertex> vertexData;
-
-	vk::Buffer vertexBuffer;
-	vk::Buffer indexBuffer;
 };
 
 //model.materials[mesh.materialID].baseColortextureid
@@ -178,8 +175,14 @@ struct BakedModel
 	std::vector<BakedMaterialInfo> materials; // Each material had an texture ID into textures array
 	std::vector<BakedMeshData> meshes;
 	std::vector<vk::Image> loadedTextures;
+	std::vector<uint32_t> textureSlots; // loadedTextures[i] is in slot textureSlots[i] of the bindless texture table
 };
 
 BakedModel load_baked_model( char const* aModelPath );
+
+// Moves the meshes whose base color texture path contains any of aNames out of aModel into a model of their own, which
+// only lists the materials those meshes use. It keeps aModel's texture list so both can share the uploaded textures,
+// see vk::Scene::AddModel. Call before either model is added to a scene.
+BakedModel extract_baked_meshes( BakedModel& aModel, std::vector<std::string> const& aNames );
 #endif // BAKED_MODEL_HPP_7D7BFF3A_1743_43DF_8D4F_D67D80FD8282
 
@@ -16,6 +16,11 @@ layout(set = 0, binding = 0) uniform SceneUniform
 	float farPlane;
 } ubo;
 
+// Direction and step counts are specialized per quality setting so both loops have compile time bounds,
+// NumDirections and NumSteps are kept in the uniform only to match the layout of the C++ struct
+layout(constant_id = 0) const int NUM_DIRECTIONS = 6;
+layout(constant_id = 1) const int NUM_STEPS = 6;
+
 layout(set = 0, binding = 1) uniform SSAOSettings
 {
 	int NumDirections;
@@ -71,9 +76,9 @@ vec4 GetJitter()
     return texture(NoiseTexture, (gl_FragCoord.xy / 4.0));
 }
 
-float NUMBER_OF_SAMPLING_DIRECTIONS = ssao.NumDirections;
+float NUMBER_OF_SAMPLING_DIRECTIONS = NUM_DIRECTIONS;
 float STEP = ssao.StepSize; //0.04
-float NUMBER_OF_STEPS = ssao.NumSteps;
+float NUMBER_OF_STEPS = NUM_STEPS;
 float TANGENT_BIAS = 0.523599;
 float HalfPI = 0.5 * PI;
 float TAU = 2 * PI;
@@ -97,7 +102,7 @@ float HBAO()
 	// vec3(0,0,0) is camera position in view space
 	// float centerDepth = distance(vec3(0,0,0), viewPosition.xyz);
 
-    for(int i = 0; i < NUMBER_OF_SAMPLING_DIRECTIONS; i++) {
+    for(int i = 0; i < NUM_DIRECTIONS; i++) {
 
         float samplingDirectionAngle = i * samplingDiskDirection;
         vec2 samplingDirection = RotateDirectionAngle(vec2(cos(samplingDirectionAngle), sin(samplingDirectionAngle)), Rand.xy);
@@ -106,7 +111,7 @@ float HBAO()
         float horizonAngle = tangentAngle;
 
         vec3 LastDifference = vec3(0);
-        for(int j = 0; j < NUMBER_OF_STEPS; j++){
+        for(int j = 0; j < NUM_STEPS; j++){
 
             vec2 stepForward = (Rand.z + float(j+1)) * STEP * samplingDirection;
             vec2 stepPosition = uv + stepForward;
@@ -17,6 +17,11 @@ layout(set = 0, binding = 0) uniform SceneUniform
 } ubo;
 
 
+// Specialized per quality setting so the marching and refinement loops have compile time bounds,
+// the uniform's MaxSteps and BinarySearchIterations are kept only to match the layout of the C++ struct
+layout(constant_id = 0) const int MAX_STEPS = 20;
+layout(constant_id = 1) const int BINARY_SEARCH_ITERATIONS = 1;
+
 layout(set = 0, binding = 1) uniform SSRSettings
 {
     int MaxSteps;
@@ -88,7 +93,7 @@ vec2 getRandomXi(vec2 fragCoord) {
 
 vec4 NaiveScreenSpaceReflections()
 {
-	int STEPS = ssr.MaxSteps;
+	int STEPS = MAX_STEPS;
 	float MAX_DISTANCE = ssr.MaxDistance;
 	float stepSize = MAX_DISTANCE / float(STEPS);
 
@@ -129,7 +134,7 @@ vec4 NaiveScreenSpaceReflections()
 
 			vec3 hitPos = RayPos;
 			vec3 prevPos = RayPos - RayStep;
-			for (int j = 0; j < ssr.BinarySearchIterations; j++) { // 4 iterations for refinement
+			for (int j = 0; j < BINARY_SEARCH_ITERATIONS; j++) { // 4 iterations for refinement
 				vec3 midPos = (hitPos + prevPos) * 0.5;
 				vec4 midCoords = ubo.projection * ubo.view * vec4(midPos, 1.0);
 				midCoords.xyz /= midCoords.w;
@@ -243,7 +248,7 @@ vec3 ScreenSpaceReflectionsOriginal()
     float y = float(start.y);
 
     // We want to keep moving forward the end point in screen-space until we reach the end determined by stepDir
-    for(int i = 0; i < ssr.MaxSteps; i++)
+    for(int i = 0; i < MAX_STEPS; i++)
     {
         x += x_incr;
         y += y_incr;
@@ -277,7 +282,7 @@ vec3 ScreenSpaceReflectionsOriginal()
 
 float ScreenSpaceShadows()
 {
-	int STEPS = ssr.MaxSteps;
+	int STEPS = MAX_STEPS;
 	float MAX_DISTANCE = ssr.MaxDistance;
 	float stepSize = MAX_DISTANCE / float(STEPS);
 
@@ -356,7 +361,7 @@ vec3 ScreenSpaceReflections(inout bool didHit)
     // Start and End setup, determine step direction
     float dx = end.x - start.x;
     float dy = end.y - start.y;
-    // int stepDir = max(16, min(ssr.MaxSteps, max(abs(int(dx)), abs(int(dy)))));
+    // int stepDir = max(16, min(MAX_STEPS, max(abs(int(dx)), abs(int(dy)))));
     int stepDir = max(abs(int(dx)), abs(int(dy)));
 
 	// Early exit if start and end are the same. We don't need to traverse the ray
@@ -514,7 +519,7 @@ vec4 ReflectionDir_GGX(vec3 V, vec3 N, float roughness, vec2 random2) {
 
 vec4 NaiveScreenSpaceReflectionsS()
 {
-    int STEPS = ssr.MaxSteps;
+    int STEPS = MAX_STEPS;
     float MAX_DISTANCE = ssr.MaxDistance;
     float stepSize = MAX_DISTANCE / float(STEPS);
 
@@ -570,7 +575,7 @@ vec4 NaiveScreenSpaceReflectionsS()
 
 vec4 NaiveScreenSpaceReflections3()
 {
-    int STEPS = ssr.MaxSteps;
+    int STEPS = MAX_STEPS;
     float MAX_DISTANCE = ssr.MaxDistance;
     float stepSize = MAX_DISTANCE / float(STEPS);
 
@@ -578,7 +583,7 @@ vec4 NaiveScreenSpaceReflections3()
     vec3 WorldNormal = normalize((texture(normalsTexture, uv).xyz * 2.0 - 1.0));
     vec3 camDir = normalize(WorldPos.xyz - ubo.cameraPosition.xyz);
 
-    const int NUM_SAMPLES = ssr.BinarySearchIterations;  // Number of rays
+    const int NUM_SAMPLES = BINARY_SEARCH_ITERATIONS;  // Number of rays
     vec4 accumulatedColor = vec4(0.0);
     float accumulatedWeight = 0.0;
 
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec4 WorldPos;
 layout(location = 1) in vec2 uv;
@@ -23,7 +24,6 @@ struct Light
 	int Type;
 	vec4 LightPosition;
 	vec4 LightColour;
-	mat4 LightSpaceMatrix;
 };
 
 const int NUM_LIGHTS = 17;
@@ -32,16 +32,25 @@ layout(set = 0, binding = 1) uniform LightBuffer {
 	Light lights[NUM_LIGHTS];
 } lightData;
 
-layout(push_constant) uniform Push
+layout(location = 6) flat in uint MaterialIndex;
+
+struct MaterialData
 {
-	mat4 ModelMatrix;
 	uint dTextureID; // diffuse
 	uint mTextureID; // metalness
 	uint rTextureID; // roughness
-    uint eTextureID; // emissive
-}pc;
+	uint eTextureID; // emissive
+	uint nTextureID; // normalMap
+};
+
+// Material table of the scene, indexed by the object's material
+layout(std430, set = 2, binding = 1) readonly buffer Materials
+{
+	MaterialData materials[];
+};
 
-layout(set = 0, binding = 2) uniform texture2D textures[200];
+// Bindless texture table shared by every pass, the material IDs are slots into it
+layout(set = 1, binding = 0) uniform texture2D textures[];
 layout(set = 0, binding = 3) uniform sampler samplerAnisotropic;
 layout(set = 0, binding = 4) uniform sampler samplerNormal;
 
@@ -113,8 +122,10 @@ vec3 CookTorranceBRDF(vec3 normal, vec3 halfVector, vec3 viewDir, vec3 lightDir,
 // TODO: In this pass the emissive is not being checked for -1 so its rendering plants during emissive when doing forward
 void main()
 {
+    MaterialData material = materials[MaterialIndex];
+
     vec4 color = vec4(0.0);
-    color = texture(sampler2D(textures[pc.dTextureID], samplerAnisotropic), uv);
+    color = texture(sampler2D(textures[material.dTextureID], samplerAnisotropic), uv);
 
     // Alpha is less than some threshold ? Discard the fragment
     if(color.a < 0.1)
@@ -128,8 +139,8 @@ void main()
     vec3 halfVector = normalize(viewDir + lightDir);
 
     // == Metal and Roughness ==
-    float roughness = texture(sampler2D(textures[pc.rTextureID], samplerAnisotropic), uv).x;
-    float metallic = texture(sampler2D(textures[pc.mTextureID], samplerAnisotropic), uv).x;
+    float roughness = texture(sampler2D(textures[material.rTextureID], samplerAnisotropic), uv).x;
+    float metallic = texture(sampler2D(textures[material.mTextureID], samplerAnisotropic), uv).x;
 
     vec3 outLight = CookTorranceBRDF(wNormal, halfVector, viewDir, lightDir, metallic, roughness, color.xyz);
 
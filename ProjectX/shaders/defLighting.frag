@@ -22,11 +22,13 @@ struct Light
 	int Type;
 	vec4 LightPosition;
 	vec4 LightColour;
-	mat4 LightSpaceMatrix;
 };
 
 const int NUM_LIGHTS = 26;
 
+// Shadow filtering is specialized per quality setting: a (2 * PCF_RANGE)^2 kernel, or a single compared tap for 0
+layout(constant_id = 0) const int PCF_RANGE = 2;
+
 layout(set = 0, binding = 1) uniform LightBuffer {
 	Light lights[NUM_LIGHTS];
 } lightData;
@@ -37,7 +39,18 @@ layout(set = 0, binding = 3) uniform sampler2D gAlbedo;
 layout(set = 0, binding = 4) uniform sampler2D gNormal;
 layout(set = 0, binding = 5) uniform sampler2D gMetRoughness;
 layout(set = 0, binding = 6) uniform sampler2D gEmissive;
-layout(set = 0, binding = 7) uniform sampler2DShadow shadowMap;
+layout(set = 0, binding = 7) uniform sampler2DArrayShadow shadowMap;
+
+const int MAX_CASCADES = 4;
+
+// Cascades of the directional light, cascade i is layer i of the shadow map and covers view depths up to splits[i]
+layout(set = 0, binding = 8) uniform ShadowCascades
+{
+	mat4 viewProjections[MAX_CASCADES];
+	vec4 splits;
+	int count;
+	float depthBias;
+} cascades;
 
 #define PI 3.14159265359
 
@@ -161,14 +174,36 @@ vec3 CookTorranceBRDF(vec3 normal, vec3 halfVector, vec3 viewDir, vec3 lightDir,
     return vec3(outLight);
 }
 
-float Shadow(vec3 WorldPos)
+// The first cascade reaching past the position's view depth, -1 past the last one
+int SelectCascade(vec3 WorldPos)
+{
+	float viewDepth = -(ubo.view * vec4(WorldPos, 1.0)).z;
+	for(int i = 0; i < cascades.count; i++)
+	{
+		if(viewDepth <= cascades.splits[i])
+			return i;
+	}
+
+	return -1;
+}
+
+// xy: shadow map uv, z: depth in the cascade
+vec3 CascadeCoord(vec3 WorldPos, int cascade)
 {
-	vec4 fragPositionInLightSpace = lightData.lights[0].LightSpaceMatrix * vec4(WorldPos, 1.0);
+	vec4 fragPositionInLightSpace = cascades.viewProjections[cascade] * vec4(WorldPos, 1.0);
 	fragPositionInLightSpace.xyz /= fragPositionInLightSpace.w;
 	fragPositionInLightSpace.xy = fragPositionInLightSpace.xy * 0.5 + 0.5;
-	fragPositionInLightSpace.z -= 0.005;
+	return fragPositionInLightSpace.xyz;
+}
 
-	float shadow = textureProj(shadowMap, fragPositionInLightSpace);
+float Shadow(vec3 WorldPos)
+{
+	int cascade = SelectCascade(WorldPos);
+	if(cascade < 0)
+		return 0.0;
+
+	vec3 coord = CascadeCoord(WorldPos, cascade);
+	float shadow = texture(shadowMap, vec4(coord.xy, float(cascade), coord.z - cascades.depthBias));
 	return shadow;
 }
 
@@ -176,12 +211,14 @@ float Shadow(vec3 WorldPos)
 float PCF(vec3 WorldPos)
 {
 	// Use direct lighting only. Point light shadows are handleded differently (cube depth)
-	vec4 fragPositionInLightSpace = lightData.lights[0].LightSpaceMatrix * vec4(WorldPos, 1.0);
-	fragPositionInLightSpace.xyz /= fragPositionInLightSpace.w;
-	fragPositionInLightSpace.xy = fragPositionInLightSpace.xy * 0.5 + 0.5;
+	int cascade = SelectCascade(WorldPos);
+	if(cascade < 0)
+		return 0.0;
+
+	vec3 coord = CascadeCoord(WorldPos, cascade);
 
-	vec2 texSize = 1.0 / textureSize(shadowMap, 0);
-	int range = 2; // 4x4
+	vec2 texSize = 1.0 / textureSize(shadowMap, 0).xy;
+	int range = PCF_RANGE; // 2 -> 4x4
 	int samples = 0;
 	float sum = 0.0;
 	for(int x = -range; x < range; x++)
@@ -189,8 +226,7 @@ float PCF(vec3 WorldPos)
 		for(int y = -range; y < range; y++)
 		{
 			vec2 offset = vec2(x,y) * texSize;
-			vec4 sampleCoord = vec4(fragPositionInLightSpace.xy + offset, fragPositionInLightSpace.z - 0.005, fragPositionInLightSpace.w);
-			sum += textureProj(shadowMap, sampleCoord);
+			sum += texture(shadowMap, vec4(coord.xy + offset, float(cascade), coord.z - cascades.depthBias));
 			samples++;
 		}
 	}
@@ -272,7 +308,7 @@ void main()
 
 		// Apply shadow only to direct lighting
 		if(isDirectional) {
-			float shadowCoefficent = 1.0 - PCF(WorldPos);
+			float shadowCoefficent = 1.0 - (PCF_RANGE > 0 ? PCF(WorldPos) : Shadow(WorldPos));
 			outLight += CookTorranceBRDF(wNormal, halfVector, viewDir, lightDir, metallic, roughness, color.xyz, LightColour) * shadowCoefficent;
 
 		}
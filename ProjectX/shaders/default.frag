@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec4 WorldPos;
 layout(location = 1) in vec2 uv;
@@ -23,7 +24,6 @@ struct Light
 	int Type;
 	vec4 LightPosition;
 	vec4 LightColour;
-	mat4 LightSpaceMatrix;
 };
 
 const int NUM_LIGHTS = 26;
@@ -32,19 +32,28 @@ layout(set = 0, binding = 1) uniform LightBuffer {
 	Light lights[NUM_LIGHTS];
 } lightData;
 
-layout(push_constant) uniform Push
+layout(location = 6) flat in uint MaterialIndex;
+
+struct MaterialData
 {
-	mat4 ModelMatrix;
 	uint dTextureID; // diffuse
 	uint mTextureID; // metalness
 	uint rTextureID; // roughness
 	uint eTextureID; // emissive
-}pc;
+	uint nTextureID; // normalMap
+};
+
+// Material table of the scene, indexed by the object's material
+layout(std430, set = 2, binding = 1) readonly buffer Materials
+{
+	MaterialData materials[];
+};
 
-layout(set = 0, binding = 2) uniform texture2D textures[200];
+// Bindless texture table shared by every pass, the material IDs are slots into it
+layout(set = 1, binding = 0) uniform texture2D textures[];
 layout(set = 0, binding = 3) uniform sampler samplerAnisotropic;
 layout(set = 0, binding = 4) uniform sampler samplerNormal;
-layout(set = 0, binding = 5) uniform sampler2DShadow shadowMap;
+layout(set = 0, binding = 5) uniform sampler2DArrayShadow shadowMap; // one layer per cascade
 
 #define PI 3.14159265359
 
@@ -113,18 +122,20 @@ vec3 CookTorranceBRDF(vec3 normal, vec3 halfVector, vec3 viewDir, vec3 lightDir,
 
 void main()
 {
-	vec4 color = texture(sampler2D(textures[pc.dTextureID], samplerAnisotropic), uv);
+	MaterialData material = materials[MaterialIndex];
+
+	vec4 color = texture(sampler2D(textures[material.dTextureID], samplerAnisotropic), uv);
 	vec3 emissive = vec3(0.0f);
-	if(pc.eTextureID != -1)
+	if(material.eTextureID != -1)
 	{
-		emissive = texture(sampler2D(textures[pc.eTextureID], samplerAnisotropic), uv).rgb;
+		emissive = texture(sampler2D(textures[material.eTextureID], samplerAnisotropic), uv).rgb;
 	}
 
     vec3 wNormal = normalize(WorldNormal).xyz;
 
     // == Metal and Roughness ==
-    float roughness = texture(sampler2D(textures[pc.rTextureID], samplerAnisotropic), uv).x;
-    float metallic = texture(sampler2D(textures[pc.mTextureID], samplerAnisotropic), uv).x;
+    float roughness = texture(sampler2D(textures[material.rTextureID], samplerAnisotropic), uv).x;
+    float metallic = texture(sampler2D(textures[material.mTextureID], samplerAnisotropic), uv).x;
 
     vec3 outLight = vec3(0.0);
 
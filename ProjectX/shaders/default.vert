@@ -12,15 +12,17 @@ layout(set = 0, binding = 0) uniform SceneUniform
 	float farPlane;
 } ubo;
 
-layout(push_constant) uniform Push
+struct ObjectData
 {
 	mat4 ModelMatrix;
-	uint dTextureID; // diffuse 
-	uint mTextureID; // metalness
-	uint rTextureID; // roughness
-	uint eTextureID; // emissive
-	uint nTextureID; // normalMap
-}pc;
+	uint materialIndex;
+};
+
+// Every object of the scene, the draw's firstInstance is the object's index
+layout(std430, set = 2, binding = 0) readonly buffer Objects
+{
+	ObjectData objects[];
+};
 
 layout(location = 0) in vec3 pos;
 layout(location = 1) in vec2 tex;
@@ -31,6 +33,10 @@ layout(location = 0) out vec4 WorldPos;
 layout(location = 1) out vec2 uv;
 layout(location = 2) out vec4 WorldNormal;
 layout(location = 3) out mat3 TBN;
+layout(location = 6) flat out uint MaterialIndex;
+
+// The depth prepass and the G-Buffer both run this shader, the G-Buffer's EQUAL depth test needs the exact same positions
+invariant gl_Position;
 
 float unpack8bitToFloat(uint value)
 {
@@ -84,13 +90,15 @@ mat3 QuatToMat3(vec4 q) {
 
 void main()
 {
+	ObjectData object = objects[gl_InstanceIndex];
+
 	vec4 quaternion = normalize(unpackQuaternion(compressedTBN));
 	mat3 tbnMatrix = QuatToMat3(quaternion);
 
-	WorldNormal = normalize(pc.ModelMatrix * vec4(normal, 0.0));
+	WorldNormal = normalize(object.ModelMatrix * vec4(normal, 0.0));
 
-    vec3 T = normalize((pc.ModelMatrix * vec4(tbnMatrix[0], 0.0)).xyz);
-    vec3 B = normalize((pc.ModelMatrix * vec4(tbnMatrix[1], 0.0)).xyz);
+    vec3 T = normalize((object.ModelMatrix * vec4(tbnMatrix[0], 0.0)).xyz);
+    vec3 B = normalize((object.ModelMatrix * vec4(tbnMatrix[1], 0.0)).xyz);
     
     // Reference: Tangent Frame Transformation with Dual-Quaternion (Slide 23)
     B *= sign(quaternion.w); // handededness 
@@ -98,6 +106,7 @@ void main()
     TBN = mat3(T, B, WorldNormal); 
 
 	uv = tex;
-	WorldPos = pc.ModelMatrix * vec4(pos, 1.0);
-	gl_Position = ubo.projection * ubo.view * pc.ModelMatrix * vec4(pos, 1.0);
+	MaterialIndex = object.materialIndex;
+	WorldPos = object.ModelMatrix * vec4(pos, 1.0);
+	gl_Position = ubo.projection * ubo.view * object.ModelMatrix * vec4(pos, 1.0);
 }
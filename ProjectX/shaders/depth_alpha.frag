@@ -0,0 +1,38 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Depth prepass of alpha masked materials: only the depth of the opaque texels is kept, later passes test EQUAL against it
+
+layout(location = 1) in vec2 uv;
+layout(location = 6) flat in uint MaterialIndex;
+
+struct MaterialData
+{
+	uint dTextureID; // diffuse
+	uint mTextureID; // metalness
+	uint rTextureID; // roughness
+	uint eTextureID; // emissive
+	uint nTextureID; // normalMap
+};
+
+// Material table of the scene, indexed by the object's material
+layout(std430, set = 2, binding = 1) readonly buffer Materials
+{
+	MaterialData materials[];
+};
+
+// Bindless texture table shared by every pass, the material IDs are slots into it
+layout(set = 1, binding = 0) uniform texture2D textures[];
+layout(set = 0, binding = 2) uniform sampler samplerAnisotropic;
+
+void main()
+{
+	MaterialData material = materials[MaterialIndex];
+
+	// Same cutoff as the G-Buffer's alpha masking
+	float alpha = texture(sampler2D(textures[material.dTextureID], samplerAnisotropic), uv).a;
+	if(alpha < 0.1)
+	{
+		discard;
+	}
+}
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec4 WorldPos;
 layout(location = 1) in vec2 uv;
@@ -22,33 +23,43 @@ layout(set = 0, binding = 0) uniform SceneUniform
 	float farPlane;
 } ubo;
 
-layout(push_constant) uniform Push
+layout(location = 6) flat in uint MaterialIndex;
+
+struct MaterialData
 {
-	mat4 ModelMatrix;
 	uint dTextureID; // diffuse
 	uint mTextureID; // metalness
 	uint rTextureID; // roughness
 	uint eTextureID; // emissive
 	uint nTextureID; // normalMap
-}pc;
+};
+
+// Material table of the scene, indexed by the object's material
+layout(std430, set = 2, binding = 1) readonly buffer Materials
+{
+	MaterialData materials[];
+};
 
-layout(set = 0, binding = 1) uniform texture2D textures[200];
+// Bindless texture table shared by every pass, the material IDs are slots into it
+layout(set = 1, binding = 0) uniform texture2D textures[];
 layout(set = 0, binding = 2) uniform sampler samplerAnisotropic;
 
 
 void main()
 {
-	vec4 color = texture(sampler2D(textures[pc.dTextureID], samplerAnisotropic), uv);
+	MaterialData material = materials[MaterialIndex];
+
+	vec4 color = texture(sampler2D(textures[material.dTextureID], samplerAnisotropic), uv);
 	albedo = color;
 	//normal = vec4(WorldNormal) * 0.5 + 0.5;
-	vec3 texNormal = texture(sampler2D(textures[pc.nTextureID], samplerAnisotropic), uv).rgb * 2.0 - 1.0;
+	vec3 texNormal = texture(sampler2D(textures[material.nTextureID], samplerAnisotropic), uv).rgb * 2.0 - 1.0;
 
 	texNormal = (TBN * texNormal);
 	texNormal = normalize(texNormal);
 	normal = vec4(texNormal * 0.5 + 0.5, 0.0); // convert back to 0-1 for storage because of normal texture format
 
-	metroughness.r = texture(sampler2D(textures[pc.rTextureID], samplerAnisotropic), uv).r;
-	metroughness.g = texture(sampler2D(textures[pc.mTextureID], samplerAnisotropic), uv).r;
+	metroughness.r = texture(sampler2D(textures[material.rTextureID], samplerAnisotropic), uv).r;
+	metroughness.g = texture(sampler2D(textures[material.mTextureID], samplerAnisotropic), uv).r;
 
-	emissive = pc.eTextureID == -1 ? vec4(0.0, 0.0, 0.0, 1.0) : texture(sampler2D(textures[pc.eTextureID], samplerAnisotropic), uv) * 100.0;
+	emissive = material.eTextureID == -1 ? vec4(0.0, 0.0, 0.0, 1.0) : texture(sampler2D(textures[material.eTextureID], samplerAnisotropic), uv) * 100.0;
 }
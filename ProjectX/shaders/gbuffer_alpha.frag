@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec4 WorldPos;
 layout(location = 1) in vec2 uv;
@@ -22,22 +23,33 @@ layout(set = 0, binding = 0) uniform SceneUniform
 	float farPlane;
 } ubo;
 
-layout(push_constant) uniform Push
+layout(location = 6) flat in uint MaterialIndex;
+
+struct MaterialData
 {
-	mat4 ModelMatrix;
-	uint dTextureID; // diffuse 
+	uint dTextureID; // diffuse
 	uint mTextureID; // metalness
 	uint rTextureID; // roughness
 	uint eTextureID; // emissive
-}pc;
+	uint nTextureID; // normalMap
+};
+
+// Material table of the scene, indexed by the object's material
+layout(std430, set = 2, binding = 1) readonly buffer Materials
+{
+	MaterialData materials[];
+};
 
-layout(set = 0, binding = 1) uniform texture2D textures[200];
+// Bindless texture table shared by every pass, the material IDs are slots into it
+layout(set = 1, binding = 0) uniform texture2D textures[];
 layout(set = 0, binding = 2) uniform sampler samplerAnisotropic;
 
 
 void main()
 {
-	vec4 color = texture(sampler2D(textures[pc.dTextureID], samplerAnisotropic), uv);
+	MaterialData material = materials[MaterialIndex];
+
+	vec4 color = texture(sampler2D(textures[material.dTextureID], samplerAnisotropic), uv);
 	if(color.a < 0.1)
 	{
 		discard;
@@ -13,14 +13,17 @@ layout(set = 0, binding = 0) uniform SceneUniform
 	float farPlane;
 } ubo;
 
-layout(push_constant) uniform Push
+struct ObjectData
 {
-    mat4 ModelMatrix;
-    uint dTextureID; // diffuse 
-    uint mTextureID; // metalness
-    uint rTextureID; // roughness
-    uint eTextureID; // emissive
-}pc;
+	mat4 ModelMatrix;
+	uint materialIndex;
+};
+
+// Every object of the scene, the draw's firstInstance is the object's index
+layout(std430, set = 2, binding = 0) readonly buffer Objects
+{
+	ObjectData objects[];
+};
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 tex;
@@ -32,8 +35,9 @@ layout(location = 2) out vec4 WorldPosition;
 
 void main()
 {
+	ObjectData object = objects[gl_InstanceIndex];
 	WorldNormal = normal;
 	uv = tex;
-	WorldPosition = pc.ModelMatrix * vec4(position, 1.0);
-	gl_Position = ubo.view * pc.ModelMatrix * vec4(position, 1.0);
+	WorldPosition = object.ModelMatrix * vec4(position, 1.0);
+	gl_Position = ubo.view * object.ModelMatrix * vec4(position, 1.0);
 }
\ No newline at end of file
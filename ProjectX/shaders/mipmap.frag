@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec4 WorldPos;
 layout(location = 1) in vec2 uv;
@@ -23,18 +24,27 @@ layout(set = 0, binding = 1) uniform Light
 {
     vec4 LightPosition;
     vec4 LightColour;
-    mat4 LightSpaceMatrix;
 }lightubo;
 
-layout(push_constant) uniform Push
+layout(location = 6) flat in uint MaterialIndex;
+
+struct MaterialData
 {
-	mat4 ModelMatrix;
-	uint dTextureID; // diffuse 
+	uint dTextureID; // diffuse
 	uint mTextureID; // metalness
 	uint rTextureID; // roughness
-}pc;
+	uint eTextureID; // emissive
+	uint nTextureID; // normalMap
+};
+
+// Material table of the scene, indexed by the object's material
+layout(std430, set = 2, binding = 1) readonly buffer Materials
+{
+	MaterialData materials[];
+};
 
-layout(set = 0, binding = 2) uniform texture2D textures[200];
+// Bindless texture table shared by every pass, the material IDs are slots into it
+layout(set = 1, binding = 0) uniform texture2D textures[];
 layout(set = 0, binding = 3) uniform sampler samplerAnisotropic;
 layout(set = 0, binding = 4) uniform sampler samplerNormal;
 
@@ -54,10 +64,12 @@ const vec4 colors[10] = {
 
 void main()
 {
+    MaterialData material = materials[MaterialIndex];
+
     // get the LOD which would be used to sample from the texture
     // .y = "level of detail relative to base level is returned in y" - https://registry.khronos.org/OpenGL-Refpages/gl4/html/textureQueryLod.xhtml
-    vec2 loadInfo = textureQueryLod(sampler2D(textures[pc.dTextureID], samplerNormal), uv);
-    int numMips = textureQueryLevels(sampler2D(textures[pc.dTextureID], samplerNormal));
+    vec2 loadInfo = textureQueryLod(sampler2D(textures[material.dTextureID], samplerNormal), uv);
+    int numMips = textureQueryLevels(sampler2D(textures[material.dTextureID], samplerNormal));
 
     float lod = loadInfo.y; // mip level in use
     int index = int(floor(lod)); // get integer
@@ -1,35 +1,32 @@
 #version 450
 
-//layout(set = 0, binding = 0) uniform Light
-//{
-//	vec4 LightPosition;
-//	vec4 LightColour;
-//	mat4 LightSpaceMatrix;
-//}LightUBO;
-//
-//
-struct Light
-{
-	int Type;
-	vec4 LightPosition;
-	vec4 LightColour;
-	mat4 LightSpaceMatrix;
-};
+const int MAX_CASCADES = 4;
 
-const int NUM_LIGHTS = 16;
+// Cascades of the directional light, each drawn into its own layer of the shadow map
+layout(set = 0, binding = 0) uniform ShadowCascades
+{
+	mat4 viewProjections[MAX_CASCADES];
+	vec4 splits;
+	int count;
+	float depthBias;
+} cascades;
 
-layout(set = 0, binding = 0) uniform LightBuffer {
-	Light lights[NUM_LIGHTS];
-} lightData;
+layout(push_constant) uniform Cascade
+{
+	uint index;
+} cascade;
 
-layout(push_constant) uniform Push
+struct ObjectData
 {
 	mat4 ModelMatrix;
-	uint dTextureID; // diffuse 
-	uint mTextureID; // metalness
-	uint rTextureID; // roughness
-	uint eTextureID; // emissive
-}pc;
+	uint materialIndex;
+};
+
+// Every object of the scene, the draw's firstInstance is the object's index
+layout(std430, set = 2, binding = 0) readonly buffer Objects
+{
+	ObjectData objects[];
+};
 
 layout(location = 0) in vec3 pos;
 layout(location = 1) in vec2 tex;
@@ -38,5 +35,6 @@ layout(location = 3) in uvec3 compressedTBN;
 
 void main()
 {
-	gl_Position = lightData.lights[0].LightSpaceMatrix * pc.ModelMatrix * vec4(pos, 1.0);
+	ObjectData object = objects[gl_InstanceIndex];
+	gl_Position = cascades.viewProjections[cascade.index] * object.ModelMatrix * vec4(pos, 1.0);
 }